@@ -0,0 +1,10 @@
+#pragma once
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+void bind_image(py::module_ &module);
+void bind_filters(py::module_ &module);
+void bind_math(py::module_ &module);
+void bind_image_io(py::module_ &module);
@@ -0,0 +1,75 @@
+#include "bindings.h"
+
+#include <pybind11/stl.h>
+
+#include "filters.h"
+
+void bind_filters(py::module_ &module)
+{
+	using namespace vl::filters;
+	using namespace py::literals;
+	const py::call_guard<py::gil_scoped_release> releaseGil;
+
+	py::enum_<Shape>(module, "Shape")
+		.value("Rectangle", Shape::Rectangle)
+		.value("Circle", Shape::Circle)
+		.value("Octagon", Shape::Octagon);
+	module.def("to_shape", &to_shape, "shape"_a);
+
+	py::enum_<Connectivity>(module, "Connectivity")
+		.value("Four", Connectivity::Four)
+		.value("Eight", Connectivity::Eight);
+	module.def("to_connectivity", &to_connectivity, "connectivity"_a);
+
+	module.def("gaussian", &gaussian, "image"_a, "standard_deviation"_a, "kernel_size"_a, releaseGil);
+
+	module.def("median", &median, "image"_a, "size"_a, "shape"_a=Shape::Rectangle, releaseGil);
+	module.def("truncated_median", &truncated_median,
+		"image"_a, "size"_a, "std_dev_count"_a=2, "shape"_a=Shape::Rectangle, releaseGil);
+	module.def("hybrid_median", &hybrid_median, "image"_a, "size"_a, releaseGil);
+
+	module.def("erosion", &erosion, "image"_a, "shape"_a, "size"_a, releaseGil);
+	module.def("dilation", &dilation, "image"_a, "shape"_a, "size"_a, releaseGil);
+
+	module.def("reconstruction_by_dilation", &reconstruction_by_dilation,
+		"marker"_a, "mask"_a, "connectivity"_a=Connectivity::Eight, releaseGil);
+	module.def("reconstruction_by_erosion", &reconstruction_by_erosion,
+		"marker"_a, "mask"_a, "connectivity"_a=Connectivity::Eight, releaseGil);
+	module.def("opening_by_reconstruction", &opening_by_reconstruction,
+		"image"_a, "shape"_a, "size"_a, "connectivity"_a=Connectivity::Eight, releaseGil);
+	module.def("closing_by_reconstruction", &closing_by_reconstruction,
+		"image"_a, "shape"_a, "size"_a, "connectivity"_a=Connectivity::Eight, releaseGil);
+	module.def("fill_holes", &fill_holes, "image"_a, "connectivity"_a=Connectivity::Eight, releaseGil);
+	module.def("regional_maxima", &regional_maxima, "image"_a, "connectivity"_a=Connectivity::Eight, releaseGil);
+	module.def("regional_minima", &regional_minima, "image"_a, "connectivity"_a=Connectivity::Eight, releaseGil);
+
+	module.def("distance_transform", &distance_transform, "image"_a, "threshold"_a=128, releaseGil);
+	module.def("binary_erosion", &binary_erosion, "image"_a, "radius"_a, "threshold"_a=128, releaseGil);
+	module.def("binary_dilation", &binary_dilation, "image"_a, "radius"_a, "threshold"_a=128, releaseGil);
+
+	module.def("top_hat", &top_hat,
+		"image"_a, "inner_radius"_a, "outer_radius"_a, "threshold"_a, "dark"_a=true, releaseGil);
+	module.def("rolling_ball", &rolling_ball,
+		"image"_a, "inner_radius"_a, "outer_radius"_a, "threshold"_a, "dark"_a=true, releaseGil);
+
+	module.def("variance", &variance, "image"_a, "size"_a, releaseGil);
+	module.def("kuwahara", &kuwahara, "image"_a, "radius"_a, releaseGil);
+
+	module.def("horizontal_edges", &horizontal_edges, "image"_a, releaseGil);
+	module.def("vertical_edges", &vertical_edges, "image"_a, releaseGil);
+	module.def("roberts_cross", &roberts_cross, "image"_a, releaseGil);
+	module.def("sobel", &sobel, "image"_a, releaseGil);
+	module.def("canny", &canny, "image"_a, "low_threshold"_a, "high_threshold"_a, releaseGil);
+
+	module.def("unsharp_mask", &unsharp_mask, "image"_a, "standard_deviation"_a, "amount"_a, releaseGil);
+	module.def("difference_of_gaussians", &difference_of_gaussians,
+		"image"_a, "small_standard_deviation"_a, "large_standard_deviation"_a, releaseGil);
+	module.def("laplacian", &laplacian, "image"_a, "standard_deviation"_a, releaseGil);
+
+	module.def("histogram_equalization", &histogram_equalization, "image"_a, releaseGil);
+	module.def("transfer_function", &transfer_function, "image"_a, "transfer"_a, releaseGil);
+	module.def("local_histogram_equalization", &local_histogram_equalization,
+		"image"_a, "tile_size"_a=64, "clip_limit"_a=2., releaseGil);
+
+	module.def("piecewise_linear_transfer", &impl::piecewise_linear_transfer, "points"_a);
+}
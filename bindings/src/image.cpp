@@ -0,0 +1,145 @@
+#include "bindings.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/operators.h>
+
+#include <fmt/format.h>
+
+#include "image.h"
+#include "operations.h"
+
+namespace
+{
+	vl::PixelFormat to_pixel_format(const py::array &array)
+	{
+		if (py::isinstance<py::array_t<std::uint16_t>>(array) && array.ndim() == 2)
+			return vl::PixelFormat::Grayscale16;
+		if (!py::isinstance<py::array_t<vl::byte>>(array))
+			throw std::invalid_argument{fmt::format("Unsupported array dtype: {}",
+				py::str(array.dtype()).cast<std::string>())};
+
+		if (array.ndim() == 2)
+			return vl::PixelFormat::Grayscale8;
+		if (array.ndim() == 3 && array.shape(2) == 3)
+			return vl::PixelFormat::RGB8;
+		if (array.ndim() == 3 && array.shape(2) == 4)
+			return vl::PixelFormat::RGBA8;
+
+		throw std::invalid_argument{"Array must have shape (height, width) or (height, width, 3|4)"};
+	}
+
+	vl::Image view_array(py::array &array)
+	{
+		const auto format{to_pixel_format(array)};
+		if (!(array.flags() & py::array::c_style))
+			throw std::invalid_argument{"Array must be C contiguous to be shared with an image"};
+		if (!array.writeable())
+			throw std::invalid_argument{"Array must be writeable to be shared with an image"};
+
+		auto *data{static_cast<vl::byte *>(array.mutable_data())};
+		return vl::Image::view({data, (std::size_t)array.nbytes()}, array.shape(1), array.shape(0), format);
+	}
+
+	template<auto Operation>
+	py::object in_place(py::object self, const vl::Image &other)
+	{
+		auto &image{self.cast<vl::Image &>()};
+		{
+			py::gil_scoped_release release;
+			Operation(image, other);
+		}
+
+		return self;
+	}
+
+	void check_divisor(const vl::Image &image, const vl::Image &divisor)
+	{
+		vl::impl::check_for_operation(image, divisor);
+		if (std::find(divisor.begin(), divisor.end(), 0) != divisor.end())
+		{
+			PyErr_SetString(PyExc_ZeroDivisionError, "Image division by a zero pixel");
+			throw py::error_already_set{};
+		}
+	}
+
+	py::buffer_info image_buffer(vl::Image &image)
+	{
+		const auto height{(py::ssize_t)image.height()};
+		const auto width{(py::ssize_t)image.width()};
+		switch (image.format())
+		{
+			case vl::PixelFormat::Grayscale16:
+				return py::buffer_info{image.begin(), sizeof(std::uint16_t),
+					py::format_descriptor<std::uint16_t>::format(), 2,
+					{height, width}, {width * 2, 2}};
+			case vl::PixelFormat::Grayscale8:
+				return py::buffer_info{image.begin(), 1, py::format_descriptor<vl::byte>::format(), 2,
+					{height, width}, {width, 1}};
+			default:
+			{
+				const auto channels{(py::ssize_t)image.pixel_size()};
+				return py::buffer_info{image.begin(), 1, py::format_descriptor<vl::byte>::format(), 3,
+					{height, width, channels}, {width * channels, channels, 1}};
+			}
+		}
+	}
+}
+
+void bind_image(py::module_ &module)
+{
+	py::enum_<vl::PixelFormat>(module, "PixelFormat")
+		.value("Grayscale8", vl::PixelFormat::Grayscale8)
+		.value("Grayscale16", vl::PixelFormat::Grayscale16)
+		.value("RGB8", vl::PixelFormat::RGB8)
+		.value("RGBA8", vl::PixelFormat::RGBA8);
+
+	py::class_<vl::Image>(module, "Image", py::buffer_protocol(),
+		"Image sharing memory with NumPy: Image(array) wraps the array without copying "
+		"and numpy.asarray(image) exposes image pixels without copying. "
+		"A view keeps writing to the array only while its size and format stay the same: "
+		"an operation that replaces the image with one of a different shape or format "
+		"moves it to its own memory, is_view becomes False and the array no longer sees changes")
+		.def(py::init<std::size_t, std::size_t, vl::PixelFormat>(),
+			py::arg("width"), py::arg("height"), py::arg("format")=vl::PixelFormat::Grayscale8)
+		.def(py::init([](py::array array){ return view_array(array); }),
+			py::arg("array"), py::keep_alive<1, 2>())
+		.def_buffer(&image_buffer)
+		.def_property_readonly("width", &vl::Image::width)
+		.def_property_readonly("height", &vl::Image::height)
+		.def_property_readonly("format", &vl::Image::format)
+		.def_property_readonly("pixel_size", &vl::Image::pixel_size)
+		.def_property_readonly("is_view", &vl::Image::is_view)
+		.def("__len__", &vl::Image::size)
+		.def("__copy__", [](const vl::Image &image){ return vl::Image{image}; })
+		.def("__deepcopy__", [](const vl::Image &image, py::dict){ return vl::Image{image}; })
+		.def(py::self + py::self, py::call_guard<py::gil_scoped_release>())
+		.def(py::self - py::self, py::call_guard<py::gil_scoped_release>())
+		.def(py::self * py::self, py::call_guard<py::gil_scoped_release>())
+		.def("__truediv__", [](const vl::Image &image, const vl::Image &other)
+		{
+			check_divisor(image, other);
+			py::gil_scoped_release release;
+			return image / other;
+		})
+		.def("__iadd__", in_place<[](vl::Image &image, const vl::Image &other){ image += other; }>)
+		.def("__isub__", in_place<[](vl::Image &image, const vl::Image &other){ image -= other; }>)
+		.def("__imul__", in_place<[](vl::Image &image, const vl::Image &other){ image *= other; }>)
+		.def("__itruediv__", [](py::object self, const vl::Image &other)
+		{
+			check_divisor(self.cast<const vl::Image &>(), other);
+			return in_place<[](vl::Image &image, const vl::Image &other){ image /= other; }>(self, other);
+		})
+		.def("__repr__", [](const vl::Image &image)
+		{
+			return fmt::format("<Image {}x{}x{}{}>", image.width(), image.height(), image.pixel_size(),
+				image.is_view() ? " view" : "");
+		});
+
+	py::implicitly_convertible<py::array, vl::Image>();
+}
@@ -0,0 +1,95 @@
+#include "bindings.h"
+
+#include <expected>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <pybind11/stl.h>
+
+#include "image_io.h"
+
+namespace
+{
+	template<typename Error>
+	[[noreturn]] void raise_error(const Error &error)
+	{
+		PyErr_SetString(error.type == vl::ImageIO::ErrorType::IOError ? PyExc_OSError : PyExc_ValueError,
+			error.description.c_str());
+		throw py::error_already_set{};
+	}
+
+	template<typename T, typename Error>
+	T value_or_raise(std::expected<T, Error> &&result)
+	{
+		if (!result)
+			raise_error(result.error());
+
+		if constexpr (!std::is_void_v<T>)
+			return std::move(*result);
+	}
+
+	template<auto Function, typename... Args>
+	auto call_without_gil(Args &&...args)
+	{
+		auto result{[&]
+		{
+			py::gil_scoped_release release;
+			return Function(std::forward<Args>(args)...);
+		}()};
+
+		return value_or_raise(std::move(result));
+	}
+}
+
+void bind_image_io(py::module_ &module)
+{
+	using namespace vl::ImageIO;
+	using namespace py::literals;
+
+	py::enum_<ColorMode>(module, "ColorMode")
+		.value("Native", ColorMode::Native)
+		.value("Grayscale", ColorMode::Grayscale);
+
+	py::class_<TiledOptions>(module, "TiledOptions")
+		.def(py::init<>())
+		.def_readwrite("tile_width", &TiledOptions::tileWidth)
+		.def_readwrite("tile_height", &TiledOptions::tileHeight)
+		.def_readwrite("compression_level", &TiledOptions::compressionLevel);
+
+	module.def("read_png", [](const std::string &path, ColorMode mode)
+	{
+		return call_without_gil<read_png>(path, mode);
+	}, "path"_a, "mode"_a=ColorMode::Grayscale);
+	module.def("write_png", [](const vl::Image &image, const std::string &path)
+	{
+		call_without_gil<write_png>(image, path);
+	}, "image"_a, "path"_a);
+
+	module.def("decode_png", [](py::buffer buffer, ColorMode mode)
+	{
+		const auto info{buffer.request()};
+		const std::span bytes{static_cast<const vl::byte *>(info.ptr), (std::size_t)(info.size * info.itemsize)};
+		return call_without_gil<decode_png>(bytes, mode);
+	}, "buffer"_a, "mode"_a=ColorMode::Grayscale);
+	module.def("encode_png", [](const vl::Image &image)
+	{
+		const auto encoded{call_without_gil<encode_png>(image)};
+		return py::bytes{reinterpret_cast<const char *>(encoded.data()), encoded.size()};
+	}, "image"_a);
+
+	module.def("read_tiled", [](const std::string &path)
+	{
+		return call_without_gil<read_tiled>(path);
+	}, "path"_a);
+	module.def("read_region", [](const std::string &path, std::size_t x, std::size_t y,
+		std::size_t width, std::size_t height)
+	{
+		return call_without_gil<read_region>(path, x, y, width, height);
+	}, "path"_a, "x"_a, "y"_a, "width"_a, "height"_a);
+	module.def("write_tiled", [](const vl::Image &image, const std::string &path, const TiledOptions &options)
+	{
+		call_without_gil<write_tiled>(image, path, options);
+	}, "image"_a, "path"_a, "options"_a=TiledOptions{});
+}
@@ -0,0 +1,127 @@
+#include "bindings.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/operators.h>
+#include <pybind11/stl.h>
+
+#include "math.h"
+
+namespace
+{
+	using DoubleArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+	vl::math::Matrix<double> to_matrix(const DoubleArray &array)
+	{
+		if (array.ndim() != 2)
+			throw std::invalid_argument{"Matrix array must be two dimensional"};
+
+		vl::math::Matrix<double> matrix(array.shape(0), array.shape(1));
+		std::copy_n(array.data(), array.size(), matrix.begin());
+		return matrix;
+	}
+
+	template<typename T>
+	py::array_t<T> adopt_vector(std::vector<T> &&values, std::vector<py::ssize_t> shape)
+	{
+		auto *owned{new std::vector<T>{std::move(values)}};
+		py::capsule release{owned, [](void *pointer){ delete static_cast<std::vector<T> *>(pointer); }};
+		return py::array_t<T>{shape, owned->data(), release};
+	}
+}
+
+void bind_math(py::module_ &module)
+{
+	using namespace vl::math;
+	using namespace py::literals;
+	const py::call_guard<py::gil_scoped_release> releaseGil;
+
+	py::class_<Matrix<double>>(module, "Matrix", py::buffer_protocol())
+		.def(py::init<std::size_t, std::size_t>(), "rows"_a, "cols"_a)
+		.def(py::init(&to_matrix), "array"_a)
+		.def_buffer([](Matrix<double> &matrix)
+		{
+			return py::buffer_info{matrix.begin(), {(py::ssize_t)matrix.rows(), (py::ssize_t)matrix.cols()},
+				{(py::ssize_t)(matrix.cols() * sizeof(double)), (py::ssize_t)sizeof(double)}};
+		})
+		.def_property_readonly("rows", &Matrix<double>::rows)
+		.def_property_readonly("cols", &Matrix<double>::cols);
+	py::implicitly_convertible<py::array, Matrix<double>>();
+
+	module.def("solve", &solve, "coefficients"_a, "constants"_a, releaseGil);
+
+	py::class_<Histogram>(module, "Histogram")
+		.def(py::init<>())
+		.def(py::init<const vl::Image &>(), "image"_a, releaseGil)
+		.def(py::init<const vl::Image &, std::size_t, std::size_t, std::size_t, std::size_t>(),
+			"image"_a, "x"_a, "y"_a, "width"_a, "height"_a, releaseGil)
+		.def("__getitem__", [](const Histogram &histogram, std::size_t bin)
+		{
+			if (bin >= Histogram::Bins)
+				throw py::index_error{};
+			return histogram[bin];
+		})
+		.def("__len__", [](const Histogram &){ return Histogram::Bins; })
+		.def_property_readonly("bins", [](const Histogram &histogram)
+		{
+			return py::array_t<std::size_t>(Histogram::Bins, histogram.bins().data());
+		})
+		.def_property_readonly("count", &Histogram::count)
+		.def(py::self += py::self)
+		.def("mean", &Histogram::mean)
+		.def("std_dev", &Histogram::std_dev)
+		.def("entropy", &Histogram::entropy)
+		.def("signal_to_noise_ratio", &Histogram::signal_to_noise_ratio)
+		.def("percentile", &Histogram::percentile, "percent"_a)
+		.def("equalization_lut", &Histogram::equalization_lut);
+
+	py::class_<IntegralImage>(module, "IntegralImage")
+		.def(py::init<const vl::Image &>(), "image"_a, releaseGil)
+		.def_property_readonly("width", &IntegralImage::width)
+		.def_property_readonly("height", &IntegralImage::height)
+		.def("box_sum", &IntegralImage::box_sum, "x"_a, "y"_a, "width"_a, "height"_a)
+		.def("box_squared_sum", &IntegralImage::box_squared_sum, "x"_a, "y"_a, "width"_a, "height"_a)
+		.def("box_mean", &IntegralImage::box_mean, "x"_a, "y"_a, "width"_a, "height"_a)
+		.def("box_variance", &IntegralImage::box_variance, "x"_a, "y"_a, "width"_a, "height"_a);
+
+	py::class_<Statistics>(module, "Statistics")
+		.def(py::init<>())
+		.def_readonly("count", &Statistics::count)
+		.def_readonly("min", &Statistics::min)
+		.def_readonly("max", &Statistics::max)
+		.def_readonly("sum", &Statistics::sum)
+		.def_readonly("sum_of_squares", &Statistics::sumOfSquares)
+		.def_readonly("mean", &Statistics::mean)
+		.def_readonly("std_dev", &Statistics::stdDev)
+		.def(py::self += py::self);
+
+	module.def("statistics", py::overload_cast<const vl::Image &>(&statistics), "image"_a, releaseGil);
+	module.def("statistics",
+		py::overload_cast<const vl::Image &, std::size_t, std::size_t, std::size_t, std::size_t>(&statistics),
+		"image"_a, "x"_a, "y"_a, "width"_a, "height"_a, releaseGil);
+
+	module.def("entropy", &entropy, "image"_a, releaseGil);
+	module.def("signal_to_noise_ratio", &signal_to_noise_ratio, "image"_a, releaseGil);
+
+	module.def("squared_distance_transform", [](const vl::Image &image, vl::byte threshold, bool toBackground)
+	{
+		std::vector<std::uint32_t> distances;
+		{
+			py::gil_scoped_release release;
+			distances = squared_distance_transform(image, threshold, toBackground);
+		}
+		return adopt_vector(std::move(distances), {(py::ssize_t)image.height(), (py::ssize_t)image.width()});
+	}, "image"_a, "threshold"_a=128, "to_background"_a=false);
+
+	module.def("get_mean_std_dev", [](const vl::Image &image)
+	{
+		return get_mean_std_dev(image.cbegin(), image.cend());
+	}, "image"_a, releaseGil);
+	module.def("get_mean_std_dev", [](const DoubleArray &values)
+	{
+		return get_mean_std_dev(values.data(), values.data() + values.size());
+	}, "values"_a);
+}
@@ -0,0 +1,17 @@
+#include "bindings.h"
+
+PYBIND11_MODULE(libvision, module)
+{
+	module.doc() = "LibVision image processing";
+
+	bind_image(module);
+
+	auto filters{module.def_submodule("filters", "In-place image filters")};
+	bind_filters(filters);
+
+	auto math{module.def_submodule("math", "Image statistics and linear algebra")};
+	bind_math(math);
+
+	auto imageIO{module.def_submodule("io", "PNG and tiled image IO")};
+	bind_image_io(imageIO);
+}
@@ -0,0 +1,1041 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "async_io.h"
+#include "color.h"
+#include "components.h"
+#include "cpu.h"
+#include "filters.h"
+#include "image_io.h"
+#include "lut.h"
+#include "math.h"
+#include "operations.h"
+#include "parallel.h"
+#include "planar.h"
+#include "pyramid.h"
+#include "reference.h"
+#include "scale_space.h"
+#include "stacker.h"
+#include "transform.h"
+
+constexpr std::size_t Iterations{4};
+constexpr std::array<std::size_t, 4> ThreadCounts{1, 2, 3, 5};
+
+constexpr int FloatRoundingTolerance{1};
+constexpr double CoordinateTieOutliers{0.002};
+
+class Checker
+{
+public:
+	void set_context(std::string context)
+	{
+		m_context = std::move(context);
+	}
+
+	void expect(bool condition, const std::string &what)
+	{
+		++m_checks;
+		if (condition)
+			return;
+
+		++m_failures;
+		fmt::println("FAILED {} [{}]", what, m_context);
+	}
+
+	void compare(const vl::Image &expected, const vl::Image &actual, const std::string &what,
+		int tolerance=0, double outliersFraction=0)
+	{
+		++m_checks;
+		if (expected.width() != actual.width() || expected.height() != actual.height()
+			|| expected.format() != actual.format())
+		{
+			++m_failures;
+			fmt::println("FAILED {}: expected {}x{} image, got {}x{} [{}]", what,
+				expected.width(), expected.height(), actual.width(), actual.height(), m_context);
+			return;
+		}
+
+		std::size_t outliers{0};
+		std::size_t firstOutlier{0};
+		int maxDifference{0};
+		for (std::size_t i = 0; i < expected.size(); ++i)
+		{
+			const int difference{std::abs(expected.begin()[i] - actual.begin()[i])};
+			maxDifference = std::max(maxDifference, difference);
+			if (difference > tolerance && outliers++ == 0)
+				firstOutlier = i;
+		}
+
+		if (outliers <= outliersFraction * expected.size())
+			return;
+
+		++m_failures;
+		const std::size_t pixel{firstOutlier / expected.pixel_size()};
+		fmt::println("FAILED {}: {} values differ by more than {}, max difference {}, first at {}x{} "
+			"expected {} got {} [{}]", what, outliers, tolerance, maxDifference,
+			pixel % expected.width(), pixel / expected.width(),
+			expected.begin()[firstOutlier], actual.begin()[firstOutlier], m_context);
+	}
+
+	std::size_t checks() const
+	{
+		return m_checks;
+	}
+
+	std::size_t failures() const
+	{
+		return m_failures;
+	}
+
+private:
+	std::string m_context;
+	std::size_t m_checks{0};
+	std::size_t m_failures{0};
+};
+
+std::size_t random_size(std::mt19937 &random, std::size_t min, std::size_t max)
+{
+	return std::uniform_int_distribution<std::size_t>{min, max}(random);
+}
+
+vl::Image random_image(std::mt19937 &random, std::size_t width, std::size_t height,
+	vl::PixelFormat format=vl::PixelFormat::Grayscale8)
+{
+	vl::Image image{width, height, format};
+	std::uniform_int_distribution<int> values{0, 255};
+	switch (random_size(random, 0, 2))
+	{
+		case 0:
+			for (auto &value : image)
+				value = values(random);
+			break;
+		case 1:
+		{
+			const std::size_t block{random_size(random, 2, 9)};
+			const std::size_t stride{width * image.pixel_size()};
+			for (std::size_t i = 0; i < image.size(); ++i)
+			{
+				const std::size_t x{i % stride / image.pixel_size()};
+				const std::size_t y{i / stride};
+				image.begin()[i] = (x / block + y / block) % 2 ? 200 + values(random) % 40 : 20 + values(random) % 40;
+			}
+			break;
+		}
+		default:
+			for (std::size_t i = 0; i < image.size(); ++i)
+				image.begin()[i] = (i * 7 + values(random) % 16) % 256;
+			break;
+	}
+
+	return image;
+}
+
+void for_thread_counts(const std::function<void(std::size_t)> &body)
+{
+	for (const std::size_t threads : ThreadCounts)
+	{
+		vl::parallel::set_thread_count(threads);
+		body(threads);
+	}
+	vl::parallel::set_thread_count(ThreadCounts.back());
+}
+
+void test_scalar_filters(Checker &checker, std::mt19937 &random)
+{
+	using vl::filters::Shape;
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const std::size_t size{random_size(random, 1, 3) * 2 + 1};
+		const Shape shape{static_cast<Shape>(random_size(random, 0, 2))};
+		const vl::Image source{random_image(random, random_size(random, size + 1, 40), random_size(random, size + 1, 40))};
+		const double sigma{0.5 + random_size(random, 0, 20) / 10.};
+		checker.set_context(fmt::format("{}x{} size {} shape {} sigma {}", source.width(), source.height(),
+			size, static_cast<int>(shape), sigma));
+
+		const auto check{[&](const std::string &name, auto &&optimized, auto &&reference)
+		{
+			vl::Image expected{source};
+			reference(expected);
+			for_thread_counts([&](std::size_t threads)
+			{
+				vl::Image actual{source};
+				optimized(actual);
+				checker.compare(expected, actual, fmt::format("{} with {} threads", name, threads));
+			});
+		}};
+
+		check("gaussian", [&](vl::Image &image){ vl::filters::gaussian(image, sigma, size); },
+			[&](vl::Image &image){ vl::reference::gaussian(image, sigma, size); });
+		check("median", [&](vl::Image &image){ vl::filters::median(image, size, shape); },
+			[&](vl::Image &image){ vl::reference::median(image, size, shape); });
+		check("hybrid median", [&](vl::Image &image){ vl::filters::hybrid_median(image, size); },
+			[&](vl::Image &image){ vl::reference::hybrid_median(image, size); });
+		check("erosion", [&](vl::Image &image){ vl::filters::erosion(image, shape, size); },
+			[&](vl::Image &image){ vl::reference::erosion(image, shape, size); });
+		check("dilation", [&](vl::Image &image){ vl::filters::dilation(image, shape, size); },
+			[&](vl::Image &image){ vl::reference::dilation(image, shape, size); });
+	}
+}
+
+void test_arithmetic(Checker &checker, std::mt19937 &random)
+{
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const std::size_t width{random_size(random, 1, 70)};
+		const std::size_t height{random_size(random, 1, 30)};
+		const auto format{std::array{vl::PixelFormat::Grayscale8, vl::PixelFormat::RGB8, vl::PixelFormat::RGBA8}[random_size(random, 0, 2)]};
+		const vl::Image left{random_image(random, width, height, format)};
+		vl::Image right{random_image(random, width, height, format)};
+		for (auto &value : right)
+			value |= 1;
+		checker.set_context(fmt::format("{}x{} format {}", width, height, static_cast<int>(format)));
+
+		const auto check{[&](const std::string &name, auto &&optimized, auto &&reference)
+		{
+			vl::Image expected{left};
+			reference(expected, right);
+			for_thread_counts([&](std::size_t threads)
+			{
+				vl::Image actual{left};
+				optimized(actual, right);
+				checker.compare(expected, actual, fmt::format("{} with {} threads", name, threads));
+			});
+		}};
+
+		check("add", [](vl::Image &image, const vl::Image &other){ image += other; }, vl::reference::add);
+		check("subtract", [](vl::Image &image, const vl::Image &other){ image -= other; }, vl::reference::subtract);
+		check("multiply", [](vl::Image &image, const vl::Image &other){ image *= other; }, vl::reference::multiply);
+		check("divide", [](vl::Image &image, const vl::Image &other){ image /= other; }, vl::reference::divide);
+		check("add copy", [](vl::Image &image, const vl::Image &other){ image = image + other; }, vl::reference::add);
+		check("divide copy", [](vl::Image &image, const vl::Image &other){ image = image / other; }, vl::reference::divide);
+	}
+
+	vl::Image wide{4, 4, vl::PixelFormat::Grayscale16};
+	bool rejected{false};
+	try
+	{
+		wide += wide;
+	}
+	catch (const std::logic_error &)
+	{
+		rejected = true;
+	}
+	checker.expect(rejected, "16-bit arithmetic is rejected");
+}
+
+void test_lut(Checker &checker, std::mt19937 &random)
+{
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		std::array<vl::byte, 256> first;
+		std::array<vl::byte, 256> second;
+		for (std::size_t value = 0; value < first.size(); ++value)
+		{
+			first[value] = random();
+			second[value] = random();
+		}
+
+		const auto format{static_cast<vl::PixelFormat>(std::array{0, 2, 3}[random_size(random, 0, 2)])};
+		const vl::Image source{random_image(random, random_size(random, 1, 200), random_size(random, 1, 20), format)};
+		checker.set_context(fmt::format("{}x{}x{}", source.width(), source.height(), source.channels()));
+
+		vl::Image expected{source};
+		vl::reference::lut(expected, first);
+		vl::reference::lut(expected, second);
+		for_thread_counts([&](std::size_t threads)
+		{
+			vl::Image sequential{source};
+			vl::Lut{first}.apply(sequential);
+			vl::Lut{second}.apply(sequential);
+			checker.compare(expected, sequential, fmt::format("lut with {} threads", threads));
+
+			vl::Image composed{source};
+			vl::LutPipeline{}.add(vl::Lut{first}).add(vl::Lut{second}).apply(composed);
+			checker.compare(expected, composed, fmt::format("lut pipeline with {} threads", threads));
+		});
+
+		const std::size_t offset{random_size(random, 0, 63)};
+		const std::size_t count{random_size(random, 0, 300)};
+		std::vector<vl::byte> row(offset + count);
+		for (auto &value : row)
+			value = random();
+		std::vector<vl::byte> mapped(row.size());
+		vl::Lut{first}.apply_row(row.data() + offset, mapped.data() + offset, count);
+		bool matches{true};
+		for (std::size_t i = offset; i < row.size(); ++i)
+			matches = matches && mapped[i] == first[row[i]];
+		checker.expect(matches, fmt::format("lut row of {} values at offset {}", count, offset));
+	}
+}
+
+void test_statistics(Checker &checker, std::mt19937 &random)
+{
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const vl::Image image{random_image(random, random_size(random, 1, 90), random_size(random, 1, 90))};
+		const std::size_t x{random_size(random, 0, image.width() - 1)};
+		const std::size_t y{random_size(random, 0, image.height() - 1)};
+		const std::size_t width{random_size(random, 1, image.width() - x)};
+		const std::size_t height{random_size(random, 1, image.height() - y)};
+		checker.set_context(fmt::format("{}x{} region {}x{}+{}+{}", image.width(), image.height(), width, height, x, y));
+
+		const auto expected{vl::reference::histogram(image, x, y, width, height)};
+		double sum{0};
+		double sumOfSquares{0};
+		for (std::size_t bin = 0; bin < expected.size(); ++bin)
+		{
+			sum += (double)bin * expected[bin];
+			sumOfSquares += (double)bin * bin * expected[bin];
+		}
+		const std::size_t count{width * height};
+		const double mean{sum / count};
+		const double stdDev{std::sqrt(std::max(sumOfSquares / count - mean * mean, 0.))};
+		const auto firstUsed{std::ranges::find_if(expected, [](std::size_t frequency){ return frequency != 0; })};
+		const auto lastUsed{std::ranges::find_if(expected.rbegin(), expected.rend(), [](std::size_t frequency){ return frequency != 0; })};
+
+		for_thread_counts([&](std::size_t threads)
+		{
+			const vl::math::Histogram histogram{image, x, y, width, height};
+			checker.expect(histogram.bins() == expected && histogram.count() == count,
+				fmt::format("histogram with {} threads", threads));
+
+			const auto statistics{vl::math::statistics(image, x, y, width, height)};
+			checker.expect(statistics.count == count && statistics.sum == sum && statistics.sumOfSquares == sumOfSquares
+				&& statistics.min == firstUsed - expected.begin() && statistics.max == expected.rend() - lastUsed - 1,
+				fmt::format("statistics sums and extremes with {} threads", threads));
+			checker.expect(std::abs(statistics.mean - mean) < 1e-9 && std::abs(statistics.stdDev - stdDev) < 1e-6,
+				fmt::format("statistics moments with {} threads", threads));
+
+			const vl::math::IntegralImage integral{image};
+			std::uint64_t boxSum{0};
+			for (std::size_t row = y; row < y + height; ++row)
+				for (std::size_t column = x; column < x + width; ++column)
+					boxSum += image[column, row];
+			checker.expect(integral.box_sum(x, y, width, height) == boxSum,
+				fmt::format("integral image box sum with {} threads", threads));
+		});
+	}
+}
+
+void test_window_filters(Checker &checker, std::mt19937 &random)
+{
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const std::size_t size{random_size(random, 1, 4) * 2 + 1};
+		const vl::Image source{random_image(random, random_size(random, size + 1, 50), random_size(random, size + 1, 50))};
+		checker.set_context(fmt::format("{}x{} size {}", source.width(), source.height(), size));
+
+		vl::Image expectedVariance{source};
+		vl::reference::variance(expectedVariance, size);
+		vl::Image expectedKuwahara{source};
+		vl::reference::kuwahara(expectedKuwahara, size / 2);
+		for_thread_counts([&](std::size_t threads)
+		{
+			vl::Image variance{source};
+			vl::filters::variance(variance, size);
+			checker.compare(expectedVariance, variance, fmt::format("variance with {} threads", threads));
+
+			vl::Image kuwahara{source};
+			vl::filters::kuwahara(kuwahara, size / 2);
+			checker.compare(expectedKuwahara, kuwahara, fmt::format("kuwahara with {} threads", threads));
+		});
+	}
+}
+
+void test_edges(Checker &checker, std::mt19937 &random)
+{
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const vl::Image source{random_image(random, random_size(random, 2, 60), random_size(random, 2, 60))};
+		checker.set_context(fmt::format("{}x{}", source.width(), source.height()));
+
+		const auto check{[&](const std::string &name, auto &&optimized, auto &&reference)
+		{
+			vl::Image expected{source};
+			reference(expected);
+			for_thread_counts([&](std::size_t threads)
+			{
+				vl::Image actual{source};
+				optimized(actual);
+				checker.compare(expected, actual, fmt::format("{} with {} threads", name, threads));
+			});
+		}};
+
+		check("horizontal edges", vl::filters::horizontal_edges, vl::reference::horizontal_edges);
+		check("vertical edges", vl::filters::vertical_edges, vl::reference::vertical_edges);
+		check("sobel", vl::filters::sobel, vl::reference::sobel);
+		check("roberts cross", vl::filters::roberts_cross, vl::reference::roberts_cross);
+
+		vl::parallel::set_thread_count(1);
+		vl::Image singleThreaded{source};
+		vl::filters::canny(singleThreaded, 40, 120);
+		checker.expect(std::ranges::all_of(singleThreaded, [](vl::byte value){ return value == 0 || value == 255; }),
+			"canny output is binary");
+		check("canny", [](vl::Image &image){ vl::filters::canny(image, 40, 120); },
+			[&](vl::Image &image){ image = singleThreaded; });
+	}
+}
+
+vl::Image crop(const vl::Image &image, std::size_t margin)
+{
+	const std::size_t width{image.width() - 2 * margin};
+	const std::size_t height{image.height() - 2 * margin};
+	vl::Image cropped{width, height, image.format()};
+	for (std::size_t y = 0; y < height; ++y)
+		std::copy_n(image.row(y + margin) + margin * image.pixel_size(), width * image.pixel_size(), cropped.row(y));
+
+	return cropped;
+}
+
+void test_scale_space(Checker &checker, std::mt19937 &random)
+{
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const double sigma{0.4 + random_size(random, 0, 25) / 10.};
+		const std::size_t margin = std::ceil(sigma * 6);
+		const vl::Image source{random_image(random, random_size(random, 1, 30) + 2 * margin,
+			random_size(random, 1, 30) + 2 * margin)};
+		checker.set_context(fmt::format("{}x{} sigma {}", source.width(), source.height(), sigma));
+
+		const vl::Image expected{vl::reference::gaussian_blur(source, sigma)};
+		for_thread_counts([&](std::size_t threads)
+		{
+			checker.compare(expected, vl::impl::gaussian_blur(source, sigma),
+				fmt::format("separable gaussian blur with {} threads", threads), FloatRoundingTolerance);
+
+			vl::ScaleSpace scaleSpace{source};
+			scaleSpace.level(sigma / 2);
+			checker.compare(crop(expected, margin), crop(scaleSpace.level(sigma), margin),
+				fmt::format("incremental scale space level interior with {} threads", threads), FloatRoundingTolerance);
+		});
+	}
+}
+
+void test_transforms(Checker &checker, std::mt19937 &random)
+{
+	using vl::transform::Interpolation;
+	std::uniform_real_distribution<double> coordinates{-0.3, 1.3};
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const auto format{random_size(random, 0, 1) ? vl::PixelFormat::Grayscale8 : vl::PixelFormat::RGB8};
+		const vl::Image source{random_image(random, random_size(random, 4, 50), random_size(random, 4, 50), format)};
+		const double width = source.width();
+		const double height = source.height();
+
+		const auto halfPixel{vl::transform::AffineTransform::from_points({{{0, 0}, {1, 0}, {0, 1}}},
+			{{{0.5, 0.5}, {1.5, 0.5}, {0.5, 1.5}}})};
+		checker.set_context(fmt::format("{}x{} format {} half pixel shift", source.width(), source.height(),
+			static_cast<int>(format)));
+		checker.compare(vl::reference::warp_affine(source, *halfPixel, source.width(), source.height(), Interpolation::Nearest),
+			vl::transform::warp_affine(source, *halfPixel, source.width(), source.height(), Interpolation::Nearest),
+			"warp affine nearest half pixel shift", 0, CoordinateTieOutliers);
+
+		std::array<vl::transform::Point, 3> from;
+		std::array<vl::transform::Point, 3> to;
+		for (std::size_t i = 0; i < from.size(); ++i)
+		{
+			from[i] = {coordinates(random) * width, coordinates(random) * height};
+			to[i] = {coordinates(random) * width, coordinates(random) * height};
+		}
+		const auto transform{vl::transform::AffineTransform::from_points(from, to)};
+		if (!transform || !transform->inverse())
+			continue;
+
+		const std::size_t outputWidth{random_size(random, 1, 60)};
+		const std::size_t outputHeight{random_size(random, 1, 60)};
+		checker.set_context(fmt::format("{}x{} format {} to {}x{}", source.width(), source.height(),
+			static_cast<int>(format), outputWidth, outputHeight));
+
+		for (const auto interpolation : {Interpolation::Nearest, Interpolation::Bilinear, Interpolation::Bicubic})
+		{
+			const vl::Image expected{vl::reference::warp_affine(source, *transform, outputWidth, outputHeight, interpolation)};
+			for_thread_counts([&](std::size_t threads)
+			{
+				checker.compare(expected, vl::transform::warp_affine(source, *transform, outputWidth, outputHeight, interpolation),
+					fmt::format("warp affine {} with {} threads", static_cast<int>(interpolation), threads),
+					interpolation == Interpolation::Nearest ? 0 : FloatRoundingTolerance, CoordinateTieOutliers);
+			});
+		}
+	}
+
+	const vl::Image wide{8, 6, vl::PixelFormat::Grayscale16};
+	const vl::Image resized{vl::transform::resize(wide, 3, 5, Interpolation::Bilinear)};
+	checker.expect(resized.width() == 3 && resized.height() == 5, "unsupported warp keeps requested size");
+}
+
+void test_pyramid(Checker &checker, std::mt19937 &random)
+{
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const auto format{static_cast<vl::PixelFormat>(std::array{0, 2, 3}[random_size(random, 0, 2)])};
+		const vl::Image source{random_image(random, random_size(random, 1, 45), random_size(random, 1, 45), format)};
+		checker.set_context(fmt::format("{}x{} format {}", source.width(), source.height(), static_cast<int>(format)));
+
+		for (const auto method : {vl::ReduceMethod::Box, vl::ReduceMethod::Binomial})
+		{
+			const vl::Image expected{vl::reference::reduce(source, method)};
+			for_thread_counts([&](std::size_t threads)
+			{
+				checker.compare(expected, vl::impl::reduce(source, method),
+					fmt::format("reduce {} with {} threads", static_cast<int>(method), threads));
+			});
+
+			vl::ImagePyramid pyramid{source, method, source.size() + 1};
+			const vl::Image &top{pyramid.level(pyramid.levels_count() - 1)};
+			checker.expect(top.width() == 1 && top.height() == 1, "pyramid ends with a single pixel");
+			checker.expect(pyramid.memory_usage() <= std::max(pyramid.memory_limit(), source.size() + top.size()),
+				"pyramid stays within memory limit");
+			checker.compare(expected, pyramid.level(1), "pyramid level after eviction");
+		}
+	}
+
+	bool rejected{false};
+	try
+	{
+		vl::ImagePyramid pyramid{vl::Image{4, 4, vl::PixelFormat::Grayscale16}};
+	}
+	catch (const std::logic_error &)
+	{
+		rejected = true;
+	}
+	checker.expect(rejected, "16-bit pyramid is rejected");
+}
+
+void test_distance(Checker &checker, std::mt19937 &random)
+{
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		vl::Image source{random_size(random, 1, 30), random_size(random, 1, 30), vl::PixelFormat::Grayscale8};
+		const std::size_t density{random_size(random, 1, 40)};
+		for (auto &value : source)
+			value = random_size(random, 0, 99) < density ? 255 : 0;
+		const double radius{random_size(random, 0, 50) / 10.};
+		checker.set_context(fmt::format("{}x{} density {} radius {}", source.width(), source.height(), density, radius));
+
+		for (const bool toBackground : {false, true})
+		{
+			const auto expected{vl::reference::squared_distances(source, 128, toBackground)};
+			for_thread_counts([&](std::size_t threads)
+			{
+				checker.expect(vl::math::squared_distance_transform(source, 128, toBackground) == expected,
+					fmt::format("squared distances to {} with {} threads", toBackground ? "background" : "foreground", threads));
+			});
+
+			vl::Image expectedMorphology{source};
+			for (std::size_t i = 0; i < expected.size(); ++i)
+				expectedMorphology.begin()[i] = (toBackground ? expected[i] > radius * radius : expected[i] <= radius * radius) ? 255 : 0;
+			vl::Image morphology{source};
+			if (toBackground)
+				vl::filters::binary_erosion(morphology, radius);
+			else
+				vl::filters::binary_dilation(morphology, radius);
+			checker.compare(expectedMorphology, morphology, toBackground ? "binary erosion" : "binary dilation");
+		}
+	}
+}
+
+void test_reconstruction(Checker &checker, std::mt19937 &random)
+{
+	using vl::filters::Connectivity;
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const std::size_t width{random_size(random, 1, 40)};
+		const std::size_t height{random_size(random, 1, 40)};
+		const std::size_t levels{random_size(random, 2, 256)};
+		vl::Image source{random_image(random, width, height)};
+		vl::Image marker{random_image(random, width, height)};
+		for (auto &value : source)
+			value = value * levels / 256 * 255 / (levels - 1);
+		const Connectivity connectivity{iteration % 2 ? Connectivity::Four : Connectivity::Eight};
+		checker.set_context(fmt::format("{}x{} levels {} connectivity {}", width, height, levels,
+			connectivity == Connectivity::Four ? 4 : 8));
+
+		for (const bool byDilation : {true, false})
+		{
+			vl::Image expected{marker};
+			vl::reference::reconstruction(expected, source, connectivity, byDilation);
+			vl::Image actual{marker};
+			if (byDilation)
+				vl::filters::reconstruction_by_dilation(actual, source, connectivity);
+			else
+				vl::filters::reconstruction_by_erosion(actual, source, connectivity);
+			checker.compare(expected, actual, byDilation ? "reconstruction by dilation" : "reconstruction by erosion");
+		}
+
+		vl::Image expectedHoles{width, height, vl::PixelFormat::Grayscale8};
+		for (std::size_t y = 0; y < height; ++y)
+			for (std::size_t x = 0; x < width; ++x)
+				expectedHoles[x, y] = x == 0 || y == 0 || x + 1 == width || y + 1 == height ? source[x, y] : 255;
+		vl::reference::reconstruction(expectedHoles, source, connectivity, false);
+		vl::Image holes{source};
+		vl::filters::fill_holes(holes, connectivity);
+		checker.compare(expectedHoles, holes, "fill holes");
+
+		for (const bool maxima : {true, false})
+		{
+			vl::Image expected{source};
+			for (auto &value : expected)
+				value = maxima ? std::max(value - 1, 0) : std::min(value + 1, 255);
+			vl::reference::reconstruction(expected, source, connectivity, maxima);
+			for (std::size_t i = 0; i < expected.size(); ++i)
+				expected.begin()[i] = source.begin()[i] != expected.begin()[i] ? 255 : 0;
+			vl::Image actual{source};
+			if (maxima)
+				vl::filters::regional_maxima(actual, connectivity);
+			else
+				vl::filters::regional_minima(actual, connectivity);
+			checker.compare(expected, actual, maxima ? "regional maxima" : "regional minima");
+		}
+
+		const std::size_t size{random_size(random, 1, 2) * 2 + 1};
+		if (width <= size || height <= size)
+			continue;
+		for (const bool opening : {true, false})
+		{
+			vl::Image expected{source};
+			if (opening)
+				vl::reference::erosion(expected, vl::filters::Shape::Rectangle, size);
+			else
+				vl::reference::dilation(expected, vl::filters::Shape::Rectangle, size);
+			vl::reference::reconstruction(expected, source, connectivity, opening);
+			for_thread_counts([&](std::size_t threads)
+			{
+				vl::Image actual{source};
+				if (opening)
+					vl::filters::opening_by_reconstruction(actual, vl::filters::Shape::Rectangle, size, connectivity);
+				else
+					vl::filters::closing_by_reconstruction(actual, vl::filters::Shape::Rectangle, size, connectivity);
+				checker.compare(expected, actual, fmt::format("{} by reconstruction with {} threads",
+					opening ? "opening" : "closing", threads));
+			});
+		}
+	}
+}
+
+void test_components(Checker &checker, std::mt19937 &random)
+{
+	using vl::filters::Connectivity;
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const vl::Image source{random_image(random, random_size(random, 1, 60), random_size(random, 1, 200))};
+		const vl::byte threshold = random_size(random, 1, 255);
+		const Connectivity connectivity{iteration % 2 ? Connectivity::Four : Connectivity::Eight};
+		checker.set_context(fmt::format("{}x{} threshold {} connectivity {}", source.width(), source.height(), threshold,
+			connectivity == Connectivity::Four ? 4 : 8));
+
+		const auto expected{vl::reference::component_labels(source, threshold, connectivity)};
+		const std::uint32_t count{expected.empty() ? 0 : *std::ranges::max_element(expected)};
+		std::vector<vl::Component> expectedComponents(count);
+		for (std::size_t y = 0; y < source.height(); ++y)
+			for (std::size_t x = 0; x < source.width(); ++x)
+			{
+				const std::uint32_t label{expected[y * source.width() + x]};
+				if (label == 0)
+					continue;
+
+				auto &component{expectedComponents[label - 1]};
+				if (component.area == 0)
+				{
+					component.label = label;
+					component.x = x;
+					component.y = y;
+				}
+				const std::size_t right{std::max(component.x + component.width, x + 1)};
+				component.x = std::min(component.x, x);
+				component.width = right - component.x;
+				component.height = y + 1 - component.y;
+				++component.area;
+				component.centroidX += x;
+				component.centroidY += y;
+				component.meanIntensity += source[x, y];
+			}
+		for (auto &component : expectedComponents)
+		{
+			component.centroidX /= component.area;
+			component.centroidY /= component.area;
+			component.meanIntensity /= component.area;
+		}
+
+		for_thread_counts([&](std::size_t threads)
+		{
+			const auto actual{vl::connected_components(source, threshold, connectivity)};
+			checker.expect(std::ranges::equal(actual.labels, expected), fmt::format("labels with {} threads", threads));
+			checker.expect(actual.components.size() == count, fmt::format("components count with {} threads", threads));
+			for (std::size_t i = 0; i < std::min<std::size_t>(count, actual.components.size()); ++i)
+			{
+				const auto &first{expectedComponents[i]};
+				const auto &second{actual.components[i]};
+				checker.expect(first.label == second.label && first.area == second.area
+					&& first.x == second.x && first.y == second.y
+					&& first.width == second.width && first.height == second.height
+					&& std::abs(first.centroidX - second.centroidX) < 1e-9
+					&& std::abs(first.centroidY - second.centroidY) < 1e-9
+					&& std::abs(first.meanIntensity - second.meanIntensity) < 1e-9,
+					fmt::format("component {} statistics with {} threads", i + 1, threads));
+			}
+		});
+	}
+}
+
+void test_stacker(Checker &checker, std::mt19937 &random)
+{
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const std::size_t width{random_size(random, 1, 30)};
+		const std::size_t height{random_size(random, 1, 30)};
+		std::vector<vl::Image> frames;
+		for (std::size_t frame = random_size(random, 1, 9); frame > 0; --frame)
+			frames.push_back(random_image(random, width, height));
+		checker.set_context(fmt::format("{}x{} frames {}", width, height, frames.size()));
+
+		for (const auto mode : {vl::StackMode::Mean, vl::StackMode::Median, vl::StackMode::Min, vl::StackMode::Max})
+		{
+			vl::Image expected{width, height, vl::PixelFormat::Grayscale8};
+			for (std::size_t i = 0; i < expected.size(); ++i)
+			{
+				std::vector<unsigned> values;
+				for (const auto &frame : frames)
+					values.push_back(frame.begin()[i]);
+				std::ranges::sort(values);
+
+				switch (mode)
+				{
+					case vl::StackMode::Mean:
+						expected.begin()[i] = (std::accumulate(values.begin(), values.end(), 0u) + values.size() / 2) / values.size();
+						break;
+					case vl::StackMode::Median:
+						expected.begin()[i] = values[(values.size() + 1) / 2 - 1];
+						break;
+					case vl::StackMode::Min:
+						expected.begin()[i] = values.front();
+						break;
+					case vl::StackMode::Max:
+						expected.begin()[i] = values.back();
+						break;
+				}
+			}
+
+			for_thread_counts([&](std::size_t threads)
+			{
+				vl::Stacker stacker{mode, 256};
+				for (const auto &frame : frames)
+					stacker.add(frame);
+				checker.compare(expected, stacker.result(), fmt::format("stack {} with {} threads", static_cast<int>(mode), threads));
+			});
+		}
+	}
+
+	const std::size_t width{random_size(random, 60, 140)};
+	const std::size_t height{random_size(random, 1, 12)};
+	std::vector<std::vector<unsigned>> values(width * height);
+	vl::Stacker stacker{vl::StackMode::Median};
+	for (std::size_t frameIndex = 1; frameIndex <= 600; ++frameIndex)
+	{
+		const vl::Image frame{random_image(random, width, height)};
+		stacker.add(frame);
+		for (std::size_t i = 0; i < frame.size(); ++i)
+			values[i].push_back(frame.begin()[i]);
+		if (frameIndex % 100 != 0)
+			continue;
+
+		vl::Image expected{width, height, vl::PixelFormat::Grayscale8};
+		for (std::size_t i = 0; i < expected.size(); ++i)
+		{
+			std::vector<unsigned> sorted{values[i]};
+			std::ranges::sort(sorted);
+			expected.begin()[i] = sorted[(sorted.size() + 1) / 2 - 1];
+		}
+		checker.set_context(fmt::format("{}x{} frames {}", width, height, frameIndex));
+		checker.compare(expected, stacker.result(), "long median stack");
+	}
+}
+
+void test_io(Checker &checker, std::mt19937 &random)
+{
+	const auto directory{std::filesystem::temp_directory_path()};
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const auto format{static_cast<vl::PixelFormat>(random_size(random, 0, 3))};
+		vl::Image source{random_image(random, random_size(random, 1, 70), random_size(random, 1, 70), format)};
+		checker.set_context(fmt::format("{}x{} format {}", source.width(), source.height(), static_cast<int>(format)));
+
+		const auto encoded{vl::ImageIO::encode_png(source)};
+		checker.expect(encoded.has_value(), "png encoding");
+		if (encoded)
+		{
+			const auto decoded{vl::ImageIO::decode_png(*encoded, vl::ImageIO::ColorMode::Native)};
+			checker.expect(decoded.has_value(), "png decoding");
+			if (decoded)
+				checker.compare(source, *decoded, "png native roundtrip");
+
+			const auto gray{vl::ImageIO::decode_png(*encoded)};
+			if (gray)
+				checker.compare(vl::reference::to_grayscale(source), *gray, "png grayscale decoding", FloatRoundingTolerance);
+
+			const std::span<const vl::byte> truncated{encoded->data(), random_size(random, 8, encoded->size() - 13)};
+			checker.expect(!vl::ImageIO::decode_png(truncated).has_value(), "truncated png is rejected");
+		}
+		checker.compare(vl::reference::to_grayscale(source), vl::color::to_grayscale(source), "grayscale conversion", FloatRoundingTolerance);
+
+		if (format != vl::PixelFormat::Grayscale8)
+			continue;
+
+		const auto path{(directory / fmt::format("vision_tests_{}.vlt", random())).string()};
+		const vl::ImageIO::TiledOptions options{random_size(random, 1, 32), random_size(random, 1, 32), 1};
+		checker.expect(vl::ImageIO::write_tiled(source, path, options).has_value(), "tiled write");
+
+		const std::size_t x{random_size(random, 0, source.width() - 1)};
+		const std::size_t y{random_size(random, 0, source.height() - 1)};
+		const std::size_t width{random_size(random, 1, source.width() - x)};
+		const std::size_t height{random_size(random, 1, source.height() - y)};
+		vl::Image expected{width, height, format};
+		for (std::size_t row = 0; row < height; ++row)
+			std::copy_n(source.row(y + row) + x, width, expected.row(row));
+
+		for_thread_counts([&](std::size_t threads)
+		{
+			const auto region{vl::ImageIO::read_region(path, x, y, width, height)};
+			checker.expect(region.has_value(), fmt::format("tiled region read with {} threads", threads));
+			if (region)
+				checker.compare(expected, *region, fmt::format("tiled region with {} threads", threads));
+		});
+
+		checker.expect(!vl::ImageIO::read_region(path, std::numeric_limits<std::size_t>::max(), 0, 2, 1).has_value(),
+			"wrapping region is rejected");
+
+		std::vector<vl::byte> bytes(std::filesystem::file_size(path));
+		std::FILE *file{std::fopen(path.c_str(), "r+b")};
+		checker.expect(std::fread(bytes.data(), 1, bytes.size(), file) == bytes.size(), "tiled file read back");
+		const std::array<std::size_t, 5> corruptedFields{16, 24, 32, 48, 56};
+		const std::size_t field{corruptedFields[random_size(random, 0, corruptedFields.size() - 1)]};
+		std::fill_n(bytes.begin() + field, 4, 0xff);
+		std::rewind(file);
+		std::fwrite(bytes.data(), 1, bytes.size(), file);
+		std::fclose(file);
+		checker.expect(!vl::ImageIO::read_tiled(path).has_value(), fmt::format("tiled file with corrupted field {} is rejected", field));
+		std::filesystem::remove(path);
+	}
+}
+
+void test_async_io(Checker &checker, std::mt19937 &random)
+{
+	const auto directory{std::filesystem::temp_directory_path()};
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const auto backend{iteration % 2 ? vl::ImageIO::Backend::Threads : vl::ImageIO::Backend::Auto};
+		vl::ImageIO::AsyncIO io{random_size(random, 1, 3), backend};
+		checker.set_context(fmt::format("backend {}", static_cast<int>(io.backend())));
+
+		std::vector<vl::Image> images;
+		std::vector<std::string> paths;
+		for (std::size_t i = random_size(random, 1, 6); i > 0; --i)
+		{
+			images.push_back(random_image(random, random_size(random, 1, 40), random_size(random, 1, 40)));
+			paths.push_back((directory / fmt::format("vision_tests_async_{}.png", random())).string());
+			checker.expect(io.write_png(images.back(), paths.back()).has_value(), "async png write");
+		}
+		checker.expect(io.flush().empty(), "async flush without errors");
+
+		io.prefetch(paths);
+		for (std::size_t i = 0; i < paths.size(); ++i)
+		{
+			const auto image{io.read_png(paths[i])};
+			checker.expect(image.has_value(), "async png read");
+			if (image)
+				checker.compare(images[i], *image, "async png roundtrip");
+		}
+
+		for (std::size_t round = 0; round < 2; ++round)
+		{
+			io.prefetch(paths);
+			for (std::size_t i = paths.size(); i-- > 0;)
+			{
+				const auto image{io.read_png(paths[i])};
+				checker.expect(image.has_value(), "async png read after skipped prefetches");
+				if (image)
+					checker.compare(images[i], *image, "async png read after skipped prefetches");
+			}
+		}
+
+		const auto expected{vl::ImageIO::encode_png(images.front())};
+		std::array<std::expected<std::vector<vl::byte>, vl::ImageIO::ReadError>, 3> concurrent;
+		{
+			std::vector<std::jthread> readers;
+			for (auto &result : concurrent)
+				readers.emplace_back([&]{ result = io.read(paths.front()); });
+		}
+		for (const auto &result : concurrent)
+			checker.expect(result.has_value() && expected && *result == *expected, "concurrent reads of one path");
+
+		checker.expect(!io.read((directory / "vision_tests_missing.png").string()).has_value(), "missing file read fails");
+		for (const auto &path : paths)
+			std::filesystem::remove(path);
+	}
+}
+
+void test_views(Checker &checker, std::mt19937 &random)
+{
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const vl::Image source{random_image(random, random_size(random, 3, 70), random_size(random, 3, 70))};
+		checker.set_context(fmt::format("{}x{}", source.width(), source.height()));
+
+		const auto check{[&](const std::string &what, const std::function<void(vl::Image &)> &filter)
+		{
+			vl::Image expected{source};
+			filter(expected);
+
+			std::vector<vl::byte> buffer{source.begin(), source.end()};
+			vl::Image view{vl::Image::view(buffer, source.width(), source.height(), source.format())};
+			filter(view);
+			checker.expect(view.is_view() && view.begin() == buffer.data(), what + " keeps view memory");
+			checker.compare(expected, vl::Image{std::move(buffer), source.width(), source.height(), source.format()},
+				what + " through view");
+		}};
+		check("median", [](vl::Image &image){ vl::filters::median(image, 3); });
+		check("sobel", vl::filters::sobel);
+		check("unsharp mask", [](vl::Image &image){ vl::filters::unsharp_mask(image, 1.5, 0.7); });
+		check("add copy", [](vl::Image &image){ image = image + image; });
+
+		std::vector<vl::byte> buffer{source.begin(), source.end()};
+		const vl::Image view{vl::Image::view(buffer, source.width(), source.height(), source.format())};
+		const vl::Image copy{view};
+		checker.expect(!copy.is_view() && copy.begin() != buffer.data(), "copy of view owns memory");
+		checker.compare(source, copy, "copy of view");
+	}
+}
+
+std::vector<vl::Image> split_channels(const vl::Image &image)
+{
+	std::vector<vl::Image> planes;
+	for (std::size_t channel = 0; channel < image.channels(); ++channel)
+	{
+		vl::Image plane{image.width(), image.height(), vl::PixelFormat::Grayscale8};
+		for (std::size_t y = 0; y < image.height(); ++y)
+			for (std::size_t x = 0; x < image.width(); ++x)
+				plane[x, y] = (&image[x, y])[channel];
+		planes.push_back(std::move(plane));
+	}
+
+	return planes;
+}
+
+vl::Image merge_channels(const std::vector<vl::Image> &planes, vl::PixelFormat format)
+{
+	vl::Image image{planes.front().width(), planes.front().height(), format};
+	for (std::size_t channel = 0; channel < planes.size(); ++channel)
+		for (std::size_t y = 0; y < image.height(); ++y)
+			for (std::size_t x = 0; x < image.width(); ++x)
+				(&image[x, y])[channel] = planes[channel][x, y];
+
+	return image;
+}
+
+void test_planar(Checker &checker, std::mt19937 &random)
+{
+	for (std::size_t iteration = 0; iteration < Iterations; ++iteration)
+	{
+		const auto format{iteration % 2 ? vl::PixelFormat::RGBA8 : vl::PixelFormat::RGB8};
+		const vl::Image source{random_image(random, random_size(random, 9, 90), random_size(random, 9, 40), format)};
+		checker.set_context(fmt::format("{}x{}x{}", source.width(), source.height(), source.channels()));
+
+		const auto expectedPlanes{split_channels(source)};
+		for_thread_counts([&](std::size_t threads)
+		{
+			const vl::PlanarImage planar{source};
+			for (std::size_t channel = 0; channel < source.channels(); ++channel)
+				checker.compare(expectedPlanes[channel], planar.plane(channel),
+					fmt::format("deinterleave channel {} with {} threads", channel, threads));
+			checker.compare(source, planar.interleaved(), fmt::format("interleave with {} threads", threads));
+		});
+
+		const auto check{[&](const std::string &what, const std::function<void(vl::Image &)> &filter)
+		{
+			auto planes{expectedPlanes};
+			for (std::size_t channel = 0; channel < source.color_channels(); ++channel)
+				filter(planes[channel]);
+			const vl::Image expected{merge_channels(planes, format)};
+
+			for_thread_counts([&](std::size_t threads)
+			{
+				vl::Image actual{source};
+				filter(actual);
+				checker.compare(expected, actual, fmt::format("{} with {} threads", what, threads));
+			});
+		}};
+		check("gaussian", [](vl::Image &image){ vl::filters::gaussian(image, 1.2, 5); });
+		check("median", [](vl::Image &image){ vl::filters::median(image, 3, vl::filters::Shape::Circle); });
+		check("erosion", [](vl::Image &image){ vl::filters::erosion(image, vl::filters::Shape::Octagon, 5); });
+		check("sobel", vl::filters::sobel);
+		check("canny", [](vl::Image &image){ vl::filters::canny(image, 40, 120); });
+		check("unsharp mask", [](vl::Image &image){ vl::filters::unsharp_mask(image, 1.5, 0.7); });
+		check("local histogram equalization", [](vl::Image &image){ vl::filters::local_histogram_equalization(image, 16); });
+		check("invert", [](vl::Image &image){ vl::Lut::invert().apply(image); });
+		check("histogram equalization", vl::filters::histogram_equalization);
+		check("transfer function", [](vl::Image &image)
+		{
+			vl::filters::transfer_function(image, vl::filters::impl::piecewise_linear_transfer({{0, 255}, {255, 0}}));
+		});
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *seedString{std::getenv("VL_TEST_SEED")};
+	const std::uint32_t seed = seedString ? std::strtoul(seedString, nullptr, 10) : std::random_device{}();
+	fmt::println("Differential tests with VL_TEST_SEED={}", seed);
+
+	const std::vector<std::pair<std::string, std::function<void(Checker &, std::mt19937 &)>>> tests{
+		{"scalar filters", test_scalar_filters},
+		{"arithmetic", test_arithmetic},
+		{"lut", test_lut},
+		{"statistics", test_statistics},
+		{"window filters", test_window_filters},
+		{"edges", test_edges},
+		{"scale space", test_scale_space},
+		{"transforms", test_transforms},
+		{"pyramid", test_pyramid},
+		{"distance", test_distance},
+		{"reconstruction", test_reconstruction},
+		{"components", test_components},
+		{"stacker", test_stacker},
+		{"io", test_io},
+		{"async io", test_async_io},
+		{"views", test_views},
+		{"planar", test_planar},
+	};
+
+	std::size_t failures{0};
+	const vl::cpu::Level highestLevel{vl::cpu::level()};
+	for (int levelIndex = 0; levelIndex <= static_cast<int>(highestLevel); ++levelIndex)
+	{
+		const vl::cpu::Level level{vl::cpu::set_level(static_cast<vl::cpu::Level>(levelIndex))};
+		for (const auto &[name, test] : tests)
+		{
+			if (argc > 1 && std::find(argv + 1, argv + argc, name) == argv + argc)
+				continue;
+
+			Checker checker;
+			std::mt19937 random{seed};
+			test(checker, random);
+			fmt::println("{:<8} {:<16} {:>5} checks {:>3} failures", vl::cpu::to_string(level), name,
+				checker.checks(), checker.failures());
+			failures += checker.failures();
+		}
+	}
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,563 @@
+#include "reference.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+namespace
+{
+	std::size_t clamp_index(long index, std::size_t size)
+	{
+		return std::clamp<long>(index, 0, size - 1);
+	}
+
+	void sobel_gradients(const vl::Image &image, std::size_t x, std::size_t y, int &gx, int &gy)
+	{
+		gx = 0;
+		gy = 0;
+		constexpr std::array<int, 3> weights{1, 2, 1};
+		for (int k = -1; k <= 1; ++k)
+		{
+			const std::size_t row{clamp_index((long)y + k, image.height())};
+			const std::size_t column{clamp_index((long)x + k, image.width())};
+			gx += weights[k + 1] * (image[clamp_index((long)x + 1, image.width()), row]
+				- image[clamp_index((long)x - 1, image.width()), row]);
+			gy += weights[k + 1] * (image[column, clamp_index((long)y + 1, image.height())]
+				- image[column, clamp_index((long)y - 1, image.height())]);
+		}
+	}
+
+	double cubic_weight(double distance)
+	{
+		constexpr double a{-0.5};
+		distance = std::abs(distance);
+		if (distance <= 1)
+			return ((a + 2) * distance - (a + 3)) * distance * distance + 1;
+		if (distance < 2)
+			return ((a * distance - 5 * a) * distance + 8 * a) * distance - 4 * a;
+		return 0;
+	}
+}
+
+namespace vl::reference
+{
+	void gaussian(Image &image, double standardDeviation, std::size_t kernelSize)
+	{
+		std::vector<double> kernel(kernelSize * kernelSize);
+		const std::size_t halfKernel{kernelSize / 2};
+
+		const double inverseDoublePow{1 / (2 * std::pow(standardDeviation, 2))};
+		const double inverseDoublePowPi{inverseDoublePow / std::numbers::pi};
+		for (std::size_t y = 0; y < kernelSize; ++y)
+		{
+			const int yDisplacement = y - halfKernel;
+			const std::size_t yPow = yDisplacement * yDisplacement;
+			for (std::size_t x = 0; x < kernelSize; ++x)
+			{
+				const int xDisplacement = x - halfKernel;
+				const std::size_t xPow = xDisplacement * xDisplacement;
+				kernel[y * kernelSize + x] = inverseDoublePowPi * std::exp( -((xPow + yPow) * inverseDoublePow));
+			}
+		}
+
+		const Image imageCopy{image};
+		for (std::size_t y = halfKernel; y < image.height() - halfKernel; ++y)
+			for (std::size_t x = halfKernel; x < image.width() - halfKernel; ++x)
+			{
+				double sum{0};
+				for (std::size_t kernelY = 0; kernelY < kernelSize; ++kernelY)
+					for (std::size_t kernelX = 0; kernelX < kernelSize; ++kernelX)
+						sum += kernel[kernelY * kernelSize + kernelX]
+							* (double)imageCopy[x - halfKernel + kernelX, y - halfKernel + kernelY];
+				image[x, y] = std::clamp(sum, 0., 256.);
+			}
+	}
+
+	void median(Image &image, std::size_t size, filters::Shape shapeToUse)
+	{
+		const std::vector<bool> mask{filters::impl::create_mask(size, shapeToUse)};
+		const std::size_t halfSize{size / 2};
+
+		const vl::Image imageCopy{image};
+		std::vector<byte> values(filters::impl::get_mask_pixels_count(mask));
+		for (std::size_t y = halfSize; y < image.height() - halfSize; ++y)
+			for (std::size_t x = halfSize; x < image.width() - halfSize; ++x)
+			{
+				std::size_t index{0};
+				for (std::size_t kernelY = 0; kernelY < size; ++kernelY)
+					for (std::size_t kernelX = 0; kernelX < size; ++kernelX)
+						if (mask[kernelY * size + kernelX])
+							values[index++] = imageCopy[x - halfSize + kernelX, y - halfSize + kernelY];
+
+				std::ranges::sort(values);
+				image[x, y] = values[values.size() / 2 + 1];
+			}
+	}
+
+	void hybrid_median(Image &image, std::size_t size)
+	{
+		const std::size_t halfSize{size / 2};
+		const Image copy{image};
+		std::vector<byte> pixelsToCheck(size * 2 - 1);
+		std::array<byte, 3> medians;
+		for (std::size_t y = halfSize; y < image.height() - halfSize; ++y)
+			for (std::size_t x = halfSize; x < image.width() - halfSize; ++x)
+			{
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					pixelsToCheck[i] = copy[x - halfSize + i, y - halfSize + i];
+					if (i != halfSize + 1)
+						pixelsToCheck[size + i - (i > halfSize + 1)] = copy[x + halfSize - i, y + halfSize - i];
+				}
+				std::ranges::sort(pixelsToCheck);
+
+				medians[0] = pixelsToCheck[pixelsToCheck.size() / 2 + 1];
+				medians[1] = copy[x, y];
+
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					pixelsToCheck[i] = copy[x, y - halfSize + i];
+					if (i != halfSize + 1)
+						pixelsToCheck[size + i - (i > halfSize + 1)] = copy[x + halfSize - i, y];
+				}
+				std::ranges::sort(pixelsToCheck);
+				medians[2] = pixelsToCheck[pixelsToCheck.size() / 2 + 1];
+
+				std::ranges::sort(medians);
+				image[x, y] = medians[1];
+			}
+	}
+
+	void erosion(Image &image, filters::Shape shape, std::size_t size)
+	{
+		const std::size_t halfSize{size / 2};
+		const auto mask{filters::impl::create_mask(size, shape)};
+		const Image copy{image};
+		for (std::size_t y = halfSize; y < image.height() - halfSize; ++y)
+			for (std::size_t x = halfSize; x < image.width() - halfSize; ++x)
+			{
+				byte min = copy[x, y];
+				for (std::size_t i = 0; i < size; ++i)
+					for (std::size_t j = 0; j < size; ++j)
+						if (mask[i * size + j])
+							min = std::min(copy[x - halfSize + i, y - halfSize + j], min);
+
+				image[x, y] = min;
+			}
+	}
+
+	void dilation(Image &image, filters::Shape shape, std::size_t size)
+	{
+		const std::size_t halfSize{size / 2};
+		const auto mask{filters::impl::create_mask(size, shape)};
+		const Image copy{image};
+		for (std::size_t y = halfSize; y < image.height() - halfSize; ++y)
+			for (std::size_t x = halfSize; x < image.width() - halfSize; ++x)
+			{
+				byte max = copy[x, y];
+				for (std::size_t i = 0; i < size; ++i)
+					for (std::size_t j = 0; j < size; ++j)
+						if (mask[i * size + j])
+							max = std::max(copy[x - halfSize + i, y - halfSize + j], max);
+
+				image[x, y] = max;
+			}
+	}
+
+	void reconstruction(Image &marker, const Image &mask, filters::Connectivity connectivity, bool byDilation)
+	{
+		const long width = marker.width();
+		const long height = marker.height();
+		for (std::size_t i = 0; i < marker.size(); ++i)
+			marker.begin()[i] = byDilation ? std::min(marker.begin()[i], mask.begin()[i])
+				: std::max(marker.begin()[i], mask.begin()[i]);
+
+		bool changed{true};
+		while (changed)
+		{
+			changed = false;
+			const Image copy{marker};
+			for (long y = 0; y < height; ++y)
+				for (long x = 0; x < width; ++x)
+				{
+					byte value{copy[x, y]};
+					for (long dy = -1; dy <= 1; ++dy)
+						for (long dx = -1; dx <= 1; ++dx)
+						{
+							if (x + dx < 0 || x + dx >= width || y + dy < 0 || y + dy >= height)
+								continue;
+							if (connectivity == filters::Connectivity::Four && dx != 0 && dy != 0)
+								continue;
+							value = byDilation ? std::max(value, copy[x + dx, y + dy]) : std::min(value, copy[x + dx, y + dy]);
+						}
+
+					value = byDilation ? std::min(value, mask[x, y]) : std::max(value, mask[x, y]);
+					if (value != marker[x, y])
+					{
+						marker[x, y] = value;
+						changed = true;
+					}
+				}
+		}
+	}
+
+	void add(Image &image, const Image &other)
+	{
+		for (std::size_t i = 0; i < image.size(); ++i)
+			image.begin()[i] += other.begin()[i];
+	}
+
+	void subtract(Image &image, const Image &other)
+	{
+		for (std::size_t i = 0; i < image.size(); ++i)
+			image.begin()[i] -= other.begin()[i];
+	}
+
+	void multiply(Image &image, const Image &other)
+	{
+		for (std::size_t i = 0; i < image.size(); ++i)
+			image.begin()[i] *= other.begin()[i];
+	}
+
+	void divide(Image &image, const Image &other)
+	{
+		for (std::size_t i = 0; i < image.size(); ++i)
+			image.begin()[i] /= other.begin()[i];
+	}
+
+	void lut(Image &image, const std::array<byte, 256> &table)
+	{
+		for (std::size_t i = 0; i < image.size(); ++i)
+			if (i % image.channels() < image.color_channels())
+				image.begin()[i] = table[image.begin()[i]];
+	}
+
+	std::array<std::size_t, 256> histogram(const Image &image, std::size_t x, std::size_t y,
+		std::size_t width, std::size_t height)
+	{
+		std::array<std::size_t, 256> bins{};
+		for (std::size_t row = y; row < y + height; ++row)
+			for (std::size_t column = x; column < x + width; ++column)
+				++bins[image[column, row]];
+
+		return bins;
+	}
+
+	void variance(Image &image, std::size_t size)
+	{
+		const std::size_t halfSize{size / 2};
+		const Image copy{image};
+		for (std::size_t y = 0; y < image.height(); ++y)
+			for (std::size_t x = 0; x < image.width(); ++x)
+			{
+				std::uint64_t sum{0};
+				std::uint64_t squaredSum{0};
+				std::size_t count{0};
+				for (std::size_t row = y > halfSize ? y - halfSize : 0; row < std::min(y + halfSize + 1, image.height()); ++row)
+					for (std::size_t column = x > halfSize ? x - halfSize : 0; column < std::min(x + halfSize + 1, image.width()); ++column)
+					{
+						sum += copy[column, row];
+						squaredSum += copy[column, row] * copy[column, row];
+						++count;
+					}
+
+				const double mean{sum / (double)count};
+				const double localVariance{std::max(squaredSum / (double)count - mean * mean, 0.)};
+				image[x, y] = std::min(std::lround(localVariance), 255l);
+			}
+	}
+
+	void kuwahara(Image &image, std::size_t radius)
+	{
+		const Image copy{image};
+		for (std::size_t y = 0; y < image.height(); ++y)
+			for (std::size_t x = 0; x < image.width(); ++x)
+			{
+				const std::array<std::pair<std::size_t, std::size_t>, 2> rows{{
+					{y > radius ? y - radius : 0, y + 1},
+					{y, std::min(y + radius + 1, image.height())}
+				}};
+				const std::array<std::pair<std::size_t, std::size_t>, 2> columns{{
+					{x > radius ? x - radius : 0, x + 1},
+					{x, std::min(x + radius + 1, image.width())}
+				}};
+
+				double bestVariance{std::numeric_limits<double>::max()};
+				double bestMean{0};
+				for (const auto &[top, bottom] : rows)
+					for (const auto &[left, right] : columns)
+					{
+						std::uint64_t sum{0};
+						std::uint64_t squaredSum{0};
+						for (std::size_t row = top; row < bottom; ++row)
+							for (std::size_t column = left; column < right; ++column)
+							{
+								sum += copy[column, row];
+								squaredSum += copy[column, row] * copy[column, row];
+							}
+
+						const double count = (right - left) * (bottom - top);
+						const double mean{sum / count};
+						const double quadrantVariance{squaredSum / count - mean * mean};
+						if (quadrantVariance < bestVariance)
+						{
+							bestVariance = quadrantVariance;
+							bestMean = mean;
+						}
+					}
+
+				image[x, y] = std::lround(bestMean);
+			}
+	}
+
+	void horizontal_edges(Image &image)
+	{
+		const Image copy{image};
+		for (std::size_t y = 0; y < image.height(); ++y)
+			for (std::size_t x = 0; x < image.width(); ++x)
+			{
+				int gx;
+				int gy;
+				sobel_gradients(copy, x, y, gx, gy);
+				image[x, y] = std::min(std::abs(gy), 255);
+			}
+	}
+
+	void vertical_edges(Image &image)
+	{
+		const Image copy{image};
+		for (std::size_t y = 0; y < image.height(); ++y)
+			for (std::size_t x = 0; x < image.width(); ++x)
+			{
+				int gx;
+				int gy;
+				sobel_gradients(copy, x, y, gx, gy);
+				image[x, y] = std::min(std::abs(gx), 255);
+			}
+	}
+
+	void sobel(Image &image)
+	{
+		const Image copy{image};
+		for (std::size_t y = 0; y < image.height(); ++y)
+			for (std::size_t x = 0; x < image.width(); ++x)
+			{
+				int gx;
+				int gy;
+				sobel_gradients(copy, x, y, gx, gy);
+				image[x, y] = std::min(std::sqrt((float)(gx * gx + gy * gy)), 255.f);
+			}
+	}
+
+	void roberts_cross(Image &image)
+	{
+		const Image copy{image};
+		for (std::size_t y = 0; y < image.height(); ++y)
+			for (std::size_t x = 0; x < image.width(); ++x)
+			{
+				const std::size_t nextX{clamp_index((long)x + 1, image.width())};
+				const std::size_t nextY{clamp_index((long)y + 1, image.height())};
+				const float diagonal = copy[x, y] - copy[nextX, nextY];
+				const float antiDiagonal = nextX == x ? 0 : copy[nextX, y] - copy[x, nextY];
+				image[x, y] = std::min(std::sqrt(diagonal * diagonal + antiDiagonal * antiDiagonal), 255.f);
+			}
+	}
+
+	vl::Image gaussian_blur(const Image &image, double sigma)
+	{
+		const long radius = std::max(std::ceil(sigma * 3), 1.);
+		std::vector<double> kernel(radius * 2 + 1);
+		double kernelSum{0};
+		for (long i = -radius; i <= radius; ++i)
+		{
+			kernel[i + radius] = std::exp(-(double)(i * i) / (2 * sigma * sigma));
+			kernelSum += kernel[i + radius];
+		}
+		for (auto &weight : kernel)
+			weight /= kernelSum;
+
+		vl::Image blurred{image.width(), image.height(), image.format()};
+		for (std::size_t y = 0; y < image.height(); ++y)
+			for (std::size_t x = 0; x < image.width(); ++x)
+			{
+				double sum{0};
+				for (long kernelY = -radius; kernelY <= radius; ++kernelY)
+					for (long kernelX = -radius; kernelX <= radius; ++kernelX)
+						sum += kernel[kernelY + radius] * kernel[kernelX + radius]
+							* image[clamp_index((long)x + kernelX, image.width()), clamp_index((long)y + kernelY, image.height())];
+				blurred[x, y] = std::min(sum + 0.5, 255.);
+			}
+
+		return blurred;
+	}
+
+	vl::Image warp_affine(const Image &image, const transform::AffineTransform &transform,
+		std::size_t width, std::size_t height, transform::Interpolation interpolation)
+	{
+		const std::size_t channels{image.pixel_size()};
+		const auto inverse{*transform.inverse()};
+		vl::Image warped{width, height, image.format()};
+		const long sourceWidth = image.width();
+		const long sourceHeight = image.height();
+		const auto sample{[&](long column, long row, std::size_t channel) -> double
+		{
+			return image.row(std::clamp(row, 0l, sourceHeight - 1))[std::clamp(column, 0l, sourceWidth - 1) * channels + channel];
+		}};
+
+		for (std::size_t y = 0; y < height; ++y)
+			for (std::size_t x = 0; x < width; ++x)
+			{
+				const auto [sourceX, sourceY] = inverse({(double)x, (double)y});
+				byte *output{warped.row(y) + x * channels};
+				if (!(sourceX >= -0.5 && sourceX <= sourceWidth - 0.5 && sourceY >= -0.5 && sourceY <= sourceHeight - 0.5))
+					continue;
+
+				const double left{std::floor(sourceX)};
+				const double top{std::floor(sourceY)};
+				for (std::size_t channel = 0; channel < channels; ++channel)
+				{
+					double value{0};
+					switch (interpolation)
+					{
+						case transform::Interpolation::Nearest:
+							value = sample(std::lround(sourceX), std::lround(sourceY), channel);
+							break;
+						case transform::Interpolation::Bilinear:
+						{
+							const double xFraction{sourceX - left};
+							const double yFraction{sourceY - top};
+							value = (sample(left, top, channel) * (1 - xFraction) + sample(left + 1, top, channel) * xFraction) * (1 - yFraction)
+								+ (sample(left, top + 1, channel) * (1 - xFraction) + sample(left + 1, top + 1, channel) * xFraction) * yFraction;
+							break;
+						}
+						case transform::Interpolation::Bicubic:
+							for (int row = -1; row <= 2; ++row)
+								for (int column = -1; column <= 2; ++column)
+									value += cubic_weight(sourceX - (left + column)) * cubic_weight(sourceY - (top + row))
+										* sample(left + column, top + row, channel);
+							break;
+					}
+					output[channel] = std::clamp(value + 0.5, 0., 255.);
+				}
+			}
+
+		return warped;
+	}
+
+	vl::Image reduce(const Image &image, ReduceMethod method)
+	{
+		const std::size_t width{std::max<std::size_t>((image.width() + 1) / 2, 1)};
+		const std::size_t height{std::max<std::size_t>((image.height() + 1) / 2, 1)};
+		const std::size_t channels{image.pixel_size()};
+		const auto sample{[&](long column, long row, std::size_t channel) -> unsigned
+		{
+			return image.row(clamp_index(row, image.height()))[clamp_index(column, image.width()) * channels + channel];
+		}};
+
+		constexpr std::array<unsigned, 5> binomial{1, 4, 6, 4, 1};
+		vl::Image reduced{width, height, image.format()};
+		for (std::size_t y = 0; y < height; ++y)
+			for (std::size_t x = 0; x < width; ++x)
+				for (std::size_t channel = 0; channel < channels; ++channel)
+				{
+					unsigned value{0};
+					if (method == ReduceMethod::Box)
+						value = (sample(2 * x, 2 * y, channel) + sample(2 * x + 1, 2 * y, channel)
+							+ sample(2 * x, 2 * y + 1, channel) + sample(2 * x + 1, 2 * y + 1, channel) + 2) >> 2;
+					else
+					{
+						for (long row = -2; row <= 2; ++row)
+							for (long column = -2; column <= 2; ++column)
+								value += binomial[row + 2] * binomial[column + 2] * sample(2 * x + column, 2 * y + row, channel);
+						value = (value + 128) >> 8;
+					}
+					reduced.row(y)[x * channels + channel] = value;
+				}
+
+		return reduced;
+	}
+
+	vl::Image to_grayscale(const Image &image)
+	{
+		vl::Image gray{image.width(), image.height(), PixelFormat::Grayscale8};
+		for (std::size_t y = 0; y < image.height(); ++y)
+			for (std::size_t x = 0; x < image.width(); ++x)
+			{
+				double value;
+				if (image.format() == PixelFormat::Grayscale16)
+					value = reinterpret_cast<const std::uint16_t *>(image.row(y))[x] / 257.;
+				else if (image.format() == PixelFormat::Grayscale8)
+					value = image.row(y)[x];
+				else
+				{
+					const byte *pixel{image.row(y) + x * image.pixel_size()};
+					value = 0.2126 * pixel[0] + 0.7152 * pixel[1] + 0.0722 * pixel[2];
+				}
+				gray[x, y] = std::lround(value);
+			}
+
+		return gray;
+	}
+
+	std::vector<std::uint32_t> component_labels(const Image &image, byte threshold, filters::Connectivity connectivity)
+	{
+		const long width = image.width();
+		const long height = image.height();
+		std::vector<std::uint32_t> labels(width * height, 0);
+		std::uint32_t count{0};
+		for (long y = 0; y < height; ++y)
+			for (long x = 0; x < width; ++x)
+			{
+				if (image[x, y] < threshold || labels[y * width + x] != 0)
+					continue;
+
+				labels[y * width + x] = ++count;
+				std::vector<std::pair<long, long>> stack{{x, y}};
+				while (!stack.empty())
+				{
+					const auto [pixelX, pixelY]{stack.back()};
+					stack.pop_back();
+					for (long dy = -1; dy <= 1; ++dy)
+						for (long dx = -1; dx <= 1; ++dx)
+						{
+							const long neighbourX{pixelX + dx};
+							const long neighbourY{pixelY + dy};
+							if (neighbourX < 0 || neighbourX >= width || neighbourY < 0 || neighbourY >= height)
+								continue;
+							if (connectivity == filters::Connectivity::Four && dx != 0 && dy != 0)
+								continue;
+
+							auto &label{labels[neighbourY * width + neighbourX]};
+							if (label == 0 && image[neighbourX, neighbourY] >= threshold)
+							{
+								label = count;
+								stack.push_back({neighbourX, neighbourY});
+							}
+						}
+				}
+			}
+
+		return labels;
+	}
+
+	std::vector<std::uint32_t> squared_distances(const Image &image, byte threshold, bool toBackground)
+	{
+		std::vector<std::uint32_t> distances(image.width() * image.height(), std::numeric_limits<std::uint32_t>::max());
+		for (std::size_t y = 0; y < image.height(); ++y)
+			for (std::size_t x = 0; x < image.width(); ++x)
+				for (std::size_t featureY = 0; featureY < image.height(); ++featureY)
+					for (std::size_t featureX = 0; featureX < image.width(); ++featureX)
+					{
+						if ((image[featureX, featureY] >= threshold) == toBackground)
+							continue;
+
+						const long dx = (long)x - featureX;
+						const long dy = (long)y - featureY;
+						auto &distance{distances[y * image.width() + x]};
+						distance = std::min<std::uint32_t>(distance, dx * dx + dy * dy);
+					}
+
+		return distances;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "defs.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "filters.h"
+#include "image.h"
+#include "pyramid.h"
+#include "transform.h"
+
+namespace vl::reference
+{
+	void gaussian(Image &image, double standardDeviation, std::size_t kernelSize);
+	void median(Image &image, std::size_t size, filters::Shape shapeToUse);
+	void hybrid_median(Image &image, std::size_t size);
+	void erosion(Image &image, filters::Shape shape, std::size_t size);
+	void dilation(Image &image, filters::Shape shape, std::size_t size);
+	void reconstruction(Image &marker, const Image &mask, filters::Connectivity connectivity, bool byDilation);
+
+	void add(Image &image, const Image &other);
+	void subtract(Image &image, const Image &other);
+	void multiply(Image &image, const Image &other);
+	void divide(Image &image, const Image &other);
+
+	void lut(Image &image, const std::array<byte, 256> &table);
+	std::array<std::size_t, 256> histogram(const Image &image, std::size_t x, std::size_t y,
+		std::size_t width, std::size_t height);
+
+	void variance(Image &image, std::size_t size);
+	void kuwahara(Image &image, std::size_t radius);
+
+	void horizontal_edges(Image &image);
+	void vertical_edges(Image &image);
+	void sobel(Image &image);
+	void roberts_cross(Image &image);
+
+	vl::Image gaussian_blur(const Image &image, double sigma);
+	vl::Image warp_affine(const Image &image, const transform::AffineTransform &transform,
+		std::size_t width, std::size_t height, transform::Interpolation interpolation);
+	vl::Image reduce(const Image &image, ReduceMethod method);
+	vl::Image to_grayscale(const Image &image);
+
+	std::vector<std::uint32_t> component_labels(const Image &image, byte threshold, filters::Connectivity connectivity);
+	std::vector<std::uint32_t> squared_distances(const Image &image, byte threshold, bool toBackground);
+}
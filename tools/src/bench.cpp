@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <numbers>
+#include <optional>
+#include <random>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include <fmt/format.h>
+
+#include "components.h"
+#include "filters.h"
+#include "image_io.h"
+#include "lut.h"
+#include "math.h"
+#include "operations.h"
+#include "parallel.h"
+#include "stacker.h"
+#include "transform.h"
+
+using Runner = std::function<void(vl::Image &)>;
+
+struct BenchCase
+{
+	std::string name;
+	std::string parameters;
+	std::function<Runner(const vl::Image &)> prepare;
+};
+
+struct Measurement
+{
+	std::string name;
+	std::string parameters;
+	std::string noise;
+	std::size_t width;
+	std::size_t height;
+	std::size_t threads;
+	std::vector<double> megapixelsPerSecond;
+};
+
+std::vector<std::string> split_list(const std::string &listString)
+{
+	std::vector<std::string> values;
+	for (const auto value : std::views::split(listString, ','))
+		if (!value.empty())
+			values.emplace_back(value.begin(), value.end());
+
+	return values;
+}
+
+std::vector<std::size_t> parse_sizes(const std::string &listString)
+{
+	std::vector<std::size_t> values;
+	for (const auto &value : split_list(listString))
+		values.push_back(std::stoul(value));
+
+	return values;
+}
+
+std::optional<vl::Image> generate_image(std::size_t size, const std::string &noise)
+{
+	std::mt19937 random{static_cast<std::uint32_t>(size)};
+	vl::Image image{size, size, vl::PixelFormat::Grayscale8};
+	if (noise == "uniform")
+	{
+		std::uniform_int_distribution<int> distribution{0, 255};
+		for (auto &value : image)
+			value = distribution(random);
+	}
+	else if (noise == "gaussian")
+	{
+		std::normal_distribution<double> distribution{0, 20};
+		for (std::size_t y = 0; y < size; ++y)
+			for (std::size_t x = 0; x < size; ++x)
+				image[x, y] = std::clamp(64. + 128. * (x + y) / (2 * size) + distribution(random), 0., 255.);
+	}
+	else if (noise == "salt-pepper")
+	{
+		std::uniform_int_distribution<int> distribution{0, 99};
+		for (auto &value : image)
+		{
+			const int sample{distribution(random)};
+			value = sample < 3 ? 0 : sample < 6 ? 255 : 128;
+		}
+	}
+	else if (noise == "blobs")
+	{
+		const double frequency{16. / size};
+		for (std::size_t y = 0; y < size; ++y)
+			for (std::size_t x = 0; x < size; ++x)
+				image[x, y] = 127.5 + 127.5 * std::sin(x * frequency) * std::cos(y * frequency);
+	}
+	else
+		return {};
+
+	return image;
+}
+
+template<typename Filter>
+std::function<Runner(const vl::Image &)> simple(Filter filter)
+{
+	return [filter](const vl::Image &)
+	{
+		return Runner{filter};
+	};
+}
+
+std::vector<BenchCase> create_cases(const std::vector<std::size_t> &kernels)
+{
+	using namespace vl::filters;
+	const std::array<std::pair<std::string, Shape>, 3> shapes{{
+		{"rectangle", Shape::Rectangle},
+		{"circle", Shape::Circle},
+		{"octagon", Shape::Octagon}
+	}};
+
+	std::vector<BenchCase> cases;
+	for (const std::size_t kernel : kernels)
+	{
+		const std::string size{fmt::format("size={}", kernel)};
+		cases.push_back({"gauss", size, simple([=](vl::Image &image){ gaussian(image, kernel / 4. + 0.5, kernel); })});
+		for (const auto &[shapeName, shape] : shapes)
+		{
+			const std::string parameters{fmt::format("size={} shape={}", kernel, shapeName)};
+			cases.push_back({"median", parameters, simple([=](vl::Image &image){ median(image, kernel, shape); })});
+			cases.push_back({"erosion", parameters, simple([=](vl::Image &image){ erosion(image, shape, kernel); })});
+			cases.push_back({"dilation", parameters, simple([=](vl::Image &image){ dilation(image, shape, kernel); })});
+			cases.push_back({"opening-by-reconstruction", parameters,
+				simple([=](vl::Image &image){ opening_by_reconstruction(image, shape, kernel); })});
+		}
+		cases.push_back({"truncated-median", size, simple([=](vl::Image &image){ truncated_median(image, kernel); })});
+		cases.push_back({"hybrid-median", size, simple([=](vl::Image &image){ hybrid_median(image, kernel); })});
+		cases.push_back({"variance", size, simple([=](vl::Image &image){ variance(image, kernel); })});
+
+		const std::size_t radius{kernel / 2};
+		const std::string radiusString{fmt::format("radius={}", radius)};
+		cases.push_back({"kuwahara", radiusString, simple([=](vl::Image &image){ kuwahara(image, radius); })});
+		cases.push_back({"top-hat", radiusString, simple([=](vl::Image &image){ top_hat(image, radius, radius + 2, 10); })});
+		cases.push_back({"rolling-ball", radiusString, simple([=](vl::Image &image){ rolling_ball(image, radius, radius + 2, 10); })});
+		cases.push_back({"binary-erosion", radiusString, simple([=](vl::Image &image){ binary_erosion(image, radius); })});
+		cases.push_back({"binary-dilation", radiusString, simple([=](vl::Image &image){ binary_dilation(image, radius); })});
+
+		const double sigma{kernel / 3.};
+		const std::string sigmaString{fmt::format("sigma={:.2f}", sigma)};
+		cases.push_back({"unsharp-mask", sigmaString, simple([=](vl::Image &image){ unsharp_mask(image, sigma, 1); })});
+		cases.push_back({"dog", sigmaString, simple([=](vl::Image &image){ difference_of_gaussians(image, sigma, sigma * 2); })});
+		cases.push_back({"laplacian", sigmaString, simple([=](vl::Image &image){ laplacian(image, sigma); })});
+	}
+
+	cases.push_back({"horizontal-edges", "", simple([](vl::Image &image){ horizontal_edges(image); })});
+	cases.push_back({"vertical-edges", "", simple([](vl::Image &image){ vertical_edges(image); })});
+	cases.push_back({"roberts-cross", "", simple([](vl::Image &image){ roberts_cross(image); })});
+	cases.push_back({"sobel", "", simple([](vl::Image &image){ sobel(image); })});
+	cases.push_back({"canny", "low=50 high=150", simple([](vl::Image &image){ canny(image, 50, 150); })});
+	cases.push_back({"distance", "", simple([](vl::Image &image){ distance_transform(image); })});
+	cases.push_back({"fill-holes", "", simple([](vl::Image &image){ fill_holes(image); })});
+	cases.push_back({"regional-maxima", "", simple([](vl::Image &image){ regional_maxima(image); })});
+	cases.push_back({"components", "threshold=128", simple([](vl::Image &image){ vl::connected_components(image); })});
+	cases.push_back({"equalize", "", simple([](vl::Image &image){ histogram_equalization(image); })});
+	cases.push_back({"local-equalize", "tile=64", simple([](vl::Image &image){ local_histogram_equalization(image); })});
+	cases.push_back({"lut", "gamma+invert", simple([](vl::Image &image)
+	{
+		vl::LutPipeline{}.add(vl::Lut::gamma(0.5)).add(vl::Lut::invert()).apply(image);
+	})});
+
+	for (const auto &[methodName, method] : std::array<std::pair<std::string, vl::transform::Interpolation>, 3>{{
+		{"nearest", vl::transform::Interpolation::Nearest},
+		{"bilinear", vl::transform::Interpolation::Bilinear},
+		{"bicubic", vl::transform::Interpolation::Bicubic}}})
+	{
+		cases.push_back({"resize", fmt::format("scale=0.5 method={}", methodName), simple([=](vl::Image &image)
+		{
+			image = vl::transform::resize(image, image.width() / 2, image.height() / 2, method);
+		})});
+		cases.push_back({"align", fmt::format("rotate=15 method={}", methodName), simple([=](vl::Image &image)
+		{
+			const double angle{15. * std::numbers::pi / 180.};
+			const auto transform{vl::transform::AffineTransform::from_points(
+				{{{0, 0}, {1, 0}, {0, 1}}},
+				{{{0, 0}, {std::cos(angle), std::sin(angle)}, {-std::sin(angle), std::cos(angle)}}})};
+			image = vl::transform::warp_affine(image, *transform, image.width(), image.height(), method);
+		})});
+	}
+
+	for (const auto &[operationName, operation] : std::array<std::pair<std::string, vl::Image &(*)(vl::Image &, const vl::Image &)>, 4>{{
+		{"add", vl::operator+=},
+		{"subtract", vl::operator-=},
+		{"multiply", vl::operator*=},
+		{"divide", vl::operator/=}}})
+	{
+		cases.push_back({"operation", operationName, [=](const vl::Image &source)
+		{
+			vl::Image operand{source};
+			for (auto &value : operand)
+				value |= 1;
+			return Runner{[=](vl::Image &image){ operation(image, operand); }};
+		}});
+	}
+
+	cases.push_back({"statistics", "", simple([](vl::Image &image){ vl::math::statistics(image); })});
+	cases.push_back({"histogram", "", simple([](vl::Image &image){ vl::math::Histogram{image}; })});
+	cases.push_back({"entropy", "", simple([](vl::Image &image){ vl::math::entropy(image); })});
+	cases.push_back({"integral-image", "", simple([](vl::Image &image){ vl::math::IntegralImage{image}; })});
+	cases.push_back({"stack", "mode=mean frames=8", simple([](vl::Image &image)
+	{
+		vl::Stacker stacker{vl::StackMode::Mean};
+		for (std::size_t frame = 0; frame < 8; ++frame)
+			stacker.add(image);
+		image = stacker.result();
+	})});
+
+	cases.push_back({"png-encode", "", simple([](vl::Image &image){ vl::ImageIO::encode_png(image); })});
+	cases.push_back({"png-decode", "", [](const vl::Image &source)
+	{
+		auto encoded{vl::ImageIO::encode_png(source)};
+		return Runner{[bytes = std::move(encoded.value())](vl::Image &image)
+		{
+			image = vl::ImageIO::decode_png(bytes).value();
+		}};
+	}});
+
+	return cases;
+}
+
+double percentile(const std::vector<double> &sorted, double percent)
+{
+	if (sorted.empty())
+		return 0;
+
+	const double position{percent / 100. * (sorted.size() - 1)};
+	const std::size_t lower = position;
+	const std::size_t upper{std::min(lower + 1, sorted.size() - 1)};
+	return sorted[lower] + (sorted[upper] - sorted[lower]) * (position - lower);
+}
+
+std::string to_json(const std::vector<Measurement> &measurements, std::size_t repetitions)
+{
+	std::string json{fmt::format("{{\n\t\"version\": 1,\n\t\"hardware_threads\": {},\n\t\"repetitions\": {},\n\t\"results\": [",
+		std::thread::hardware_concurrency(), repetitions)};
+	for (std::size_t i = 0; i < measurements.size(); ++i)
+	{
+		const auto &measurement{measurements[i]};
+		auto sorted{measurement.megapixelsPerSecond};
+		std::ranges::sort(sorted);
+		const double mean{vl::math::get_mean_std_dev(sorted).first};
+
+		json += fmt::format("{}\n\t\t{{\"name\": \"{}\", \"parameters\": \"{}\", \"noise\": \"{}\", "
+			"\"width\": {}, \"height\": {}, \"threads\": {}, \"mp_per_second\": "
+			"{{\"min\": {:.3f}, \"p10\": {:.3f}, \"p50\": {:.3f}, \"p90\": {:.3f}, \"max\": {:.3f}, \"mean\": {:.3f}}}}}",
+			i == 0 ? "" : ",", measurement.name, measurement.parameters, measurement.noise,
+			measurement.width, measurement.height, measurement.threads,
+			sorted.front(), percentile(sorted, 10), percentile(sorted, 50), percentile(sorted, 90), sorted.back(), mean);
+	}
+	json += "\n\t]\n}\n";
+
+	return json;
+}
+
+int main(int argc, char **argv)
+{
+	cxxopts::Options options{"vision_bench", "Throughput benchmark of lib vision filters and IO"};
+
+	options.add_options()
+		("s,sizes", "Comma separated square image sizes", cxxopts::value<std::string>()->default_value("512,1024"))
+		("n,noise", "Comma separated noise profiles: uniform, gaussian, salt-pepper, blobs", cxxopts::value<std::string>()->default_value("uniform,gaussian"))
+		("k,kernels", "Comma separated kernel sizes", cxxopts::value<std::string>()->default_value("3,7"))
+		("t,threads", "Comma separated thread counts", cxxopts::value<std::string>()->default_value(fmt::format("1,{}", vl::parallel::thread_count())))
+		("r,repetitions", "Timed repetitions per case", cxxopts::value<std::size_t>()->default_value("5"))
+		("f,filter", "Comma separated case names to run, all if empty", cxxopts::value<std::string>()->default_value(""))
+		("o,output", "JSON report file", cxxopts::value<std::string>()->default_value("bench.json"))
+		("h,help", "Print usage");
+	const auto result{options.parse(argc, argv)};
+	if (result.count("help"))
+	{
+		fmt::println("{}", options.help());
+		return 0;
+	}
+
+	const auto sizes{parse_sizes(result["sizes"].as<std::string>())};
+	const auto noises{split_list(result["noise"].as<std::string>())};
+	const auto threads{parse_sizes(result["threads"].as<std::string>())};
+	const auto selected{split_list(result["filter"].as<std::string>())};
+	const std::size_t repetitions{std::max<std::size_t>(result["repetitions"].as<std::size_t>(), 1)};
+
+	auto cases{create_cases(parse_sizes(result["kernels"].as<std::string>()))};
+	if (!selected.empty())
+		std::erase_if(cases, [&](const BenchCase &benchCase){ return std::ranges::find(selected, benchCase.name) == selected.end(); });
+
+	fmt::println("{:<18} {:<28} {:<12} {:>11} {:>7} {:>10} {:>10} {:>10}",
+		"case", "parameters", "noise", "size", "threads", "p10 MP/s", "p50 MP/s", "p90 MP/s");
+
+	std::vector<Measurement> measurements;
+	for (const std::size_t size : sizes)
+	{
+		for (const auto &noise : noises)
+		{
+			const auto source{generate_image(size, noise)};
+			if (!source)
+			{
+				fmt::println("Unrecognized noise profile: {}", noise);
+				return -1;
+			}
+
+			for (const auto &benchCase : cases)
+			{
+				const Runner run{benchCase.prepare(*source)};
+				for (const std::size_t threadCount : threads)
+				{
+					vl::parallel::set_thread_count(threadCount);
+
+					Measurement measurement{benchCase.name, benchCase.parameters, noise, size, size, threadCount, {}};
+					const double megapixels{size * size / 1e6};
+					for (std::size_t repetition = 0; repetition <= repetitions; ++repetition)
+					{
+						vl::Image image{*source};
+						const auto start{std::chrono::steady_clock::now()};
+						run(image);
+						const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+						if (repetition > 0)
+							measurement.megapixelsPerSecond.push_back(megapixels / std::max(elapsed.count(), 1e-9));
+					}
+
+					auto sorted{measurement.megapixelsPerSecond};
+					std::ranges::sort(sorted);
+					fmt::println("{:<18} {:<28} {:<12} {:>11} {:>7} {:>10.2f} {:>10.2f} {:>10.2f}",
+						benchCase.name, benchCase.parameters, noise, fmt::format("{}x{}", size, size), threadCount,
+						percentile(sorted, 10), percentile(sorted, 50), percentile(sorted, 90));
+					measurements.push_back(std::move(measurement));
+				}
+			}
+		}
+	}
+
+	const auto output{result["output"].as<std::string>()};
+	std::ofstream report{output};
+	if (!report)
+	{
+		fmt::println("Failed to write {}", output);
+		return -1;
+	}
+	report << to_json(measurements, repetitions);
+
+	return 0;
+}
@@ -0,0 +1,101 @@
+#include <fstream>
+#include <iterator>
+#include <optional>
+
+#include <cxxopts.hpp>
+
+#include <fmt/format.h>
+
+#include "protocol.h"
+#include "stages.h"
+
+std::optional<std::vector<vl::byte>> read_file(const std::string &path)
+{
+	std::ifstream file{path, std::ios::binary};
+	if (!file)
+		return {};
+
+	return std::vector<vl::byte>{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+bool write_file(const std::string &path, const std::vector<vl::byte> &bytes)
+{
+	std::ofstream file{path, std::ios::binary};
+	file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+	return (bool)file;
+}
+
+int main(int argc, char **argv)
+{
+	auto stages{extract_stages(argc, argv)};
+
+	cxxopts::Options options{"vision_client", "Sends filter requests to vision_tool running with --serve"};
+
+	options.add_options()
+		("s,socket", "Socket of running server", cxxopts::value<std::string>())
+		("i,input", "Input file", cxxopts::value<std::string>())
+		("o,output", "Output file", cxxopts::value<std::string>()->default_value("output.png"))
+		("stage", "Filter stage with its options, e.g. \"median -s 5\", repeat to chain stages", cxxopts::value<std::string>())
+		("send", "Send input PNG bytes instead of its path")
+		("receive", "Receive output PNG bytes instead of server writing output path")
+		("r,repeat", "Send the request several times over one connection", cxxopts::value<std::size_t>()->default_value("1"));
+	const auto result{options.parse(argc, argv)};
+
+	if (!result.count("socket") || !result.count("input"))
+	{
+		fmt::println("{}", options.help());
+		return -1;
+	}
+
+	const auto connected{connect_socket(result["socket"].as<std::string>())};
+	if (!connected)
+		return -1;
+	Connection connection{*connected};
+
+	Request request;
+	request.input = result["input"].as<std::string>();
+	request.output = result["output"].as<std::string>();
+	request.stages = std::move(stages);
+	if (result.count("send"))
+	{
+		auto bytes{read_file(request.input)};
+		if (!bytes)
+		{
+			fmt::println("Failed to read: {}", request.input);
+			return -1;
+		}
+		request.input = InlineData;
+		request.payload = std::move(*bytes);
+	}
+	const bool receive{result.count("receive") > 0};
+	if (receive)
+		request.output = InlineData;
+
+	Response response;
+	for (std::size_t i = 0; i < result["repeat"].as<std::size_t>(); ++i)
+	{
+		write_request(connection, request);
+		if (!read_response(connection, response))
+		{
+			fmt::println("Connection to server was lost");
+			return -1;
+		}
+
+		fmt::println("{}: queue {:.2f} ms, decode {:.2f} ms, filter {:.2f} ms, encode {:.2f} ms, total {:.2f} ms",
+			to_string(response.status), response.timing.queue, response.timing.decode,
+			response.timing.filter, response.timing.encode, response.timing.total);
+		if (response.status != Status::Ok)
+		{
+			fmt::println("{}", response.message);
+			return -1;
+		}
+	}
+
+	if (receive && !write_file(result["output"].as<std::string>(), response.payload))
+	{
+		fmt::println("Failed to write: {}", result["output"].as<std::string>());
+		return -1;
+	}
+
+	return 0;
+}
@@ -1,21 +1,40 @@
+#include <algorithm>
+#include <fstream>
+#include <optional>
+#include <ranges>
+
 #include <cxxopts.hpp>
 
 #include <fmt/format.h>
 #include <fmt/ranges.h>
 
-#include "filters.h"
+#include "components.h"
 #include "image_io.h"
 #include "math.h"
+#include "profiling.h"
+#include "server.h"
+#include "stages.h"
 
-std::vector<const char *> create_args_from_unmatched(std::vector<std::string> &unmatched)
+bool write_profile(const std::string &path)
 {
-	std::vector<const char *> args;
-	args.reserve(unmatched.size() + 1);
-	args.push_back("./prog");
-	for (auto &str : unmatched)
-		args.push_back(str.data());
+	std::ofstream trace{path};
+	if (!trace)
+	{
+		fmt::println("Failed to open profile output: {}", path);
+		return false;
+	}
+	trace << vl::profiling::chrome_trace();
+
+	fmt::println("{:<36} {:>7} {:>12} {:>10} {:>14}", "stage", "calls", "total ms", "MP/s", "allocated MB");
+	for (const auto &stage : vl::profiling::summary())
+	{
+		const double milliseconds{stage.duration / 1e6};
+		const double megapixelsPerSecond{stage.duration > 0 ? stage.pixels * 1e3 / stage.duration : 0.};
+		fmt::println("{:<36} {:>7} {:>12.3f} {:>10.2f} {:>14.2f}", stage.name, stage.calls, milliseconds,
+			megapixelsPerSecond, stage.bytesAllocated / 1048576.);
+	}
 
-	return args;
+	return true;
 }
 
 template<typename T, typename FieldType, FieldType T::*FieldPtr>
@@ -39,18 +58,47 @@ using less_cmp = StructLessCmp<T, typename member_type_helper<typename std::remo
 
 int main(int argc, char **argv)
 {
+	const auto stageStrings{extract_stages(argc, argv)};
+
 	cxxopts::Options options{"Filters", "This is example program of using filters lib"};
 
 	options.add_options()
 		("i,input", "Input file", cxxopts::value<std::string>())
-		("c,calc", "Calculation to use", cxxopts::value<std::string>()->default_value("none"))
-		("f,filter", "Filter to use", cxxopts::value<std::string>()->default_value("none"))
-		("o,output", "Output file", cxxopts::value<std::string>()->default_value("output.png"));
+		("c,calc", "Comma separated calculations: entropy, snr, mean, std-dev, min, max, median, p<percent>, components", cxxopts::value<std::string>()->default_value("none"))
+		("f,filter", "Filter to use, its options follow on the command line", cxxopts::value<std::string>()->default_value("none"))
+		("stage", "Filter stage with its options, e.g. \"median -s 5\", repeat to chain stages", cxxopts::value<std::string>())
+		("pipeline", "File with one filter stage per line, run after --filter and before --stage", cxxopts::value<std::string>()->default_value(""))
+		("o,output", "Output file", cxxopts::value<std::string>()->default_value("output.png"))
+		("profile", "Write Chrome trace of library stages to file", cxxopts::value<std::string>()->default_value(""))
+		("serve", "Serve filter requests on Unix socket instead of processing input", cxxopts::value<std::string>()->default_value(""))
+		("workers", "Requests processed concurrently in serve mode", cxxopts::value<std::size_t>()->default_value("2"))
+		("queue-limit", "Requests waiting for a worker before new ones are rejected as busy", cxxopts::value<std::size_t>()->default_value("16"));
 	options.allow_unrecognised_options();
 	const auto result{options.parse(argc, argv)};
 	auto unmatched{result.unmatched()};
 
-	auto readImage{vl::ImageIO::read_png(result["input"].as<std::string>())};
+	const auto profile{result["profile"].as<std::string>()};
+	if (!profile.empty())
+	{
+		if (vl::profiling::Available)
+			vl::profiling::set_enabled(true);
+		else
+			fmt::println("Profiling is not built in, configure with -DUSE_PROFILING=ON");
+	}
+
+	const auto socketPath{result["serve"].as<std::string>()};
+	if (!socketPath.empty() && !profile.empty())
+	{
+		fmt::println("Profiling is not supported in serve mode");
+		return -1;
+	}
+	if (!socketPath.empty())
+		return serve(socketPath, {result["workers"].as<std::size_t>(), result["queue-limit"].as<std::size_t>()});
+
+	const auto input{result["input"].as<std::string>()};
+	auto readImage{input.ends_with(".vlt")
+		? vl::ImageIO::read_tiled(input)
+		: vl::ImageIO::read_png(input)};
 	if (!readImage.has_value())
 	{
 		fmt::println("Failed to read:\n{}", readImage.error().description);
@@ -59,164 +107,116 @@ int main(int argc, char **argv)
 	auto &image{readImage.value()};
 
 	const auto calc{result["calc"].as<std::string>()};
-	if (calc == "entropy")
+	if (calc != "none")
 	{
-		fmt::println("{} entropy level: {}", result["input"].as<std::string>(), vl::math::entropy(image));
-	}
-	else if (calc == "snr")
-	{
-		fmt::println("{} signal to noise ratio: {}", result["input"].as<std::string>(), vl::math::signal_to_noise_ratio(image));
+		const vl::math::Histogram histogram{image};
+		std::optional<vl::math::Statistics> statistics;
+		for (const auto calcRange : std::views::split(calc, ','))
+		{
+			const std::string calcName{calcRange.begin(), calcRange.end()};
+			if (calcName == "entropy")
+			{
+				fmt::println("{} entropy level: {}", input, histogram.entropy());
+			}
+			else if (calcName == "snr")
+			{
+				fmt::println("{} signal to noise ratio: {}", input, histogram.signal_to_noise_ratio());
+			}
+			else if (calcName == "mean")
+			{
+				fmt::println("{} mean: {}", input, histogram.mean());
+			}
+			else if (calcName == "std-dev")
+			{
+				fmt::println("{} standard deviation: {}", input, histogram.std_dev());
+			}
+			else if (calcName == "min" || calcName == "max")
+			{
+				if (!statistics)
+					statistics = vl::math::statistics(image);
+				fmt::println("{} {}: {}", input, calcName, calcName == "min" ? statistics->min : statistics->max);
+			}
+			else if (calcName == "median")
+			{
+				fmt::println("{} median: {}", input, histogram.percentile(50));
+			}
+			else if (calcName == "components")
+			{
+				const auto components{vl::connected_components(image)};
+				fmt::println("{} components: {}", input, components.components.size());
+				for (const auto &component : components.components)
+					fmt::println("{} area {} box {}x{}+{}+{} centroid {:.2f},{:.2f} mean {:.2f}", component.label,
+						component.area, component.width, component.height, component.x, component.y,
+						component.centroidX, component.centroidY, component.meanIntensity);
+			}
+			else if (calcName.starts_with("p") && calcName.size() > 1
+				&& std::ranges::all_of(calcName.substr(1), [](char c){ return std::isdigit(c) || c == '.'; }))
+			{
+				const double percent{std::stod(calcName.substr(1))};
+				fmt::println("{} {} percentile: {}", input, percent, histogram.percentile(percent));
+			}
+			else
+			{
+				fmt::println("Unrecognized calculation: {}", calcName);
+				return -1;
+			}
+		}
 	}
-	const auto filter{result["filter"].as<std::string>()};
-	bool actionHappend = true;
-	if (filter == "gauss")
-	{
-		cxxopts::Options options{"Gauss filter"};
-		options.add_options()
-			("d,std-dev", "Standard deviation", cxxopts::value<double>()->default_value("1"))
-			("s,size", "Kernel size", cxxopts::value<std::size_t>()->default_value("3"));
-		const auto args{create_args_from_unmatched(unmatched)};
-		const auto result{options.parse(args.size(), args.data())};
 
-		const auto stdDev{result["std-dev"].as<double>()};
-		const auto size{result["size"].as<std::size_t>()};
+	std::vector<Stage> stages;
+	const auto filter{result["filter"].as<std::string>()};
+	if (filter != "none")
+		stages.push_back({filter, unmatched});
 
-		vl::filters::gaussian(image, stdDev, size);
-	}
-	else if (filter == "median")
+	const auto pipeline{result["pipeline"].as<std::string>()};
+	if (!pipeline.empty())
 	{
-		cxxopts::Options options{"Median filter"};
-		options.add_options()
-			("s,size", "Kernel size", cxxopts::value<std::size_t>()->default_value("3"))
-			("S,shape", "Filter shape", cxxopts::value<std::string>()->default_value("rectangle"));
-		const auto args{create_args_from_unmatched(unmatched)};
-		const auto result{options.parse(args.size(), args.data())};
-
-
-		const auto size{result["size"].as<std::size_t>()};
-		const auto shapeString{result["shape"].as<std::string>()};
-		const auto shape{vl::filters::to_shape(shapeString)};
-		if (!shape)
+		std::ifstream pipelineFile{pipeline};
+		if (!pipelineFile)
 		{
-			fmt::println("Invalid shape name: {}", shapeString);
+			fmt::println("Failed to open pipeline file: {}", pipeline);
 			return -1;
 		}
 
-		vl::filters::median(image, size, *shape);
+		std::string line;
+		while (std::getline(pipelineFile, line))
+			if (auto stage{parse_stage(line.substr(0, line.find('#')))})
+				stages.push_back(std::move(*stage));
 	}
-	else if (filter == "truncated-median")
+
+	for (const auto &stageString : stageStrings)
 	{
-		cxxopts::Options options{"Truncated median filter"};
-		options.add_options()
-			("s,size", "Kernel size", cxxopts::value<std::size_t>()->default_value("3"))
-			("c,std-dev-count", "Count of standard eviation to accept", cxxopts::value<std::size_t>()->default_value("2"))
-			("S,shape", "Filter shape", cxxopts::value<std::string>()->default_value("rectangle"));
-		const auto args{create_args_from_unmatched(unmatched)};
-		const auto result{options.parse(args.size(), args.data())};
-
-
-		const auto size{result["size"].as<std::size_t>()};
-		const auto stdDevCount{result["std-dev-count"].as<std::size_t>()};
-		const auto shapeString{result["shape"].as<std::string>()};
-		const auto shape{vl::filters::to_shape(shapeString)};
-		if (!shape)
+		auto stage{parse_stage(stageString)};
+		if (!stage)
 		{
-			fmt::println("Invalid shape name: {}", shapeString);
+			fmt::println("Empty stage description");
 			return -1;
 		}
-
-		vl::filters::truncated_median(image, size, stdDevCount, *shape);
-	}
-	else if (filter == "hybrid-median")
-	{
-		cxxopts::Options options{"Hybird median filter"};
-		options.add_options()
-			("s,size", "Kernel size", cxxopts::value<std::size_t>()->default_value("3"))
-			("c,std-dev-count", "Count of standard eviation to accept", cxxopts::value<std::size_t>()->default_value("2"))
-			("S,shape", "Filter shape", cxxopts::value<std::string>()->default_value("rectangle"));
-		const auto args{create_args_from_unmatched(unmatched)};
-		const auto result{options.parse(args.size(), args.data())};
-
-		const auto size{result["size"].as<std::size_t>()};
-		vl::filters::hybrid_median(image, size);
-	}
-	else if (filter == "erosion")
-	{
-		cxxopts::Options options{"Erosion filter"};
-		options.add_options()
-			("s,size", "Kernel size", cxxopts::value<std::size_t>()->default_value("3"))
-			("S,shape", "Filter shape", cxxopts::value<std::string>()->default_value("rectangle"));
-		const auto args{create_args_from_unmatched(unmatched)};
-		const auto result{options.parse(args.size(), args.data())};
-
-		const auto size{result["size"].as<std::size_t>()};
-		const auto shapeString{result["shape"].as<std::string>()};
-		const vl::filters::Shape shape{*vl::filters::to_shape(shapeString)};
-		vl::filters::erosion(image, shape, size);
-	}
-	else if (filter == "dilation")
-	{
-		cxxopts::Options options{"Dilation filter"};
-		options.add_options()
-			("s,size", "Kernel size", cxxopts::value<std::size_t>()->default_value("3"))
-			("S,shape", "Filter shape", cxxopts::value<std::string>()->default_value("rectangle"));
-		const auto args{create_args_from_unmatched(unmatched)};
-		const auto result{options.parse(args.size(), args.data())};
-
-		const auto size{result["size"].as<std::size_t>()};
-		const auto shapeString{result["shape"].as<std::string>()};
-		const vl::filters::Shape shape{*vl::filters::to_shape(shapeString)};
-		vl::filters::dilation(image, shape, size);
-	}
-	else if (filter == "top-hat")
-	{
-		cxxopts::Options options{"Top hat filter"};
-		options.add_options()
-			("I,inner-radius", "Inner cirlce radius", cxxopts::value<int>()->default_value("3"))
-			("O,outter-radius", "Outter cirlce radius", cxxopts::value<int>()->default_value("5"))
-			("T,threshold", "Threshold", cxxopts::value<std::size_t>()->default_value("10"))
-			("D,dark", "Fill with dark", cxxopts::value<int>()->default_value("1"));
-		const auto args{create_args_from_unmatched(unmatched)};
-		const auto result{options.parse(args.size(), args.data())};
-
-		const int inner_radius{result["inner-radius"].as<int>()};
-		const int outter_radius{result["outter-radius"].as<int>()};
-		const std::size_t threshold{result["threshold"].as<std::size_t>()};
-		const int dark{result["dark"].as<int>()};
-
-		vl::filters::top_hat(image, inner_radius, outter_radius, threshold, dark);
-	}
-	else if (filter == "rolling-ball")
-	{
-		cxxopts::Options options{"Rolling ball filter"};
-		options.add_options()
-			("I,inner-radius", "Inner cirlce radius", cxxopts::value<int>()->default_value("3"))
-			("O,outter-radius", "Outter cirlce radius", cxxopts::value<int>()->default_value("5"))
-			("T,threshold", "Threshold", cxxopts::value<std::size_t>()->default_value("10"))
-			("D,dark", "Fill with dark", cxxopts::value<int>()->default_value("1"));
-		const auto args{create_args_from_unmatched(unmatched)};
-		const auto result{options.parse(args.size(), args.data())};
-
-		const int inner_radius{result["inner-radius"].as<int>()};
-		const int outter_radius{result["outter-radius"].as<int>()};
-		const std::size_t threshold{result["threshold"].as<std::size_t>()};
-		const int dark{result["dark"].as<int>()};
-
-		vl::filters::rolling_ball(image, inner_radius, outter_radius, threshold, dark);
-	}
-	else if (filter == "none")
-	{
-		actionHappend = false;
+		stages.push_back(std::move(*stage));
 	}
-	else
+
+	vl::LutPipeline luts;
+	for (auto &stage : stages)
 	{
-		fmt::println("Unrecognized option filter: {}", filter);
-		return -1;
+		if (const auto lut{stage_lut(stage.filter, stage.arguments)})
+		{
+			luts.add(*lut);
+			continue;
+		}
+
+		luts.apply(image);
+		luts = {};
+		if (!apply_stage(image, stage.filter, stage.arguments))
+			return -1;
 	}
+	luts.apply(image);
 
-	if (actionHappend)
+	if (!stages.empty())
 	{
-		const auto writeResult{vl::ImageIO::write_png(image, result["output"].as<std::string>())};
+		const auto output{result["output"].as<std::string>()};
+		const auto writeResult{output.ends_with(".vlt")
+			? vl::ImageIO::write_tiled(image, output)
+			: vl::ImageIO::write_png(image, output)};
 		if (!writeResult)
 		{
 			fmt::println("Got error while writting: {}", writeResult.error().description);
@@ -224,5 +224,8 @@ int main(int argc, char **argv)
 		}
 	}
 
+	if (vl::profiling::enabled() && !write_profile(profile))
+		return -1;
+
 	return 0;
 }
@@ -0,0 +1,319 @@
+#include "protocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+namespace
+{
+	constexpr std::size_t MaxLineLength{65536};
+	constexpr std::size_t MaxPayloadSize{std::size_t{1} << 30};
+
+	std::optional<sockaddr_un> socket_address(const std::string &path)
+	{
+		sockaddr_un address{};
+		if (path.size() >= sizeof(address.sun_path))
+		{
+			fmt::println("Socket path is too long: {}", path);
+			return {};
+		}
+
+		address.sun_family = AF_UNIX;
+		std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+		return address;
+	}
+
+	bool split_header(const std::string &line, std::string &key, std::string &value)
+	{
+		const auto separator{line.find(':')};
+		if (separator == std::string::npos)
+			return false;
+
+		key = line.substr(0, separator);
+		const auto valueBegin{line.find_first_not_of(' ', separator + 1)};
+		value = valueBegin == std::string::npos ? std::string{} : line.substr(valueBegin);
+		return true;
+	}
+
+	bool parse_length(const std::string &value, std::size_t &length)
+	{
+		const char *end{value.data() + value.size()};
+		const auto [parsed, error]{std::from_chars(value.data(), end, length)};
+		return !value.empty() && error == std::errc{} && parsed == end && length <= MaxPayloadSize;
+	}
+
+	std::optional<Status> to_status(const std::string &statusString)
+	{
+		if (statusString == "ok")
+			return Status::Ok;
+		else if (statusString == "error")
+			return Status::Error;
+		else if (statusString == "busy")
+			return Status::Busy;
+
+		return {};
+	}
+}
+
+Connection::Connection(int fd)
+	: m_fd{fd}
+{
+}
+
+Connection::~Connection()
+{
+	if (m_fd >= 0)
+		close(m_fd);
+}
+
+bool Connection::fill()
+{
+	if (m_begin > 0)
+	{
+		std::copy(m_buffer.begin() + m_begin, m_buffer.begin() + m_end, m_buffer.begin());
+		m_end -= m_begin;
+		m_begin = 0;
+	}
+	if (m_end == m_buffer.size())
+		return true;
+
+	while (true)
+	{
+		const ssize_t received{recv(m_fd, m_buffer.data() + m_end, m_buffer.size() - m_end, 0)};
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received <= 0)
+			return false;
+
+		m_end += received;
+		return true;
+	}
+}
+
+bool Connection::read_line(std::string &line)
+{
+	line.clear();
+	while (true)
+	{
+		const auto begin{m_buffer.begin() + m_begin};
+		const auto end{m_buffer.begin() + m_end};
+		const auto newline{std::find(begin, end, '\n')};
+		line.append(begin, newline);
+		if (newline != end)
+		{
+			m_begin = newline - m_buffer.begin() + 1;
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			return true;
+		}
+
+		m_begin = m_end;
+		if (line.size() > MaxLineLength || !fill())
+			return false;
+	}
+}
+
+bool Connection::read_bytes(std::vector<vl::byte> &bytes, std::size_t count)
+{
+	bytes.resize(count);
+	const std::size_t buffered{std::min(count, m_end - m_begin)};
+	std::memcpy(bytes.data(), m_buffer.data() + m_begin, buffered);
+	m_begin += buffered;
+
+	std::size_t done{buffered};
+	while (done < count)
+	{
+		const ssize_t received{recv(m_fd, bytes.data() + done, count - done, 0)};
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received <= 0)
+			return false;
+
+		done += received;
+	}
+
+	return true;
+}
+
+bool Connection::write(std::span<const vl::byte> bytes)
+{
+	std::size_t written{0};
+	while (written < bytes.size())
+	{
+		const ssize_t sent{send(m_fd, bytes.data() + written, bytes.size() - written, MSG_NOSIGNAL)};
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent < 0)
+			return false;
+
+		written += sent;
+	}
+
+	return true;
+}
+
+bool Connection::write(std::string_view text)
+{
+	return write(std::span{reinterpret_cast<const vl::byte *>(text.data()), text.size()});
+}
+
+std::optional<int> listen_socket(const std::string &path, int backlog)
+{
+	const auto address{socket_address(path)};
+	if (!address)
+		return {};
+
+	const int fd{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+	if (fd < 0)
+	{
+		fmt::println("Failed to create socket: {}", std::strerror(errno));
+		return {};
+	}
+
+	unlink(path.c_str());
+	if (bind(fd, reinterpret_cast<const sockaddr *>(&*address), sizeof(*address)) < 0 || listen(fd, backlog) < 0)
+	{
+		fmt::println("Failed to listen on {}: {}", path, std::strerror(errno));
+		close(fd);
+		return {};
+	}
+
+	return fd;
+}
+
+std::optional<int> connect_socket(const std::string &path)
+{
+	const auto address{socket_address(path)};
+	if (!address)
+		return {};
+
+	const int fd{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+	if (fd < 0)
+	{
+		fmt::println("Failed to create socket: {}", std::strerror(errno));
+		return {};
+	}
+
+	if (connect(fd, reinterpret_cast<const sockaddr *>(&*address), sizeof(*address)) < 0)
+	{
+		fmt::println("Failed to connect to {}: {}", path, std::strerror(errno));
+		close(fd);
+		return {};
+	}
+
+	return fd;
+}
+
+bool read_request(Connection &connection, Request &request)
+{
+	request.input.clear();
+	request.output.clear();
+	request.stages.clear();
+
+	std::size_t length{0};
+	std::string line;
+	std::string key;
+	std::string value;
+	while (connection.read_line(line))
+	{
+		if (line.empty())
+			return connection.read_bytes(request.payload, length);
+		if (!split_header(line, key, value))
+			return false;
+
+		if (key == "input")
+			request.input = value;
+		else if (key == "output")
+			request.output = value;
+		else if (key == "stage")
+			request.stages.push_back(value);
+		else if (key == "length" && !parse_length(value, length))
+			return false;
+	}
+
+	return false;
+}
+
+bool write_request(Connection &connection, const Request &request)
+{
+	std::string header{fmt::format("input: {}\noutput: {}\n", request.input, request.output)};
+	for (const auto &stage : request.stages)
+		header += fmt::format("stage: {}\n", stage);
+	header += fmt::format("length: {}\n\n", request.payload.size());
+
+	return connection.write(header) && connection.write(request.payload);
+}
+
+bool read_response(Connection &connection, Response &response)
+{
+	response = {};
+
+	std::size_t length{0};
+	std::string line;
+	std::string key;
+	std::string value;
+	while (connection.read_line(line))
+	{
+		if (line.empty())
+			return connection.read_bytes(response.payload, length);
+		if (!split_header(line, key, value))
+			return false;
+
+		if (key == "status")
+		{
+			const auto status{to_status(value)};
+			if (!status)
+				return false;
+			response.status = *status;
+		}
+		else if (key == "message")
+			response.message = value;
+		else if (key == "queue-ms")
+			response.timing.queue = std::stod(value);
+		else if (key == "decode-ms")
+			response.timing.decode = std::stod(value);
+		else if (key == "filter-ms")
+			response.timing.filter = std::stod(value);
+		else if (key == "encode-ms")
+			response.timing.encode = std::stod(value);
+		else if (key == "total-ms")
+			response.timing.total = std::stod(value);
+		else if (key == "length" && !parse_length(value, length))
+			return false;
+	}
+
+	return false;
+}
+
+bool write_response(Connection &connection, const Response &response)
+{
+	std::string message{response.message};
+	std::ranges::replace(message, '\n', ' ');
+
+	const std::string header{fmt::format("status: {}\nmessage: {}\nqueue-ms: {:.3f}\ndecode-ms: {:.3f}\n"
+		"filter-ms: {:.3f}\nencode-ms: {:.3f}\ntotal-ms: {:.3f}\nlength: {}\n\n",
+		to_string(response.status), message, response.timing.queue, response.timing.decode,
+		response.timing.filter, response.timing.encode, response.timing.total, response.payload.size())};
+
+	return connection.write(header) && connection.write(response.payload);
+}
+
+std::string to_string(Status status)
+{
+	switch (status)
+	{
+		case Status::Error:
+			return "error";
+		case Status::Busy:
+			return "busy";
+		default:
+			return "ok";
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "defs.h"
+
+constexpr std::string_view InlineData{"-"};
+
+struct Request
+{
+	std::string input;
+	std::string output;
+	std::vector<std::string> stages;
+	std::vector<vl::byte> payload;
+};
+
+enum class Status
+{
+	Ok,
+	Error,
+	Busy
+};
+
+struct Timing
+{
+	double queue{0};
+	double decode{0};
+	double filter{0};
+	double encode{0};
+	double total{0};
+};
+
+struct Response
+{
+	Status status{Status::Ok};
+	std::string message;
+	Timing timing;
+	std::vector<vl::byte> payload;
+};
+
+class Connection
+{
+public:
+	explicit Connection(int fd);
+	~Connection();
+
+	Connection(const Connection &) = delete;
+	Connection &operator=(const Connection &) = delete;
+
+	bool read_line(std::string &line);
+	bool read_bytes(std::vector<vl::byte> &bytes, std::size_t count);
+
+	bool write(std::string_view text);
+	bool write(std::span<const vl::byte> bytes);
+
+	inline int fd() const
+	{
+		return m_fd;
+	}
+
+	inline bool has_buffered() const
+	{
+		return m_begin < m_end;
+	}
+
+private:
+	bool fill();
+
+	int m_fd;
+	std::array<char, 16384> m_buffer;
+	std::size_t m_begin{0};
+	std::size_t m_end{0};
+};
+
+std::optional<int> listen_socket(const std::string &path, int backlog);
+std::optional<int> connect_socket(const std::string &path);
+
+bool read_request(Connection &connection, Request &request);
+bool write_request(Connection &connection, const Request &request);
+
+bool read_response(Connection &connection, Response &response);
+bool write_response(Connection &connection, const Response &response);
+
+std::string to_string(Status status);
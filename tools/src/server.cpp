@@ -0,0 +1,377 @@
+#include "server.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include "image_io.h"
+#include "parallel.h"
+#include "protocol.h"
+#include "stages.h"
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	volatile std::sig_atomic_t stopRequested{0};
+
+	void request_stop(int)
+	{
+		stopRequested = 1;
+	}
+
+	double milliseconds_since(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	constexpr timeval ReceiveTimeout{5, 0};
+	constexpr auto IdleTimeout{std::chrono::seconds{60}};
+
+	struct Session
+	{
+		std::unique_ptr<Connection> connection;
+		Clock::time_point ready;
+	};
+
+	class SessionQueue
+	{
+	public:
+		explicit SessionQueue(std::size_t limit)
+			: m_limit{limit}
+		{
+		}
+
+		bool try_push(Session &session)
+		{
+			{
+				std::lock_guard lock{m_mutex};
+				if (m_sessions.size() >= m_limit)
+					return false;
+				m_sessions.push_back(std::move(session));
+			}
+			m_available.notify_one();
+			return true;
+		}
+
+		std::optional<Session> pop()
+		{
+			std::unique_lock lock{m_mutex};
+			m_available.wait(lock, [&]{ return m_closed || !m_sessions.empty(); });
+			if (m_sessions.empty())
+				return {};
+
+			auto session{std::move(m_sessions.front())};
+			m_sessions.pop_front();
+			return session;
+		}
+
+		void close()
+		{
+			{
+				std::lock_guard lock{m_mutex};
+				m_closed = true;
+			}
+			m_available.notify_all();
+		}
+
+	private:
+		std::size_t m_limit;
+		std::mutex m_mutex;
+		std::condition_variable m_available;
+		std::deque<Session> m_sessions;
+		bool m_closed{false};
+	};
+
+	class ReturnedSessions
+	{
+	public:
+		ReturnedSessions()
+		{
+			if (pipe2(m_wakeup, O_CLOEXEC | O_NONBLOCK) < 0)
+				throw std::system_error{errno, std::generic_category(), "Failed to create wakeup pipe"};
+		}
+
+		~ReturnedSessions()
+		{
+			close(m_wakeup[0]);
+			close(m_wakeup[1]);
+		}
+
+		ReturnedSessions(const ReturnedSessions &) = delete;
+		ReturnedSessions &operator=(const ReturnedSessions &) = delete;
+
+		void give_back(Session session)
+		{
+			{
+				std::lock_guard lock{m_mutex};
+				m_sessions.push_back(std::move(session));
+			}
+			const char signal{0};
+			[[maybe_unused]] const auto written{write(m_wakeup[1], &signal, 1)};
+		}
+
+		std::vector<Session> take()
+		{
+			std::array<char, 64> drained;
+			while (read(m_wakeup[0], drained.data(), drained.size()) > 0)
+			{
+			}
+
+			std::lock_guard lock{m_mutex};
+			return std::exchange(m_sessions, {});
+		}
+
+		inline int wakeup_fd() const
+		{
+			return m_wakeup[0];
+		}
+
+	private:
+		int m_wakeup[2];
+		std::mutex m_mutex;
+		std::vector<Session> m_sessions;
+	};
+
+	std::expected<vl::Image, vl::ImageIO::ReadError> read_input(const Request &request)
+	{
+		if (request.input == InlineData)
+			return vl::ImageIO::decode_png(request.payload);
+		if (request.input.ends_with(".vlt"))
+			return vl::ImageIO::read_tiled(request.input);
+
+		return vl::ImageIO::read_png(request.input);
+	}
+
+	std::optional<std::string> write_output(const vl::Image &image, const Request &request, Response &response)
+	{
+		if (request.output == InlineData)
+		{
+			auto encoded{vl::ImageIO::encode_png(image)};
+			if (!encoded)
+				return encoded.error().description;
+			response.payload = std::move(*encoded);
+			return {};
+		}
+
+		const auto written{request.output.ends_with(".vlt")
+			? vl::ImageIO::write_tiled(image, request.output)
+			: vl::ImageIO::write_png(image, request.output)};
+		if (!written)
+			return written.error().description;
+
+		return {};
+	}
+
+	void process(const Request &request, Response &response)
+	{
+		const auto start{Clock::now()};
+		const auto fail{[&](std::string message)
+		{
+			response.status = Status::Error;
+			response.message = std::move(message);
+			response.timing.total = milliseconds_since(start);
+		}};
+
+		if (request.input.empty() || request.output.empty())
+			return fail("Request needs both input and output");
+
+		auto image{read_input(request)};
+		if (!image)
+			return fail(image.error().description);
+		response.timing.decode = milliseconds_since(start);
+
+		const auto filterStart{Clock::now()};
+		vl::LutPipeline luts;
+		for (const auto &description : request.stages)
+		{
+			auto stage{parse_stage(description)};
+			if (!stage)
+				return fail("Empty stage description");
+
+			try
+			{
+				if (const auto lut{stage_lut(stage->filter, stage->arguments)})
+				{
+					luts.add(*lut);
+					continue;
+				}
+
+				luts.apply(*image);
+				luts = {};
+				if (!apply_stage(*image, stage->filter, stage->arguments))
+					return fail(fmt::format("Stage failed: {}", description));
+			}
+			catch (const std::exception &error)
+			{
+				return fail(fmt::format("Stage failed: {}: {}", description, error.what()));
+			}
+		}
+		luts.apply(*image);
+		response.timing.filter = milliseconds_since(filterStart);
+
+		const auto encodeStart{Clock::now()};
+		if (const auto error{write_output(*image, request, response)})
+			return fail(*error);
+		response.timing.encode = milliseconds_since(encodeStart);
+		response.timing.total = milliseconds_since(start);
+	}
+
+	bool handle(Session &session, Request &request, Response &response)
+	{
+		Connection &connection{*session.connection};
+		try
+		{
+			if (!read_request(connection, request))
+				return false;
+
+			response.status = Status::Ok;
+			response.message.clear();
+			response.timing = {};
+			response.payload.clear();
+
+			process(request, response);
+			response.timing.queue = milliseconds_since(session.ready);
+			return write_response(connection, response);
+		}
+		catch (const std::exception &error)
+		{
+			response = {};
+			response.status = Status::Error;
+			response.message = fmt::format("Request failed: {}", error.what());
+			write_response(connection, response);
+			return false;
+		}
+	}
+
+	void reject(Connection &connection)
+	{
+		Response response;
+		response.status = Status::Busy;
+		response.message = "Server is at its concurrency limit";
+		write_response(connection, response);
+	}
+}
+
+int serve(const std::string &socketPath, const ServerOptions &options)
+{
+	if (options.workers == 0 || options.queueLimit == 0)
+	{
+		fmt::println("Invalid server limits: {} workers, queue of {}", options.workers, options.queueLimit);
+		return -1;
+	}
+
+	const auto listening{listen_socket(socketPath, options.queueLimit)};
+	if (!listening)
+		return -1;
+
+	struct sigaction action{};
+	action.sa_handler = request_stop;
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+
+	vl::parallel::for_range(0, vl::parallel::thread_count(), [](std::size_t, std::size_t){});
+
+	SessionQueue queue{options.queueLimit};
+	ReturnedSessions returned;
+	std::vector<std::jthread> workers;
+	for (std::size_t i = 0; i < options.workers; ++i)
+	{
+		workers.emplace_back([&queue, &returned]
+		{
+			Request request;
+			Response response;
+			while (auto session{queue.pop()})
+				if (handle(*session, request, response))
+					returned.give_back(std::move(*session));
+		});
+	}
+
+	const auto enqueue{[&queue](Session &session)
+	{
+		session.ready = Clock::now();
+		if (!queue.try_push(session))
+			reject(*session.connection);
+	}};
+
+	fmt::println("Serving on {} with {} workers and queue of {}", socketPath, options.workers, options.queueLimit);
+	std::vector<Session> idle;
+	std::vector<pollfd> descriptors;
+	while (!stopRequested)
+	{
+		descriptors.assign({{*listening, POLLIN, 0}, {returned.wakeup_fd(), POLLIN, 0}});
+		for (const auto &session : idle)
+			descriptors.push_back({session.connection->fd(), POLLIN, 0});
+
+		if (poll(descriptors.data(), descriptors.size(), 1000) < 0)
+		{
+			if (errno != EINTR)
+				fmt::println("Failed to wait for connections: {}", std::strerror(errno));
+			continue;
+		}
+
+		std::vector<Session> waiting;
+		const auto now{Clock::now()};
+		for (std::size_t i = 0; i < idle.size(); ++i)
+		{
+			if (descriptors[i + 2].revents != 0)
+				enqueue(idle[i]);
+			else if (now - idle[i].ready < IdleTimeout)
+				waiting.push_back(std::move(idle[i]));
+		}
+		idle = std::move(waiting);
+
+		if (descriptors[1].revents & POLLIN)
+		{
+			for (auto &session : returned.take())
+			{
+				session.ready = Clock::now();
+				if (session.connection->has_buffered())
+					enqueue(session);
+				else
+					idle.push_back(std::move(session));
+			}
+		}
+
+		if (descriptors[0].revents & POLLIN)
+		{
+			const int fd{accept4(*listening, nullptr, nullptr, SOCK_CLOEXEC)};
+			if (fd < 0)
+			{
+				if (errno != EINTR)
+					fmt::println("Failed to accept connection: {}", std::strerror(errno));
+				continue;
+			}
+
+			setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &ReceiveTimeout, sizeof(ReceiveTimeout));
+			idle.push_back({std::make_unique<Connection>(fd), Clock::now()});
+		}
+	}
+
+	queue.close();
+	workers.clear();
+	close(*listening);
+	unlink(socketPath.c_str());
+
+	return 0;
+}
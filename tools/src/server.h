@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+struct ServerOptions
+{
+	std::size_t workers{2};
+	std::size_t queueLimit{16};
+};
+
+int serve(const std::string &socketPath, const ServerOptions &options);
@@ -0,0 +1,587 @@
+#include "stages.h"
+
+#include <algorithm>
+#include <ranges>
+
+#include <cxxopts.hpp>
+
+#include <fmt/format.h>
+
+#include "async_io.h"
+#include "filters.h"
+#include "image_io.h"
+#include "lut.h"
+#include "stacker.h"
+#include "transform.h"
+
+namespace
+{
+	std::vector<const char *> create_args_from_unmatched(std::vector<std::string> &unmatched)
+	{
+		std::vector<const char *> args;
+		args.reserve(unmatched.size() + 1);
+		args.push_back("./prog");
+		for (auto &str : unmatched)
+			args.push_back(str.data());
+
+		return args;
+	}
+
+	std::optional<std::array<vl::transform::Point, 3>> parse_points(const std::string &pointsString)
+	{
+		std::vector<double> coordinates;
+		for (const auto coordinate : std::views::split(pointsString, ','))
+			coordinates.push_back(std::stod(std::string{coordinate.begin(), coordinate.end()}));
+
+		if (coordinates.size() != 6)
+			return {};
+
+		std::array<vl::transform::Point, 3> points;
+		for (std::size_t i = 0; i < points.size(); ++i)
+			points[i] = {coordinates[i * 2], coordinates[i * 2 + 1]};
+
+		return points;
+	}
+}
+
+std::optional<Stage> parse_stage(const std::string &description)
+{
+	std::vector<std::string> tokens;
+	std::string token;
+	bool quoted{false};
+	bool tokenStarted{false};
+	for (const char symbol : description)
+	{
+		if (symbol == '"')
+		{
+			quoted = !quoted;
+			tokenStarted = true;
+		}
+		else if (std::isspace(static_cast<unsigned char>(symbol)) && !quoted)
+		{
+			if (tokenStarted)
+				tokens.push_back(std::move(token));
+			token.clear();
+			tokenStarted = false;
+		}
+		else
+		{
+			token += symbol;
+			tokenStarted = true;
+		}
+	}
+	if (tokenStarted)
+		tokens.push_back(std::move(token));
+
+	if (tokens.empty())
+		return {};
+
+	return Stage{tokens.front(), {tokens.begin() + 1, tokens.end()}};
+}
+
+std::vector<std::string> extract_stages(int &argc, char **argv)
+{
+	std::vector<std::string> stages;
+	int kept{1};
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view argument{argv[i]};
+		if (argument == "--stage" && i + 1 < argc)
+			stages.emplace_back(argv[++i]);
+		else if (argument.starts_with("--stage="))
+			stages.emplace_back(argument.substr(std::string_view{"--stage="}.size()));
+		else
+			argv[kept++] = argv[i];
+	}
+	argc = kept;
+
+	return stages;
+}
+
+std::optional<vl::Lut> stage_lut(const std::string &filter, std::vector<std::string> &unmatched)
+{
+	if (filter == "threshold")
+	{
+		cxxopts::Options options{"Threshold"};
+		options.add_options()
+			("T,threshold", "Lowest value mapped to white", cxxopts::value<int>()->default_value("128"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		return vl::Lut::threshold(std::clamp(result["threshold"].as<int>(), 0, 255));
+	}
+	else if (filter == "gamma")
+	{
+		cxxopts::Options options{"Gamma correction"};
+		options.add_options()
+			("g,gamma", "Gamma exponent", cxxopts::value<double>()->default_value("1"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		return vl::Lut::gamma(result["gamma"].as<double>());
+	}
+	else if (filter == "invert")
+	{
+		return vl::Lut::invert();
+	}
+
+	return {};
+}
+
+bool apply_stage(vl::Image &image, const std::string &filter, std::vector<std::string> &unmatched)
+{
+	if (filter == "gauss")
+	{
+		cxxopts::Options options{"Gauss filter"};
+		options.add_options()
+			("d,std-dev", "Standard deviation", cxxopts::value<double>()->default_value("1"))
+			("s,size", "Kernel size", cxxopts::value<std::size_t>()->default_value("3"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		const auto stdDev{result["std-dev"].as<double>()};
+		const auto size{result["size"].as<std::size_t>()};
+
+		vl::filters::gaussian(image, stdDev, size);
+	}
+	else if (filter == "median")
+	{
+		cxxopts::Options options{"Median filter"};
+		options.add_options()
+			("s,size", "Kernel size", cxxopts::value<std::size_t>()->default_value("3"))
+			("S,shape", "Filter shape", cxxopts::value<std::string>()->default_value("rectangle"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+
+		const auto size{result["size"].as<std::size_t>()};
+		const auto shapeString{result["shape"].as<std::string>()};
+		const auto shape{vl::filters::to_shape(shapeString)};
+		if (!shape)
+		{
+			fmt::println("Invalid shape name: {}", shapeString);
+			return false;
+		}
+
+		vl::filters::median(image, size, *shape);
+	}
+	else if (filter == "truncated-median")
+	{
+		cxxopts::Options options{"Truncated median filter"};
+		options.add_options()
+			("s,size", "Kernel size", cxxopts::value<std::size_t>()->default_value("3"))
+			("c,std-dev-count", "Count of standard eviation to accept", cxxopts::value<std::size_t>()->default_value("2"))
+			("S,shape", "Filter shape", cxxopts::value<std::string>()->default_value("rectangle"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+
+		const auto size{result["size"].as<std::size_t>()};
+		const auto stdDevCount{result["std-dev-count"].as<std::size_t>()};
+		const auto shapeString{result["shape"].as<std::string>()};
+		const auto shape{vl::filters::to_shape(shapeString)};
+		if (!shape)
+		{
+			fmt::println("Invalid shape name: {}", shapeString);
+			return false;
+		}
+
+		vl::filters::truncated_median(image, size, stdDevCount, *shape);
+	}
+	else if (filter == "hybrid-median")
+	{
+		cxxopts::Options options{"Hybird median filter"};
+		options.add_options()
+			("s,size", "Kernel size", cxxopts::value<std::size_t>()->default_value("3"))
+			("c,std-dev-count", "Count of standard eviation to accept", cxxopts::value<std::size_t>()->default_value("2"))
+			("S,shape", "Filter shape", cxxopts::value<std::string>()->default_value("rectangle"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		const auto size{result["size"].as<std::size_t>()};
+		vl::filters::hybrid_median(image, size);
+	}
+	else if (filter == "erosion")
+	{
+		cxxopts::Options options{"Erosion filter"};
+		options.add_options()
+			("s,size", "Kernel size", cxxopts::value<std::size_t>()->default_value("3"))
+			("S,shape", "Filter shape", cxxopts::value<std::string>()->default_value("rectangle"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		const auto size{result["size"].as<std::size_t>()};
+		const auto shapeString{result["shape"].as<std::string>()};
+		const auto shape{vl::filters::to_shape(shapeString)};
+		if (!shape)
+		{
+			fmt::println("Invalid shape name: {}", shapeString);
+			return false;
+		}
+
+		vl::filters::erosion(image, *shape, size);
+	}
+	else if (filter == "dilation")
+	{
+		cxxopts::Options options{"Dilation filter"};
+		options.add_options()
+			("s,size", "Kernel size", cxxopts::value<std::size_t>()->default_value("3"))
+			("S,shape", "Filter shape", cxxopts::value<std::string>()->default_value("rectangle"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		const auto size{result["size"].as<std::size_t>()};
+		const auto shapeString{result["shape"].as<std::string>()};
+		const auto shape{vl::filters::to_shape(shapeString)};
+		if (!shape)
+		{
+			fmt::println("Invalid shape name: {}", shapeString);
+			return false;
+		}
+
+		vl::filters::dilation(image, *shape, size);
+	}
+	else if (filter == "opening-by-reconstruction" || filter == "closing-by-reconstruction")
+	{
+		cxxopts::Options options{"Opening or closing by reconstruction"};
+		options.add_options()
+			("s,size", "Kernel size", cxxopts::value<std::size_t>()->default_value("3"))
+			("S,shape", "Filter shape", cxxopts::value<std::string>()->default_value("rectangle"))
+			("C,connectivity", "Pixel connectivity: 4 or 8", cxxopts::value<std::string>()->default_value("8"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		const auto size{result["size"].as<std::size_t>()};
+		const auto shapeString{result["shape"].as<std::string>()};
+		const auto shape{vl::filters::to_shape(shapeString)};
+		if (!shape)
+		{
+			fmt::println("Invalid shape name: {}", shapeString);
+			return false;
+		}
+		const auto connectivityString{result["connectivity"].as<std::string>()};
+		const auto connectivity{vl::filters::to_connectivity(connectivityString)};
+		if (!connectivity)
+		{
+			fmt::println("Invalid connectivity: {}", connectivityString);
+			return false;
+		}
+
+		if (filter == "opening-by-reconstruction")
+			vl::filters::opening_by_reconstruction(image, *shape, size, *connectivity);
+		else
+			vl::filters::closing_by_reconstruction(image, *shape, size, *connectivity);
+	}
+	else if (filter == "fill-holes" || filter == "regional-maxima" || filter == "regional-minima")
+	{
+		cxxopts::Options options{"Reconstruction based filter"};
+		options.add_options()
+			("C,connectivity", "Pixel connectivity: 4 or 8", cxxopts::value<std::string>()->default_value("8"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		const auto connectivityString{result["connectivity"].as<std::string>()};
+		const auto connectivity{vl::filters::to_connectivity(connectivityString)};
+		if (!connectivity)
+		{
+			fmt::println("Invalid connectivity: {}", connectivityString);
+			return false;
+		}
+
+		if (filter == "fill-holes")
+			vl::filters::fill_holes(image, *connectivity);
+		else if (filter == "regional-maxima")
+			vl::filters::regional_maxima(image, *connectivity);
+		else
+			vl::filters::regional_minima(image, *connectivity);
+	}
+	else if (filter == "distance")
+	{
+		cxxopts::Options options{"Euclidean distance transform"};
+		options.add_options()
+			("T,threshold", "Lowest foreground value", cxxopts::value<int>()->default_value("128"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		vl::filters::distance_transform(image, std::clamp(result["threshold"].as<int>(), 0, 255));
+	}
+	else if (filter == "binary-erosion" || filter == "binary-dilation")
+	{
+		cxxopts::Options options{"Binary morphology with circular element"};
+		options.add_options()
+			("r,radius", "Element radius", cxxopts::value<double>()->default_value("3"))
+			("T,threshold", "Lowest foreground value", cxxopts::value<int>()->default_value("128"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		const double radius{result["radius"].as<double>()};
+		const vl::byte threshold = std::clamp(result["threshold"].as<int>(), 0, 255);
+		if (filter == "binary-erosion")
+			vl::filters::binary_erosion(image, radius, threshold);
+		else
+			vl::filters::binary_dilation(image, radius, threshold);
+	}
+	else if (filter == "top-hat")
+	{
+		cxxopts::Options options{"Top hat filter"};
+		options.add_options()
+			("I,inner-radius", "Inner cirlce radius", cxxopts::value<int>()->default_value("3"))
+			("O,outter-radius", "Outter cirlce radius", cxxopts::value<int>()->default_value("5"))
+			("T,threshold", "Threshold", cxxopts::value<std::size_t>()->default_value("10"))
+			("D,dark", "Fill with dark", cxxopts::value<int>()->default_value("1"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		const int inner_radius{result["inner-radius"].as<int>()};
+		const int outter_radius{result["outter-radius"].as<int>()};
+		const std::size_t threshold{result["threshold"].as<std::size_t>()};
+		const int dark{result["dark"].as<int>()};
+
+		vl::filters::top_hat(image, inner_radius, outter_radius, threshold, dark);
+	}
+	else if (filter == "rolling-ball")
+	{
+		cxxopts::Options options{"Rolling ball filter"};
+		options.add_options()
+			("I,inner-radius", "Inner cirlce radius", cxxopts::value<int>()->default_value("3"))
+			("O,outter-radius", "Outter cirlce radius", cxxopts::value<int>()->default_value("5"))
+			("T,threshold", "Threshold", cxxopts::value<std::size_t>()->default_value("10"))
+			("D,dark", "Fill with dark", cxxopts::value<int>()->default_value("1"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		const int inner_radius{result["inner-radius"].as<int>()};
+		const int outter_radius{result["outter-radius"].as<int>()};
+		const std::size_t threshold{result["threshold"].as<std::size_t>()};
+		const int dark{result["dark"].as<int>()};
+
+		vl::filters::rolling_ball(image, inner_radius, outter_radius, threshold, dark);
+	}
+	else if (filter == "variance")
+	{
+		cxxopts::Options options{"Variance filter"};
+		options.add_options()
+			("s,size", "Window size", cxxopts::value<std::size_t>()->default_value("3"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		const auto size{result["size"].as<std::size_t>()};
+		vl::filters::variance(image, size);
+	}
+	else if (filter == "kuwahara")
+	{
+		cxxopts::Options options{"Kuwahara filter"};
+		options.add_options()
+			("r,radius", "Quadrant radius", cxxopts::value<std::size_t>()->default_value("2"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		vl::filters::kuwahara(image, result["radius"].as<std::size_t>());
+	}
+	else if (filter == "horizontal-edges")
+	{
+		vl::filters::horizontal_edges(image);
+	}
+	else if (filter == "vertical-edges")
+	{
+		vl::filters::vertical_edges(image);
+	}
+	else if (filter == "roberts-cross")
+	{
+		vl::filters::roberts_cross(image);
+	}
+	else if (filter == "sobel")
+	{
+		vl::filters::sobel(image);
+	}
+	else if (filter == "canny")
+	{
+		cxxopts::Options options{"Canny edge detection"};
+		options.add_options()
+			("l,low", "Low gradient threshold", cxxopts::value<std::size_t>()->default_value("50"))
+			("H,high", "High gradient threshold", cxxopts::value<std::size_t>()->default_value("150"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		vl::filters::canny(image, result["low"].as<std::size_t>(), result["high"].as<std::size_t>());
+	}
+	else if (filter == "unsharp-mask")
+	{
+		cxxopts::Options options{"Unsharp mask"};
+		options.add_options()
+			("d,std-dev", "Blur standard deviation", cxxopts::value<double>()->default_value("2"))
+			("a,amount", "Sharpening amount", cxxopts::value<double>()->default_value("1"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		vl::filters::unsharp_mask(image, result["std-dev"].as<double>(), result["amount"].as<double>());
+	}
+	else if (filter == "dog")
+	{
+		cxxopts::Options options{"Difference of Gaussians"};
+		options.add_options()
+			("s,small-std-dev", "Standard deviation of the narrow Gaussian", cxxopts::value<double>()->default_value("1"))
+			("l,large-std-dev", "Standard deviation of the wide Gaussian", cxxopts::value<double>()->default_value("2"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		vl::filters::difference_of_gaussians(image, result["small-std-dev"].as<double>(),
+			result["large-std-dev"].as<double>());
+	}
+	else if (filter == "laplacian")
+	{
+		cxxopts::Options options{"Laplacian of Gaussian"};
+		options.add_options()
+			("d,std-dev", "Standard deviation", cxxopts::value<double>()->default_value("1"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		vl::filters::laplacian(image, result["std-dev"].as<double>());
+	}
+	else if (const auto lut{stage_lut(filter, unmatched)})
+	{
+		lut->apply(image);
+	}
+	else if (filter == "equalize")
+	{
+		vl::filters::histogram_equalization(image);
+	}
+	else if (filter == "local-equalize")
+	{
+		cxxopts::Options options{"Local histogram equalization"};
+		options.add_options()
+			("t,tile-size", "Tile size", cxxopts::value<std::size_t>()->default_value("64"))
+			("l,clip-limit", "Contrast clip limit, 0 disables clipping", cxxopts::value<double>()->default_value("2"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		vl::filters::local_histogram_equalization(image, result["tile-size"].as<std::size_t>(),
+			result["clip-limit"].as<double>());
+	}
+	else if (filter == "transfer")
+	{
+		cxxopts::Options options{"Transfer function"};
+		options.add_options()
+			("p,points", "Transfer function points: in:out,in:out,...", cxxopts::value<std::string>()->default_value("0:0,255:255"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		std::vector<std::pair<vl::byte, vl::byte>> points;
+		for (const auto pointRange : std::views::split(result["points"].as<std::string>(), ','))
+		{
+			const std::string point{pointRange.begin(), pointRange.end()};
+			const auto separator{point.find(':')};
+			if (separator == std::string::npos)
+			{
+				fmt::println("Invalid transfer function point: {}", point);
+				return false;
+			}
+			points.emplace_back(std::stoi(point.substr(0, separator)), std::stoi(point.substr(separator + 1)));
+		}
+
+		vl::filters::transfer_function(image, vl::filters::impl::piecewise_linear_transfer(points));
+	}
+	else if (filter == "stack")
+	{
+		cxxopts::Options options{"Image combination"};
+		options.add_options()
+			("F,frames", "Comma separated frames to combine with the input", cxxopts::value<std::string>())
+			("m,mode", "Combination mode: mean, median, min or max", cxxopts::value<std::string>()->default_value("mean"))
+			("b,median-bins", "Histogram bins per value for long median stacks, 256 is exact", cxxopts::value<std::size_t>()->default_value("256"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		const auto modeString{result["mode"].as<std::string>()};
+		const auto mode{vl::to_stack_mode(modeString)};
+		if (!mode)
+		{
+			fmt::println("Invalid stack mode: {}", modeString);
+			return false;
+		}
+
+		std::vector<std::string> frames;
+		for (const auto frameRange : std::views::split(result["frames"].as<std::string>(), ','))
+			frames.emplace_back(frameRange.begin(), frameRange.end());
+
+		vl::ImageIO::AsyncIO io;
+		io.prefetch(frames);
+
+		vl::Stacker stacker{*mode, result["median-bins"].as<std::size_t>()};
+		stacker.add(image);
+		for (const auto &frame : frames)
+		{
+			const auto readFrame{io.read_png(frame)};
+			if (!readFrame)
+			{
+				fmt::println("Failed to read:\n{}", readFrame.error().description);
+				return false;
+			}
+			stacker.add(*readFrame);
+		}
+
+		image = stacker.result();
+	}
+	else if (filter == "resize")
+	{
+		cxxopts::Options options{"Resize"};
+		options.add_options()
+			("W,width", "Result width", cxxopts::value<std::size_t>())
+			("H,height", "Result height", cxxopts::value<std::size_t>())
+			("m,method", "Interpolation method: nearest, bilinear or bicubic", cxxopts::value<std::string>()->default_value("bilinear"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		const auto methodString{result["method"].as<std::string>()};
+		const auto method{vl::transform::to_interpolation(methodString)};
+		if (!method)
+		{
+			fmt::println("Invalid interpolation method: {}", methodString);
+			return false;
+		}
+
+		image = vl::transform::resize(image, result["width"].as<std::size_t>(),
+			result["height"].as<std::size_t>(), *method);
+	}
+	else if (filter == "align")
+	{
+		cxxopts::Options options{"Align by 3 points"};
+		options.add_options()
+			("F,from", "Source points: x1,y1,x2,y2,x3,y3", cxxopts::value<std::string>())
+			("T,to", "Destination points: x1,y1,x2,y2,x3,y3", cxxopts::value<std::string>())
+			("m,method", "Interpolation method: nearest, bilinear or bicubic", cxxopts::value<std::string>()->default_value("bilinear"));
+		const auto args{create_args_from_unmatched(unmatched)};
+		const auto result{options.parse(args.size(), args.data())};
+
+		const auto from{parse_points(result["from"].as<std::string>())};
+		const auto to{parse_points(result["to"].as<std::string>())};
+		if (!from || !to)
+		{
+			fmt::println("Expected 3 points in x1,y1,x2,y2,x3,y3 format");
+			return false;
+		}
+
+		const auto methodString{result["method"].as<std::string>()};
+		const auto method{vl::transform::to_interpolation(methodString)};
+		if (!method)
+		{
+			fmt::println("Invalid interpolation method: {}", methodString);
+			return false;
+		}
+
+		const auto transform{vl::transform::AffineTransform::from_points(*from, *to)};
+		if (!transform)
+		{
+			fmt::println("Points are collinear, can't align by them");
+			return false;
+		}
+
+		image = vl::transform::warp_affine(image, *transform, image.width(), image.height(), *method);
+	}
+	else
+	{
+		fmt::println("Unrecognized option filter: {}", filter);
+		return false;
+	}
+
+	return true;
+}
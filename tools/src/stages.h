@@ -0,0 +1,20 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "image.h"
+#include "lut.h"
+
+struct Stage
+{
+	std::string filter;
+	std::vector<std::string> arguments;
+};
+
+std::optional<Stage> parse_stage(const std::string &description);
+std::vector<std::string> extract_stages(int &argc, char **argv);
+
+std::optional<vl::Lut> stage_lut(const std::string &filter, std::vector<std::string> &unmatched);
+bool apply_stage(vl::Image &image, const std::string &filter, std::vector<std::string> &unmatched);
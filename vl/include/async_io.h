@@ -0,0 +1,49 @@
+#pragma once
+
+#include "defs.h"
+
+#include <expected>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "image.h"
+#include "image_io.h"
+
+namespace vl::ImageIO
+{
+	enum class Backend
+	{
+		Auto,
+		IoUring,
+		Threads
+	};
+
+	class AsyncIO
+	{
+	public:
+		explicit AsyncIO(std::size_t readAhead=4, Backend backend=Backend::Auto);
+		~AsyncIO();
+
+		AsyncIO(const AsyncIO &) = delete;
+		AsyncIO &operator=(const AsyncIO &) = delete;
+
+		void prefetch(const std::string &path);
+		void prefetch(const std::vector<std::string> &paths);
+
+		std::expected<std::vector<byte>, ReadError> read(const std::string &path);
+		std::expected<vl::Image, ReadError> read_png(const std::string &path, ColorMode mode=ColorMode::Grayscale);
+
+		void write(std::vector<byte> &&bytes, const std::string &path);
+		std::expected<void, WriteError> write_png(const vl::Image &image, const std::string &path);
+
+		std::vector<WriteError> flush();
+
+		Backend backend() const;
+
+		class Impl;
+
+	private:
+		std::unique_ptr<Impl> m_impl;
+	};
+}
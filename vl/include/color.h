@@ -0,0 +1,19 @@
+#pragma once
+
+#include "defs.h"
+
+#include <cstdint>
+
+#include "image.h"
+
+namespace vl::color
+{
+	vl::Image to_grayscale(const vl::Image &image);
+
+	namespace impl
+	{
+		void rgb_to_gray_row(const byte *source, byte *destination, std::size_t width);
+		void rgba_to_gray_row(const byte *source, byte *destination, std::size_t width);
+		void gray16_to_gray8_row(const std::uint16_t *source, byte *destination, std::size_t width);
+	}
+}
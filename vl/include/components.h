@@ -0,0 +1,100 @@
+#pragma once
+
+#include "defs.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "filters.h"
+#include "image.h"
+
+namespace vl
+{
+	struct Component
+	{
+		std::uint32_t label{0};
+		std::size_t area{0};
+		std::size_t x{0};
+		std::size_t y{0};
+		std::size_t width{0};
+		std::size_t height{0};
+		double centroidX{0};
+		double centroidY{0};
+		double meanIntensity{0};
+	};
+
+	class LabelImage
+	{
+	public:
+		LabelImage(std::size_t width=0, std::size_t height=0)
+			: m_width{width}
+			, m_height{height}
+			, m_labels(width * height)
+		{
+		}
+
+		inline std::size_t width() const
+		{
+			return m_width;
+		}
+
+		inline std::size_t height() const
+		{
+			return m_height;
+		}
+
+		inline std::uint32_t operator[](std::size_t x, std::size_t y) const
+		{
+			return m_labels[y * m_width + x];
+		}
+
+		inline std::uint32_t &operator[](std::size_t x, std::size_t y)
+		{
+			return m_labels[y * m_width + x];
+		}
+
+		inline std::uint32_t *row(std::size_t y)
+		{
+			return m_labels.data() + y * m_width;
+		}
+
+		inline const std::uint32_t *row(std::size_t y) const
+		{
+			return m_labels.data() + y * m_width;
+		}
+
+		inline std::uint32_t *begin()
+		{
+			return m_labels.data();
+		}
+
+		inline const std::uint32_t *begin() const
+		{
+			return m_labels.data();
+		}
+
+		inline std::uint32_t *end()
+		{
+			return m_labels.data() + m_labels.size();
+		}
+
+		inline const std::uint32_t *end() const
+		{
+			return m_labels.data() + m_labels.size();
+		}
+
+	private:
+		std::size_t m_width;
+		std::size_t m_height;
+		std::vector<std::uint32_t> m_labels;
+	};
+
+	struct Components
+	{
+		LabelImage labels;
+		std::vector<Component> components;
+	};
+
+	Components connected_components(const Image &image, byte threshold=128,
+		filters::Connectivity connectivity=filters::Connectivity::Eight);
+}
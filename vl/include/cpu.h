@@ -0,0 +1,22 @@
+#pragma once
+
+#include "defs.h"
+
+#include <optional>
+#include <string>
+
+namespace vl::cpu
+{
+	enum class Level
+	{
+		Baseline,
+		AVX2,
+		AVX512
+	};
+	std::optional<Level> to_level(const std::string &levelString);
+	std::string to_string(Level level);
+
+	Level supported_level();
+	Level level();
+	Level set_level(Level requested);
+}
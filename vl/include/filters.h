@@ -2,8 +2,11 @@
 
 #include "defs.h"
 
+#include <array>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "image.h"
 
@@ -17,6 +20,13 @@ namespace vl::filters
 	};
 	std::optional<Shape> to_shape(const std::string &shapeString);
 
+	enum class Connectivity
+	{
+		Four,
+		Eight
+	};
+	std::optional<Connectivity> to_connectivity(const std::string &connectivityString);
+
 	void gaussian(Image &image, double standardDeviation, std::size_t kernelSize);
 
 	void median(Image &image, std::size_t size, Shape shapeToUse=Shape::Rectangle);
@@ -26,9 +36,38 @@ namespace vl::filters
 	void erosion(Image &image, Shape shape, std::size_t size);
 	void dilation(Image &image, Shape shape, std::size_t size);
 
+	void reconstruction_by_dilation(Image &marker, const Image &mask, Connectivity connectivity=Connectivity::Eight);
+	void reconstruction_by_erosion(Image &marker, const Image &mask, Connectivity connectivity=Connectivity::Eight);
+	void opening_by_reconstruction(Image &image, Shape shape, std::size_t size, Connectivity connectivity=Connectivity::Eight);
+	void closing_by_reconstruction(Image &image, Shape shape, std::size_t size, Connectivity connectivity=Connectivity::Eight);
+	void fill_holes(Image &image, Connectivity connectivity=Connectivity::Eight);
+	void regional_maxima(Image &image, Connectivity connectivity=Connectivity::Eight);
+	void regional_minima(Image &image, Connectivity connectivity=Connectivity::Eight);
+
+	void distance_transform(Image &image, byte threshold=128);
+	void binary_erosion(Image &image, double radius, byte threshold=128);
+	void binary_dilation(Image &image, double radius, byte threshold=128);
+
 	void top_hat(Image &image, int innerRadius, int outterRadius, std::size_t threshold, bool dark=true);
 	void rolling_ball(Image &image, int innerRadius, int outterRadius, std::size_t threshold, bool dark=true);
 
+	void variance(Image &image, std::size_t size);
+	void kuwahara(Image &image, std::size_t radius);
+
+	void horizontal_edges(Image &image);
+	void vertical_edges(Image &image);
+	void roberts_cross(Image &image);
+	void sobel(Image &image);
+	void canny(Image &image, std::size_t lowThreshold, std::size_t highThreshold);
+
+	void unsharp_mask(Image &image, double standardDeviation, double amount);
+	void difference_of_gaussians(Image &image, double smallStandardDeviation, double largeStandardDeviation);
+	void laplacian(Image &image, double standardDeviation);
+
+	void histogram_equalization(Image &image);
+	void transfer_function(Image &image, const std::array<byte, 256> &transfer);
+	void local_histogram_equalization(Image &image, std::size_t tileSize=64, double clipLimit=2.);
+
 	namespace impl
 	{
 		std::vector<bool> create_mask(std::size_t size, Shape shape);
@@ -38,5 +77,9 @@ namespace vl::filters
 		std::vector<bool> generate_rectangle_mask(std::size_t size, std::size_t shapeSize);
 		std::vector<bool> generate_octagon_mask(std::size_t size, std::size_t shapeSize);
 		std::vector<bool> generate_circle_mask(std::size_t size, std::size_t shapeSize);
+
+		std::array<byte, 256> piecewise_linear_transfer(const std::vector<std::pair<byte, byte>> &points);
+		std::array<byte, 256> clipped_equalization_lut(std::array<std::size_t, 256> histogram,
+			std::size_t pixelsCount, double clipLimit);
 	}
 }
@@ -10,8 +10,45 @@ namespace vl
 	enum class PixelFormat
 	{
 		Grayscale8,
+		Grayscale16,
+		RGB8,
+		RGBA8,
 	};
-	std::size_t to_pixel_size(PixelFormat format);
+
+	inline std::size_t to_pixel_size(PixelFormat format)
+	{
+		switch (format)
+		{
+			case PixelFormat::Grayscale8:
+				return 1;
+			case PixelFormat::Grayscale16:
+				return 2;
+			case PixelFormat::RGB8:
+				return 3;
+			case PixelFormat::RGBA8:
+				return 4;
+			default:
+				return 0;
+		}
+	}
+
+	inline std::size_t to_channels_count(PixelFormat format)
+	{
+		switch (format)
+		{
+			case PixelFormat::RGB8:
+				return 3;
+			case PixelFormat::RGBA8:
+				return 4;
+			default:
+				return 1;
+		}
+	}
+
+	inline std::size_t to_color_channels_count(PixelFormat format)
+	{
+		return format == PixelFormat::RGBA8 ? 3 : to_channels_count(format);
+	}
 
 	class Image
 	{
@@ -19,6 +56,13 @@ namespace vl
 		Image(const std::span<byte> &bytes, std::size_t width, std::size_t height, PixelFormat format);
 		Image(std::vector<byte> &&bytes, std::size_t width, std::size_t height, PixelFormat format);
 		Image(std::size_t width, std::size_t height, PixelFormat format);
+		Image(const Image &other);
+		Image(Image &&other) noexcept;
+
+		static Image view(std::span<byte> bytes, std::size_t width, std::size_t height, PixelFormat format);
+
+		Image &operator=(const Image &other);
+		Image &operator=(Image &&other) noexcept;
 
 		inline std::size_t size() const
 		{
@@ -27,39 +71,48 @@ namespace vl
 
 		inline byte &operator[](std::size_t x, std::size_t y)
 		{
-			return m_rawBytes[y * m_width + x];
+			return m_data[(y * m_width + x) * pixel_size()];
 		}
 		inline const byte &operator[](std::size_t x, std::size_t y) const
 		{
-			return m_rawBytes[y * m_width + x];
+			return m_data[(y * m_width + x) * pixel_size()];
+		}
+
+		inline byte *row(std::size_t y)
+		{
+			return m_data + y * m_width * pixel_size();
+		}
+		inline const byte *row(std::size_t y) const
+		{
+			return m_data + y * m_width * pixel_size();
 		}
 
 		inline byte *begin()
 		{
-			return m_rawBytes.data();
+			return m_data;
 		}
 		inline const byte *begin() const
 		{
-			return m_rawBytes.data();
+			return m_data;
 		}
 
 		inline const byte *cbegin() const
 		{
-			return m_rawBytes.data();
+			return m_data;
 		}
 
 		inline byte *end()
 		{
-			return m_rawBytes.data() + m_rawBytes.size();
+			return m_data + size();
 		}
 		inline const byte *end() const
 		{
-			return m_rawBytes.data() + m_rawBytes.size();
+			return m_data + size();
 		}
 
 		inline const byte *cend() const
 		{
-			return m_rawBytes.data() + m_rawBytes.size();
+			return m_data + size();
 		}
 
 		inline std::size_t width() const
@@ -77,12 +130,34 @@ namespace vl
 			return m_format;
 		}
 
+		inline std::size_t pixel_size() const
+		{
+			return to_pixel_size(m_format);
+		}
+
+		inline std::size_t channels() const
+		{
+			return to_channels_count(m_format);
+		}
+
+		inline std::size_t color_channels() const
+		{
+			return to_color_channels_count(m_format);
+		}
+
+		inline bool is_view() const
+		{
+			return m_view;
+		}
+
 	private:
 		PixelFormat m_format;
 		std::size_t m_width;
 		std::size_t m_height;
 
 		std::vector<byte> m_rawBytes;
+		byte *m_data;
+		bool m_view{false};
 	};
 
 }
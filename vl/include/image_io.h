@@ -3,7 +3,9 @@
 #include "defs.h"
 
 #include <expected>
+#include <span>
 #include <string>
+#include <vector>
 
 #include "image.h"
 
@@ -15,6 +17,12 @@ namespace vl::ImageIO
 		FormatError
 	};
 
+	enum class ColorMode
+	{
+		Native,
+		Grayscale
+	};
+
 	struct ReadError
 	{
 		ErrorType type;
@@ -26,6 +34,22 @@ namespace vl::ImageIO
 		std::string description;
 	};
 
-	std::expected<vl::Image, ReadError> read_png(const std::string &path);
+	std::expected<vl::Image, ReadError> read_png(const std::string &path, ColorMode mode=ColorMode::Grayscale);
 	std::expected<void, WriteError> write_png(const vl::Image &image_to_write, const std::string &path);
+
+	std::expected<vl::Image, ReadError> decode_png(std::span<const byte> buffer, ColorMode mode=ColorMode::Grayscale);
+	std::expected<std::vector<byte>, WriteError> encode_png(const vl::Image &image_to_write);
+
+	struct TiledOptions
+	{
+		std::size_t tileWidth{256};
+		std::size_t tileHeight{256};
+		int compressionLevel{1};
+	};
+
+	std::expected<vl::Image, ReadError> read_tiled(const std::string &path);
+	std::expected<vl::Image, ReadError> read_region(const std::string &path,
+		std::size_t x, std::size_t y, std::size_t width, std::size_t height);
+	std::expected<void, WriteError> write_tiled(const vl::Image &image_to_write, const std::string &path,
+		const TiledOptions &options={});
 }
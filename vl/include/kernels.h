@@ -0,0 +1,50 @@
+#pragma once
+
+#include "defs.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vl::kernels
+{
+	struct Table
+	{
+		void (*accumulate_row)(double *sums, const byte *source, double weight, std::size_t count);
+		void (*store_clamped_row)(const double *sums, byte *destination, std::size_t count);
+
+		void (*min_row)(byte *destination, const byte *source, std::size_t count);
+		void (*max_row)(byte *destination, const byte *source, std::size_t count);
+		void (*compare_exchange_rows)(byte *lower, byte *upper, std::size_t count);
+
+		void (*add_row)(byte *destination, const byte *source, std::size_t count);
+		void (*subtract_row)(byte *destination, const byte *source, std::size_t count);
+		void (*multiply_row)(byte *destination, const byte *source, std::size_t count);
+		void (*divide_row)(byte *destination, const byte *source, std::size_t count);
+
+		std::size_t (*lookup_row)(const byte *table, const byte *source, byte *destination, std::size_t count);
+
+		void (*deinterleave_row)(const byte *source, byte *const *planes, std::size_t channels, std::size_t count);
+		void (*interleave_row)(const byte *const *planes, byte *destination, std::size_t channels, std::size_t count);
+
+		void (*to_gray_row)(const byte *source, byte *destination, std::size_t channels, std::size_t count);
+		void (*gray16_to_gray8_row)(const std::uint16_t *source, byte *destination, std::size_t count);
+
+		std::size_t (*sample_bilinear_row)(const byte *pixels, std::size_t width, std::size_t height,
+			const float *xs, const float *ys, byte *destination, std::size_t count);
+	};
+
+	const Table &table();
+
+	namespace baseline
+	{
+		const Table &table();
+	}
+	namespace avx2
+	{
+		const Table &table();
+	}
+	namespace avx512
+	{
+		const Table &table();
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "defs.h"
+
+#include <array>
+#include <vector>
+
+#include "image.h"
+
+namespace vl
+{
+	class Lut
+	{
+	public:
+		static constexpr std::size_t Size{256};
+
+		Lut();
+		explicit Lut(const std::array<byte, Size> &table);
+
+		static Lut threshold(byte level);
+		static Lut gamma(double gamma);
+		static Lut invert();
+
+		inline byte operator[](byte value) const
+		{
+			return m_table[value];
+		}
+		inline byte &operator[](byte value)
+		{
+			return m_table[value];
+		}
+
+		inline const std::array<byte, Size> &table() const
+		{
+			return m_table;
+		}
+
+		Lut then(const Lut &next) const;
+
+		void apply(Image &image) const;
+		void apply_row(const byte *source, byte *destination, std::size_t count) const;
+
+	private:
+		alignas(64) std::array<byte, Size> m_table;
+	};
+
+	class LutPipeline
+	{
+	public:
+		LutPipeline &add(const Lut &lut);
+
+		void apply(Image &image) const;
+
+		inline const Lut &lut() const
+		{
+			return m_composed;
+		}
+
+		inline std::size_t stages_count() const
+		{
+			return m_stagesCount;
+		}
+
+	private:
+		Lut m_composed;
+		std::size_t m_stagesCount{0};
+	};
+}
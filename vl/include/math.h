@@ -2,8 +2,13 @@
 
 #include "defs.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <numeric>
+#include <optional>
+#include <vector>
 
 #include "image.h"
 
@@ -83,21 +88,138 @@ namespace vl::math
 		std::vector<T> m_data;
 	};
 
+	std::optional<Matrix<double>> solve(Matrix<double> coefficients, Matrix<double> constants);
+
+	class Histogram
+	{
+	public:
+		static constexpr std::size_t Bins{256};
+
+		Histogram() = default;
+		explicit Histogram(const Image &image);
+		Histogram(const Image &image, std::size_t x, std::size_t y, std::size_t width, std::size_t height);
+
+		inline std::size_t operator[](std::size_t bin) const
+		{
+			return m_bins[bin];
+		}
+
+		inline const std::array<std::size_t, Bins> &bins() const
+		{
+			return m_bins;
+		}
+
+		inline std::size_t count() const
+		{
+			return m_count;
+		}
+
+		Histogram &operator+=(const Histogram &other);
+
+		double mean() const;
+		double std_dev() const;
+		double entropy() const;
+		double signal_to_noise_ratio() const;
+		byte percentile(double percent) const;
+
+		std::array<byte, Bins> equalization_lut() const;
+
+	private:
+		std::array<std::size_t, Bins> m_bins{};
+		std::size_t m_count{0};
+	};
+
+	class IntegralImage
+	{
+	public:
+		explicit IntegralImage(const Image &image);
+
+		inline std::size_t width() const
+		{
+			return m_width;
+		}
+
+		inline std::size_t height() const
+		{
+			return m_height;
+		}
+
+		inline std::uint64_t box_sum(std::size_t x, std::size_t y, std::size_t width, std::size_t height) const
+		{
+			return box(m_sums, x, y, width, height);
+		}
+
+		inline std::uint64_t box_squared_sum(std::size_t x, std::size_t y, std::size_t width, std::size_t height) const
+		{
+			return box(m_squaredSums, x, y, width, height);
+		}
+
+		inline double box_mean(std::size_t x, std::size_t y, std::size_t width, std::size_t height) const
+		{
+			return (double)box_sum(x, y, width, height) / (width * height);
+		}
+
+		inline double box_variance(std::size_t x, std::size_t y, std::size_t width, std::size_t height) const
+		{
+			const double count = width * height;
+			const double mean{box_sum(x, y, width, height) / count};
+			return std::max(box_squared_sum(x, y, width, height) / count - mean * mean, 0.);
+		}
+
+	private:
+		inline std::uint64_t box(const std::vector<std::uint64_t> &table,
+			std::size_t x, std::size_t y, std::size_t width, std::size_t height) const
+		{
+			const std::size_t stride{m_width + 1};
+			const std::size_t top{y * stride};
+			const std::size_t bottom{(y + height) * stride};
+			return table[bottom + x + width] - table[bottom + x] - table[top + x + width] + table[top + x];
+		}
+
+		std::size_t m_width;
+		std::size_t m_height;
+		std::vector<std::uint64_t> m_sums;
+		std::vector<std::uint64_t> m_squaredSums;
+	};
+
+	struct Statistics
+	{
+		std::size_t count{0};
+		double min{0};
+		double max{0};
+		double sum{0};
+		double sumOfSquares{0};
+		double mean{0};
+		double stdDev{0};
+
+		Statistics &operator+=(const Statistics &other);
+	};
+
+	Statistics statistics(const Image &image);
+	Statistics statistics(const Image &image, std::size_t x, std::size_t y, std::size_t width, std::size_t height);
+
 	double entropy(const Image &image);
 	double signal_to_noise_ratio(const Image &image);
 
+	std::vector<std::uint32_t> squared_distance_transform(const Image &image, byte threshold=128, bool toBackground=false);
+
 	template<typename Iter>
 	std::pair<double, double> get_mean_std_dev(Iter begin, Iter end)
 	{
-		const std::size_t count{std::distance(begin, end)};
-		const double mean = (double)std::accumulate(begin, end, 0) / count;
-
-		double std_dev{0};
+		std::size_t count{0};
+		double mean{0};
+		double squaredDeviations{0};
 		for (auto it = begin; it != end; ++it)
-			std_dev += std::pow((double) *it - mean, 2.);
-		std_dev = std::sqrt(std_dev / count);
+		{
+			const double value = *it;
+			const double delta{value - mean};
+			mean += delta / ++count;
+			squaredDeviations += delta * (value - mean);
+		}
+		if (count == 0)
+			return {0, 0};
 
-		return {mean, std_dev};
+		return {mean, std::sqrt(squaredDeviations / count)};
 	}
 	template<typename ContainerT>
 	inline std::pair<double, double> get_mean_std_dev(const ContainerT &container)
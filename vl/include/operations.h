@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdexcept>
+
 #include <fmt/format.h>
 
 #include "image.h"
@@ -28,6 +30,9 @@ namespace vl
 			if (lImage.format() != rImage.format())
 				throw std::logic_error{fmt::format("Wrong image formats specified: {} to {}",
 					static_cast<int>(lImage.format()), static_cast<int>(rImage.format()))};
+
+			if (lImage.format() == vl::PixelFormat::Grayscale16)
+				throw std::logic_error{"Unsupported image format for arithmetic: Grayscale16"};
 		}
 	}
 }
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "defs.h"
+
+#include <cstddef>
+#include <functional>
+
+namespace vl::parallel
+{
+	std::size_t thread_count();
+	void set_thread_count(std::size_t count);
+
+	void for_range(std::size_t begin, std::size_t end,
+		const std::function<void(std::size_t, std::size_t)> &body, std::size_t grain=1);
+
+	template<typename Body>
+	inline void for_each(std::size_t begin, std::size_t end, Body &&body)
+	{
+		for_range(begin, end, [&](std::size_t chunkBegin, std::size_t chunkEnd)
+		{
+			for (std::size_t i = chunkBegin; i < chunkEnd; ++i)
+				body(i);
+		});
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "defs.h"
+
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "image.h"
+
+namespace vl
+{
+	class PlanarImage
+	{
+	public:
+		PlanarImage(std::size_t width, std::size_t height, PixelFormat format);
+		explicit PlanarImage(const Image &image);
+
+		static PlanarImage view(std::span<byte> bytes, std::size_t width, std::size_t height, PixelFormat format);
+
+		void load(const Image &image);
+		void store(Image &image) const;
+		Image interleaved() const;
+
+		inline std::size_t width() const
+		{
+			return m_width;
+		}
+
+		inline std::size_t height() const
+		{
+			return m_height;
+		}
+
+		inline PixelFormat format() const
+		{
+			return m_format;
+		}
+
+		inline std::size_t channels() const
+		{
+			return m_planes.size();
+		}
+
+		inline Image &plane(std::size_t channel)
+		{
+			return m_planes[channel];
+		}
+		inline const Image &plane(std::size_t channel) const
+		{
+			return m_planes[channel];
+		}
+
+	private:
+		PlanarImage() = default;
+
+		PixelFormat m_format{PixelFormat::Grayscale8};
+		std::size_t m_width{0};
+		std::size_t m_height{0};
+		std::vector<Image> m_planes;
+	};
+
+	namespace impl
+	{
+		void for_each_plane(Image &image, const std::function<void(Image &)> &body);
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "defs.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vl::profiling
+{
+#ifdef VL_PROFILING
+	constexpr bool Available{true};
+#else
+	constexpr bool Available{false};
+#endif
+
+	struct Event
+	{
+		const char *name;
+		std::uint64_t start;
+		std::uint64_t duration;
+		std::size_t pixels;
+		std::size_t bytesAllocated;
+		std::size_t thread;
+	};
+
+	struct StageSummary
+	{
+		std::string name;
+		std::size_t calls;
+		std::uint64_t duration;
+		std::size_t pixels;
+		std::size_t bytesAllocated;
+	};
+
+	namespace impl
+	{
+		inline std::atomic<bool> enabled{false};
+		inline thread_local std::size_t allocatedBytes{0};
+		std::uint64_t now();
+	}
+
+	inline bool enabled()
+	{
+		return impl::enabled.load(std::memory_order_relaxed);
+	}
+	void set_enabled(bool enable);
+
+	inline void record_allocation(std::size_t bytes)
+	{
+		if (enabled())
+			impl::allocatedBytes += bytes;
+	}
+
+	std::vector<Event> events();
+	std::vector<StageSummary> summary();
+	std::string chrome_trace();
+	void clear();
+
+	class Scope
+	{
+	public:
+		inline explicit Scope(const char *name, std::size_t pixels=0)
+			: m_name{name}
+			, m_pixels{pixels}
+			, m_active{enabled()}
+		{
+			if (m_active)
+			{
+				m_allocatedBytes = impl::allocatedBytes;
+				m_start = impl::now();
+			}
+		}
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+		inline ~Scope()
+		{
+			if (m_active)
+				finish();
+		}
+
+		inline void set_pixels(std::size_t pixels)
+		{
+			m_pixels = pixels;
+		}
+
+	private:
+		void finish();
+
+		const char *m_name;
+		std::size_t m_pixels;
+		bool m_active;
+		std::size_t m_allocatedBytes{0};
+		std::uint64_t m_start{0};
+	};
+}
+
+#ifdef VL_PROFILING
+#define VL_PROFILE_SCOPE(name, pixels) vl::profiling::Scope profileScope{name, pixels}
+#define VL_PROFILE_PIXELS(pixels) profileScope.set_pixels(pixels)
+#define VL_PROFILE_ALLOCATION(bytes) vl::profiling::record_allocation(bytes)
+#else
+#define VL_PROFILE_SCOPE(name, pixels) (void)0
+#define VL_PROFILE_PIXELS(pixels) (void)0
+#define VL_PROFILE_ALLOCATION(bytes) (void)0
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "defs.h"
+
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "image.h"
+#include "transform.h"
+
+namespace vl
+{
+	enum class ReduceMethod
+	{
+		Box,
+		Binomial
+	};
+
+	class ImagePyramid
+	{
+	public:
+		explicit ImagePyramid(Image base, ReduceMethod method=ReduceMethod::Binomial, std::size_t memoryLimit=0);
+
+		const Image &level(std::size_t index);
+
+		vl::Image apply(std::size_t index, const std::function<void(Image &)> &filter,
+			transform::Interpolation interpolation=transform::Interpolation::Bilinear);
+
+		void release(std::size_t index);
+
+		inline std::size_t levels_count() const
+		{
+			return m_levels.size();
+		}
+
+		inline std::size_t memory_usage() const
+		{
+			return m_memoryUsage;
+		}
+
+		inline std::size_t memory_limit() const
+		{
+			return m_memoryLimit;
+		}
+		void set_memory_limit(std::size_t limit);
+
+	private:
+		void evict(std::size_t keep);
+
+		ReduceMethod m_method;
+		std::size_t m_memoryLimit;
+		std::size_t m_memoryUsage{0};
+		std::size_t m_clock{0};
+
+		std::vector<std::optional<Image>> m_levels;
+		std::vector<std::size_t> m_lastUse;
+	};
+
+	namespace impl
+	{
+		vl::Image reduce(const Image &image, ReduceMethod method);
+	}
+}
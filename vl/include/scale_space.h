@@ -0,0 +1,47 @@
+#pragma once
+
+#include "defs.h"
+
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "image.h"
+
+namespace vl
+{
+	class ScaleSpace
+	{
+	public:
+		explicit ScaleSpace(const Image &image, double baseSigma=0);
+
+		const Image &level(double sigma);
+
+		vl::Image difference_of_gaussians(double smallSigma, double largeSigma);
+		vl::Image unsharp_mask(double sigma, double amount);
+		vl::Image laplacian(double sigma);
+
+		inline std::size_t levels_count() const
+		{
+			return m_levels.size();
+		}
+
+	private:
+		struct Level
+		{
+			std::vector<float> values;
+			std::optional<Image> image;
+		};
+
+		Level &blurred_level(double sigma);
+
+		std::size_t m_width;
+		std::size_t m_height;
+		std::map<double, Level> m_levels;
+	};
+
+	namespace impl
+	{
+		vl::Image gaussian_blur(const Image &image, double sigma);
+	}
+}
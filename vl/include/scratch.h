@@ -0,0 +1,31 @@
+#pragma once
+
+#include "defs.h"
+
+#include <memory>
+
+#include "image.h"
+
+namespace vl
+{
+	class ScratchImage
+	{
+	public:
+		explicit ScratchImage(const Image &source);
+		~ScratchImage();
+
+		ScratchImage(const ScratchImage &) = delete;
+		ScratchImage &operator=(const ScratchImage &) = delete;
+
+		inline const Image &image() const
+		{
+			return *m_image;
+		}
+
+		static std::size_t pooled_bytes();
+		static void release_pool();
+
+	private:
+		std::unique_ptr<Image> m_image;
+	};
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "defs.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "image.h"
+
+namespace vl
+{
+	enum class StackMode
+	{
+		Mean,
+		Median,
+		Min,
+		Max
+	};
+	std::optional<StackMode> to_stack_mode(const std::string &modeString);
+
+	class Stacker
+	{
+	public:
+		static constexpr std::size_t MaxMedianFrames{65535};
+
+		explicit Stacker(StackMode mode, std::size_t medianBins=256);
+
+		void add(const Image &frame);
+		vl::Image result() const;
+
+		inline std::size_t frames_count() const
+		{
+			return m_framesCount;
+		}
+
+		inline StackMode mode() const
+		{
+			return m_mode;
+		}
+
+		std::size_t memory_usage() const;
+
+	private:
+		struct MedianTile
+		{
+			std::size_t x{0};
+			std::size_t y{0};
+			std::size_t width{0};
+			std::size_t height{0};
+			std::vector<byte> values;
+			std::vector<std::uint16_t> histograms;
+		};
+
+		void add_median(const Image &frame);
+		void median_result(Image &combined) const;
+
+		StackMode m_mode;
+		std::size_t m_medianBins;
+		std::size_t m_binShift{0};
+
+		std::size_t m_width{0};
+		std::size_t m_height{0};
+		PixelFormat m_format{PixelFormat::Grayscale8};
+		std::size_t m_framesCount{0};
+
+		std::vector<std::uint32_t> m_sums;
+		std::vector<byte> m_extremes;
+		std::vector<MedianTile> m_tiles;
+		bool m_medianHistograms{false};
+	};
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "defs.h"
+
+#include <array>
+#include <optional>
+#include <string>
+
+#include "image.h"
+#include "math.h"
+
+namespace vl::transform
+{
+	enum class Interpolation
+	{
+		Nearest,
+		Bilinear,
+		Bicubic
+	};
+	std::optional<Interpolation> to_interpolation(const std::string &interpolationString);
+
+	struct Point
+	{
+		double x;
+		double y;
+	};
+
+	class AffineTransform
+	{
+	public:
+		AffineTransform();
+		explicit AffineTransform(const math::Matrix<double> &matrix);
+
+		static std::optional<AffineTransform> from_points(const std::array<Point, 3> &source,
+			const std::array<Point, 3> &destination);
+		static AffineTransform scale(double xScale, double yScale);
+
+		std::optional<AffineTransform> inverse() const;
+
+		inline Point operator()(const Point &point) const
+		{
+			return {
+				m_matrix[0, 0] * point.x + m_matrix[0, 1] * point.y + m_matrix[0, 2],
+				m_matrix[1, 0] * point.x + m_matrix[1, 1] * point.y + m_matrix[1, 2]
+			};
+		}
+
+		inline const math::Matrix<double> &matrix() const
+		{
+			return m_matrix;
+		}
+
+	private:
+		math::Matrix<double> m_matrix;
+	};
+
+	vl::Image warp_affine(const Image &image, const AffineTransform &transform,
+		std::size_t width, std::size_t height, Interpolation interpolation=Interpolation::Bilinear);
+	vl::Image resize(const Image &image, std::size_t width, std::size_t height,
+		Interpolation interpolation=Interpolation::Bilinear);
+}
@@ -0,0 +1,606 @@
+#include "async_io.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#ifdef VL_HAS_IO_URING
+#include <liburing.h>
+#endif
+
+namespace
+{
+	using ReadResult = std::expected<std::vector<vl::byte>, vl::ImageIO::ReadError>;
+
+	struct Job
+	{
+		enum class Kind
+		{
+			Read,
+			Write
+		};
+
+		Kind kind;
+		std::string path;
+		std::vector<vl::byte> bytes;
+	};
+
+	vl::ImageIO::ReadError make_read_error(const std::string &path, int error)
+	{
+		return {vl::ImageIO::ErrorType::IOError,
+			fmt::format("Failed to read {}: {}", path, std::strerror(error))
+		};
+	}
+
+	vl::ImageIO::WriteError make_write_error(const std::string &path, int error)
+	{
+		return {vl::ImageIO::ErrorType::IOError,
+			fmt::format("Failed writing to {}: {}", path, std::strerror(error))
+		};
+	}
+
+#ifdef VL_HAS_IO_URING
+	int open_for(const Job &job)
+	{
+		if (job.kind == Job::Kind::Read)
+			return open(job.path.c_str(), O_RDONLY | O_CLOEXEC);
+		return open(job.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	}
+#endif
+
+	ReadResult read_file(const std::string &path)
+	{
+		const int fd{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+		if (fd < 0)
+			return std::unexpected{make_read_error(path, errno)};
+
+		struct stat info{};
+		if (fstat(fd, &info) != 0)
+		{
+			const int error{errno};
+			close(fd);
+			return std::unexpected{make_read_error(path, error)};
+		}
+
+		std::vector<vl::byte> bytes(info.st_size);
+		std::size_t offset{0};
+		while (offset < bytes.size())
+		{
+			const ssize_t readBytes{pread(fd, bytes.data() + offset, bytes.size() - offset, offset)};
+			if (readBytes < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				const int error{errno};
+				close(fd);
+				return std::unexpected{make_read_error(path, error)};
+			}
+			if (readBytes == 0)
+				break;
+
+			offset += readBytes;
+		}
+		close(fd);
+
+		bytes.resize(offset);
+		return bytes;
+	}
+
+	std::optional<vl::ImageIO::WriteError> write_file(const std::string &path, const std::vector<vl::byte> &bytes)
+	{
+		const int fd{open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)};
+		if (fd < 0)
+			return make_write_error(path, errno);
+
+		std::size_t offset{0};
+		while (offset < bytes.size())
+		{
+			const ssize_t writtenBytes{pwrite(fd, bytes.data() + offset, bytes.size() - offset, offset)};
+			if (writtenBytes < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				const int error{errno};
+				close(fd);
+				return make_write_error(path, error);
+			}
+			if (writtenBytes == 0)
+			{
+				close(fd);
+				return make_write_error(path, EIO);
+			}
+			offset += writtenBytes;
+		}
+
+		if (close(fd) != 0)
+			return make_write_error(path, errno);
+
+		return {};
+	}
+}
+
+namespace vl::ImageIO
+{
+	class AsyncIO::Impl
+	{
+	public:
+		Impl(std::size_t readAhead, Backend backend)
+			: m_readAhead{std::max<std::size_t>(readAhead, 1)}
+		{
+#ifdef VL_HAS_IO_URING
+			if (backend != Backend::Threads
+				&& io_uring_queue_init(QueueDepth, &m_ring, 0) == 0)
+			{
+				m_backend = Backend::IoUring;
+				m_workers.emplace_back([this]{ run_uring(); });
+				return;
+			}
+#endif
+			if (backend == Backend::IoUring)
+				fmt::println("io_uring is not available, falling back to threaded IO");
+
+			m_backend = Backend::Threads;
+			for (std::size_t i = 0; i < m_readAhead; ++i)
+				m_workers.emplace_back([this]{ run_threads(); });
+		}
+
+		~Impl()
+		{
+			{
+				std::lock_guard lock{m_mutex};
+				m_pendingReads.clear();
+				m_stop = true;
+			}
+			m_workAvailable.notify_all();
+			m_workers.clear();
+
+#ifdef VL_HAS_IO_URING
+			if (m_backend == Backend::IoUring)
+				io_uring_queue_exit(&m_ring);
+#endif
+		}
+
+		void prefetch(const std::string &path)
+		{
+			{
+				std::lock_guard lock{m_mutex};
+				m_prefetched[path] = m_nextSequence++;
+				if (m_reads.contains(path)
+					|| std::ranges::find(m_pendingReads, path) != m_pendingReads.end())
+					return;
+
+				m_pendingReads.push_back(path);
+			}
+			m_workAvailable.notify_one();
+		}
+
+		ReadResult read(const std::string &path)
+		{
+			std::unique_lock lock{m_mutex};
+			if (!m_reads.contains(path))
+			{
+				const auto pending{std::ranges::find(m_pendingReads, path)};
+				if (pending != m_pendingReads.end())
+					m_pendingReads.erase(pending);
+				m_pendingReads.push_front(path);
+			}
+			++m_awaited[path];
+			m_workAvailable.notify_all();
+
+			m_jobFinished.wait(lock, [&]{
+				const auto read{m_reads.find(path)};
+				return read != m_reads.end() && read->second.has_value();
+			});
+
+			const auto read{m_reads.find(path)};
+			ReadResult result{std::move(*read->second)};
+			m_reads.erase(read);
+			--m_readsReady;
+			const auto awaited{m_awaited.find(path)};
+			if (--awaited->second == 0)
+				m_awaited.erase(awaited);
+			else if (std::ranges::find(m_pendingReads, path) == m_pendingReads.end())
+				m_pendingReads.push_front(path);
+
+			const auto prefetched{m_prefetched.find(path)};
+			if (prefetched != m_prefetched.end())
+			{
+				m_consumedSequence = std::max(m_consumedSequence, prefetched->second);
+				m_prefetched.erase(prefetched);
+				drop_superseded();
+			}
+
+			lock.unlock();
+			m_workAvailable.notify_one();
+
+			return result;
+		}
+
+		void write(std::vector<byte> &&bytes, const std::string &path)
+		{
+			{
+				std::lock_guard lock{m_mutex};
+				m_pendingWrites.push_back({Job::Kind::Write, path, std::move(bytes)});
+			}
+			m_workAvailable.notify_one();
+		}
+
+		std::vector<WriteError> flush()
+		{
+			std::unique_lock lock{m_mutex};
+			m_jobFinished.wait(lock, [&]{
+				return m_pendingWrites.empty() && m_writesInFlight == 0;
+			});
+
+			return std::exchange(m_writeErrors, {});
+		}
+
+		Backend backend() const
+		{
+			return m_backend;
+		}
+
+	private:
+		bool is_superseded(const std::string &path) const
+		{
+			const auto prefetched{m_prefetched.find(path)};
+			return prefetched != m_prefetched.end() && prefetched->second < m_consumedSequence
+				&& !m_awaited.contains(path);
+		}
+
+		void drop_superseded()
+		{
+			std::erase_if(m_pendingReads, [&](const std::string &path)
+			{
+				if (!is_superseded(path))
+					return false;
+
+				m_prefetched.erase(path);
+				return true;
+			});
+
+			for (auto read = m_reads.begin(); read != m_reads.end();)
+			{
+				if (read->second.has_value() && is_superseded(read->first))
+				{
+					m_prefetched.erase(read->first);
+					read = m_reads.erase(read);
+					--m_readsReady;
+				}
+				else
+					++read;
+			}
+		}
+
+		bool can_start_read() const
+		{
+			if (m_pendingReads.empty())
+				return false;
+
+			return m_readsInFlight + m_readsReady < m_readAhead
+				|| m_awaited.contains(m_pendingReads.front());
+		}
+
+		bool has_job() const
+		{
+			return can_start_read() || !m_pendingWrites.empty();
+		}
+
+		Job next_job()
+		{
+			if (can_start_read())
+			{
+				Job job{Job::Kind::Read, std::move(m_pendingReads.front()), {}};
+				m_pendingReads.pop_front();
+				m_reads.emplace(job.path, std::nullopt);
+				++m_readsInFlight;
+				return job;
+			}
+
+			Job job{std::move(m_pendingWrites.front())};
+			m_pendingWrites.pop_front();
+			++m_writesInFlight;
+			return job;
+		}
+
+		void finish_read(const std::string &path, ReadResult &&result)
+		{
+			{
+				std::lock_guard lock{m_mutex};
+				--m_readsInFlight;
+				if (is_superseded(path))
+				{
+					m_reads.erase(path);
+					m_prefetched.erase(path);
+				}
+				else
+				{
+					m_reads[path] = std::move(result);
+					++m_readsReady;
+				}
+			}
+			m_jobFinished.notify_all();
+		}
+
+		void finish_write(std::optional<WriteError> &&error)
+		{
+			{
+				std::lock_guard lock{m_mutex};
+				if (error)
+					m_writeErrors.push_back(std::move(*error));
+				--m_writesInFlight;
+			}
+			m_jobFinished.notify_all();
+		}
+
+		void run_threads()
+		{
+			while (true)
+			{
+				std::unique_lock lock{m_mutex};
+				m_workAvailable.wait(lock, [&]{ return m_stop || has_job(); });
+				if (!has_job())
+					return;
+
+				Job job{next_job()};
+				lock.unlock();
+
+				if (job.kind == Job::Kind::Read)
+					finish_read(job.path, read_file(job.path));
+				else
+					finish_write(write_file(job.path, job.bytes));
+			}
+		}
+
+#ifdef VL_HAS_IO_URING
+		static constexpr unsigned QueueDepth{64};
+
+		struct Operation
+		{
+			Job job;
+			int fd;
+			std::size_t offset{0};
+		};
+
+		void submit(Operation &operation)
+		{
+			io_uring_sqe *sqe{io_uring_get_sqe(&m_ring)};
+			if (operation.job.kind == Job::Kind::Read)
+				io_uring_prep_read(sqe, operation.fd, operation.job.bytes.data() + operation.offset,
+					operation.job.bytes.size() - operation.offset, operation.offset);
+			else
+				io_uring_prep_write(sqe, operation.fd, operation.job.bytes.data() + operation.offset,
+					operation.job.bytes.size() - operation.offset, operation.offset);
+			io_uring_sqe_set_data(sqe, &operation);
+		}
+
+		void start(Job &&job, std::vector<std::unique_ptr<Operation>> &operations)
+		{
+			const int fd{open_for(job)};
+			if (fd < 0)
+			{
+				const int error{errno};
+				if (job.kind == Job::Kind::Read)
+					finish_read(job.path, std::unexpected{make_read_error(job.path, error)});
+				else
+					finish_write(make_write_error(job.path, error));
+				return;
+			}
+
+			if (job.kind == Job::Kind::Read)
+			{
+				struct stat info{};
+				if (fstat(fd, &info) != 0)
+				{
+					const int error{errno};
+					close(fd);
+					finish_read(job.path, std::unexpected{make_read_error(job.path, error)});
+					return;
+				}
+				job.bytes.resize(info.st_size);
+			}
+
+			if (job.bytes.empty())
+			{
+				close(fd);
+				complete(Operation{std::move(job), -1}, 0);
+				return;
+			}
+
+			operations.push_back(std::make_unique<Operation>(std::move(job), fd));
+			submit(*operations.back());
+		}
+
+		void complete(Operation &&operation, int error)
+		{
+			if (operation.fd >= 0 && close(operation.fd) != 0 && error == 0
+				&& operation.job.kind == Job::Kind::Write)
+				error = errno;
+
+			if (operation.job.kind == Job::Kind::Read)
+			{
+				if (error != 0)
+					finish_read(operation.job.path, std::unexpected{make_read_error(operation.job.path, error)});
+				else
+				{
+					operation.job.bytes.resize(operation.offset);
+					finish_read(operation.job.path, std::move(operation.job.bytes));
+				}
+			}
+			else
+			{
+				finish_write(error != 0
+					? std::optional{make_write_error(operation.job.path, error)}
+					: std::nullopt);
+			}
+		}
+
+		void run_uring()
+		{
+			std::vector<std::unique_ptr<Operation>> operations;
+			while (true)
+			{
+				std::vector<Job> jobs;
+				{
+					std::unique_lock lock{m_mutex};
+					if (operations.empty())
+					{
+						m_workAvailable.wait(lock, [&]{ return m_stop || has_job(); });
+						if (!has_job())
+							return;
+					}
+
+					while (has_job() && operations.size() + jobs.size() < QueueDepth)
+						jobs.push_back(next_job());
+				}
+
+				for (auto &job : jobs)
+					start(std::move(job), operations);
+				io_uring_submit(&m_ring);
+
+				if (operations.empty())
+					continue;
+
+				io_uring_cqe *cqe{nullptr};
+				if (io_uring_wait_cqe(&m_ring, &cqe) != 0)
+					continue;
+
+				do
+				{
+					auto *operation{static_cast<Operation *>(io_uring_cqe_get_data(cqe))};
+					const int result{cqe->res};
+					io_uring_cqe_seen(&m_ring, cqe);
+
+					if (result == -EINTR || result == -EAGAIN)
+					{
+						submit(*operation);
+						continue;
+					}
+
+					if (result > 0)
+						operation->offset += result;
+
+					if (result > 0 && operation->offset < operation->job.bytes.size())
+					{
+						submit(*operation);
+						continue;
+					}
+
+					int error{result < 0 ? -result : 0};
+					if (result == 0 && operation->job.kind == Job::Kind::Write)
+						error = EIO;
+
+					const auto owned{std::ranges::find_if(operations,
+						[&](const auto &op){ return op.get() == operation; })};
+					complete(std::move(*operation), error);
+					operations.erase(owned);
+				}
+				while (io_uring_peek_cqe(&m_ring, &cqe) == 0);
+
+				io_uring_submit(&m_ring);
+			}
+		}
+
+		io_uring m_ring{};
+#endif
+
+		const std::size_t m_readAhead;
+		Backend m_backend{Backend::Threads};
+
+		std::mutex m_mutex;
+		std::condition_variable m_workAvailable;
+		std::condition_variable m_jobFinished;
+
+		std::deque<std::string> m_pendingReads;
+		std::deque<Job> m_pendingWrites;
+		std::unordered_map<std::string, std::optional<ReadResult>> m_reads;
+		std::unordered_map<std::string, std::size_t> m_awaited;
+		std::unordered_map<std::string, std::size_t> m_prefetched;
+		std::size_t m_nextSequence{0};
+		std::size_t m_consumedSequence{0};
+		std::size_t m_readsInFlight{0};
+		std::size_t m_readsReady{0};
+		std::size_t m_writesInFlight{0};
+		std::vector<WriteError> m_writeErrors;
+		bool m_stop{false};
+
+		std::vector<std::jthread> m_workers;
+	};
+
+	AsyncIO::AsyncIO(std::size_t readAhead, Backend backend)
+		: m_impl{std::make_unique<Impl>(readAhead, backend)}
+	{
+	}
+
+	AsyncIO::~AsyncIO() = default;
+
+	void AsyncIO::prefetch(const std::string &path)
+	{
+		m_impl->prefetch(path);
+	}
+
+	void AsyncIO::prefetch(const std::vector<std::string> &paths)
+	{
+		for (const auto &path : paths)
+			m_impl->prefetch(path);
+	}
+
+	std::expected<std::vector<byte>, ReadError> AsyncIO::read(const std::string &path)
+	{
+		return m_impl->read(path);
+	}
+
+	std::expected<vl::Image, ReadError> AsyncIO::read_png(const std::string &path, ColorMode mode)
+	{
+		const auto bytes{m_impl->read(path)};
+		if (!bytes)
+			return std::unexpected{bytes.error()};
+
+		auto image{decode_png(*bytes, mode)};
+		if (!image)
+			return std::unexpected<ReadError>({image.error().type,
+				fmt::format("Failed to read {}: {}", path, image.error().description)
+			});
+
+		return image;
+	}
+
+	void AsyncIO::write(std::vector<byte> &&bytes, const std::string &path)
+	{
+		m_impl->write(std::move(bytes), path);
+	}
+
+	std::expected<void, WriteError> AsyncIO::write_png(const vl::Image &image, const std::string &path)
+	{
+		auto bytes{encode_png(image)};
+		if (!bytes)
+			return std::unexpected{bytes.error()};
+
+		m_impl->write(std::move(*bytes), path);
+		return {};
+	}
+
+	std::vector<WriteError> AsyncIO::flush()
+	{
+		return m_impl->flush();
+	}
+
+	Backend AsyncIO::backend() const
+	{
+		return m_impl->backend();
+	}
+}
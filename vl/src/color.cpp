@@ -0,0 +1,69 @@
+#include "color.h"
+
+#include <cstring>
+
+#include "kernels.h"
+#include "parallel.h"
+#include "profiling.h"
+
+namespace
+{
+	constexpr std::size_t RowsGrain{32};
+}
+
+namespace vl::color
+{
+	vl::Image to_grayscale(const vl::Image &image)
+	{
+		VL_PROFILE_SCOPE("color::to_grayscale", image.width() * image.height());
+
+		vl::Image gray{image.width(), image.height(), PixelFormat::Grayscale8};
+		if (image.format() == PixelFormat::Grayscale8)
+		{
+			std::memcpy(gray.begin(), image.begin(), image.size());
+			return gray;
+		}
+
+		vl::parallel::for_range(0, image.height(), [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				switch (image.format())
+				{
+					case PixelFormat::Grayscale16:
+						impl::gray16_to_gray8_row(reinterpret_cast<const std::uint16_t *>(image.row(y)),
+							gray.row(y), image.width());
+						break;
+					case PixelFormat::RGB8:
+						impl::rgb_to_gray_row(image.row(y), gray.row(y), image.width());
+						break;
+					case PixelFormat::RGBA8:
+						impl::rgba_to_gray_row(image.row(y), gray.row(y), image.width());
+						break;
+					default:
+						break;
+				}
+			}
+		}, RowsGrain);
+
+		return gray;
+	}
+
+	namespace impl
+	{
+		void rgb_to_gray_row(const byte *source, byte *destination, std::size_t width)
+		{
+			kernels::table().to_gray_row(source, destination, 3, width);
+		}
+
+		void rgba_to_gray_row(const byte *source, byte *destination, std::size_t width)
+		{
+			kernels::table().to_gray_row(source, destination, 4, width);
+		}
+
+		void gray16_to_gray8_row(const std::uint16_t *source, byte *destination, std::size_t width)
+		{
+			kernels::table().gray16_to_gray8_row(source, destination, width);
+		}
+	}
+}
@@ -0,0 +1,245 @@
+#include "components.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <fmt/format.h>
+
+#include "parallel.h"
+#include "profiling.h"
+
+namespace
+{
+	constexpr std::size_t TileRows{64};
+
+	struct Accumulator
+	{
+		std::uint32_t root;
+		std::size_t area{0};
+		std::size_t left{std::numeric_limits<std::size_t>::max()};
+		std::size_t top{std::numeric_limits<std::size_t>::max()};
+		std::size_t right{0};
+		std::size_t bottom{0};
+		std::uint64_t sumX{0};
+		std::uint64_t sumY{0};
+		std::uint64_t sum{0};
+
+		inline void add(std::size_t x, std::size_t y, vl::byte value)
+		{
+			++area;
+			left = std::min(left, x);
+			top = std::min(top, y);
+			right = std::max(right, x);
+			bottom = std::max(bottom, y);
+			sumX += x;
+			sumY += y;
+			sum += value;
+		}
+
+		Accumulator &operator+=(const Accumulator &other)
+		{
+			area += other.area;
+			left = std::min(left, other.left);
+			top = std::min(top, other.top);
+			right = std::max(right, other.right);
+			bottom = std::max(bottom, other.bottom);
+			sumX += other.sumX;
+			sumY += other.sumY;
+			sum += other.sum;
+			return *this;
+		}
+	};
+
+	class DisjointSets
+	{
+	public:
+		explicit DisjointSets(std::size_t size)
+			: m_parents(size)
+		{
+		}
+
+		inline void make_set(std::uint32_t element)
+		{
+			m_parents[element] = element;
+		}
+
+		inline std::uint32_t find(std::uint32_t element)
+		{
+			while (m_parents[element] != element)
+			{
+				m_parents[element] = m_parents[m_parents[element]];
+				element = m_parents[element];
+			}
+			return element;
+		}
+
+		inline void unite(std::uint32_t first, std::uint32_t second)
+		{
+			first = find(first);
+			second = find(second);
+			if (first < second)
+				m_parents[second] = first;
+			else if (second < first)
+				m_parents[first] = second;
+		}
+
+	private:
+		std::vector<std::uint32_t> m_parents;
+	};
+}
+
+namespace vl
+{
+	Components connected_components(const Image &image, byte threshold, filters::Connectivity connectivity)
+	{
+		VL_PROFILE_SCOPE("connected_components", image.width() * image.height());
+
+		if (image.format() != PixelFormat::Grayscale8)
+		{
+			fmt::println("Non grayscale formats are not supported");
+			return {};
+		}
+		if (image.size() >= std::numeric_limits<std::uint32_t>::max())
+		{
+			fmt::println("Invalid image size: {}x{} for connected components", image.width(), image.height());
+			return {};
+		}
+
+		const std::size_t width{image.width()};
+		const std::size_t height{image.height()};
+		const bool eight{connectivity == filters::Connectivity::Eight};
+		const std::size_t tiles{(height + TileRows - 1) / TileRows};
+		Components result{LabelImage{width, height}, {}};
+		std::uint32_t *labels{result.labels.begin()};
+		const byte *pixels{image.begin()};
+		const auto foreground{[&](std::size_t index)
+		{
+			return pixels[index] >= threshold;
+		}};
+
+		DisjointSets sets{image.size()};
+		std::vector<std::vector<Accumulator>> tileComponents(tiles);
+		vl::parallel::for_each(0, tiles, [&](std::size_t tile)
+		{
+			const std::size_t firstRow{tile * TileRows};
+			const std::size_t lastRow{std::min(firstRow + TileRows, height)};
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+				for (std::size_t x = 0; x < width; ++x)
+				{
+					const std::size_t index{y * width + x};
+					if (!foreground(index))
+					{
+						labels[index] = 0;
+						continue;
+					}
+
+					sets.make_set(index);
+					if (x > 0 && foreground(index - 1))
+						sets.unite(index, index - 1);
+					if (y == firstRow)
+						continue;
+					if (foreground(index - width))
+						sets.unite(index, index - width);
+					else if (eight)
+					{
+						if (x > 0 && foreground(index - width - 1))
+							sets.unite(index, index - width - 1);
+						if (x + 1 < width && foreground(index - width + 1))
+							sets.unite(index, index - width + 1);
+					}
+				}
+
+			auto &components{tileComponents[tile]};
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+				for (std::size_t x = 0; x < width; ++x)
+				{
+					const std::size_t index{y * width + x};
+					if (!foreground(index))
+						continue;
+
+					const std::uint32_t root{sets.find(index)};
+					if (root == index)
+					{
+						components.push_back({root});
+						labels[index] = components.size();
+					}
+					else
+						labels[index] = labels[root];
+					components[labels[index] - 1].add(x, y, pixels[index]);
+				}
+		});
+
+		for (std::size_t tile = 1; tile < tiles; ++tile)
+		{
+			const std::size_t y{tile * TileRows};
+			for (std::size_t x = 0; x < width; ++x)
+			{
+				const std::size_t index{y * width + x};
+				if (!foreground(index))
+					continue;
+
+				if (foreground(index - width))
+					sets.unite(index, index - width);
+				else if (eight)
+				{
+					if (x > 0 && foreground(index - width - 1))
+						sets.unite(index, index - width - 1);
+					if (x + 1 < width && foreground(index - width + 1))
+						sets.unite(index, index - width + 1);
+				}
+			}
+		}
+
+		std::vector<Accumulator> accumulators;
+		std::vector<std::vector<std::uint32_t>> tileLabels(tiles);
+		for (std::size_t tile = 0; tile < tiles; ++tile)
+		{
+			tileLabels[tile].resize(tileComponents[tile].size());
+			for (std::size_t component = 0; component < tileComponents[tile].size(); ++component)
+			{
+				const Accumulator &local{tileComponents[tile][component]};
+				const std::uint32_t root{sets.find(local.root)};
+				if (root == local.root)
+				{
+					accumulators.push_back(local);
+					tileLabels[tile][component] = accumulators.size();
+				}
+				else
+				{
+					const std::uint32_t label{tileLabels[root / width / TileRows][labels[root] - 1]};
+					accumulators[label - 1] += local;
+					tileLabels[tile][component] = label;
+				}
+			}
+		}
+
+		vl::parallel::for_each(0, tiles, [&](std::size_t tile)
+		{
+			const std::uint32_t *globalLabels{tileLabels[tile].data()};
+			const std::size_t first{tile * TileRows * width};
+			const std::size_t last{std::min((tile + 1) * TileRows, height) * width};
+			for (std::size_t index = first; index < last; ++index)
+				if (labels[index] != 0)
+					labels[index] = globalLabels[labels[index] - 1];
+		});
+
+		result.components.resize(accumulators.size());
+		for (std::size_t index = 0; index < accumulators.size(); ++index)
+		{
+			const Accumulator &accumulator{accumulators[index]};
+			const double area = accumulator.area;
+			Component &component{result.components[index]};
+			component.label = index + 1;
+			component.area = accumulator.area;
+			component.x = accumulator.left;
+			component.y = accumulator.top;
+			component.width = accumulator.right - accumulator.left + 1;
+			component.height = accumulator.bottom - accumulator.top + 1;
+			component.centroidX = accumulator.sumX / area;
+			component.centroidY = accumulator.sumY / area;
+			component.meanIntensity = accumulator.sum / area;
+		}
+
+		return result;
+	}
+}
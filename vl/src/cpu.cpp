@@ -0,0 +1,136 @@
+#include "cpu.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+#include <fmt/format.h>
+
+#include "kernels.h"
+
+namespace
+{
+	using vl::cpu::Level;
+
+	Level detect_level()
+	{
+#if defined(VL_HAS_X86_KERNELS)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("x86-64-v4"))
+			return Level::AVX512;
+		if (__builtin_cpu_supports("x86-64-v3"))
+			return Level::AVX2;
+#endif
+		return Level::Baseline;
+	}
+
+	const vl::kernels::Table &level_table(Level level)
+	{
+		switch (level)
+		{
+#if defined(VL_HAS_X86_KERNELS)
+			case Level::AVX512:
+				return vl::kernels::avx512::table();
+			case Level::AVX2:
+				return vl::kernels::avx2::table();
+#endif
+			default:
+				return vl::kernels::baseline::table();
+		}
+	}
+
+	struct DispatchState
+	{
+		DispatchState()
+			: supported{detect_level()}
+		{
+			Level initial{supported};
+			if (const char *forced{std::getenv("VL_CPU_LEVEL")})
+			{
+				if (const auto level{vl::cpu::to_level(forced)})
+					initial = *level;
+				else
+					fmt::println("Unknown VL_CPU_LEVEL value: {}", forced);
+			}
+			select(initial);
+		}
+
+		Level select(Level requested)
+		{
+			if (requested > supported)
+			{
+				fmt::println("CPU level {} is not supported, using {}",
+					vl::cpu::to_string(requested), vl::cpu::to_string(supported));
+				requested = supported;
+			}
+
+			table.store(&level_table(requested), std::memory_order_relaxed);
+			active.store(requested, std::memory_order_relaxed);
+			return requested;
+		}
+
+		const Level supported;
+		std::atomic<Level> active{Level::Baseline};
+		std::atomic<const vl::kernels::Table *> table{nullptr};
+	};
+
+	DispatchState &dispatch_state()
+	{
+		static DispatchState state{};
+		return state;
+	}
+}
+
+namespace vl::cpu
+{
+	std::optional<Level> to_level(const std::string &levelString)
+	{
+		std::string levelLowCase{levelString};
+		std::transform(begin(levelLowCase), end(levelLowCase), begin(levelLowCase), tolower);
+
+		if (levelLowCase == "baseline")
+			return Level::Baseline;
+		else if (levelLowCase == "avx2")
+			return Level::AVX2;
+		else if (levelLowCase == "avx512")
+			return Level::AVX512;
+
+		return {};
+	}
+
+	std::string to_string(Level level)
+	{
+		switch (level)
+		{
+			case Level::AVX2:
+				return "avx2";
+			case Level::AVX512:
+				return "avx512";
+			default:
+				return "baseline";
+		}
+	}
+
+	Level supported_level()
+	{
+		return dispatch_state().supported;
+	}
+
+	Level level()
+	{
+		return dispatch_state().active.load(std::memory_order_relaxed);
+	}
+
+	Level set_level(Level requested)
+	{
+		return dispatch_state().select(requested);
+	}
+}
+
+namespace vl::kernels
+{
+	const Table &table()
+	{
+		return *dispatch_state().table.load(std::memory_order_relaxed);
+	}
+}
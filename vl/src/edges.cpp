@@ -0,0 +1,349 @@
+#include "filters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <fmt/format.h>
+
+#include "parallel.h"
+#include "planar.h"
+#include "profiling.h"
+#include "scratch.h"
+
+namespace
+{
+	constexpr std::size_t RowsGrain{16};
+
+	enum class Direction : vl::byte
+	{
+		Horizontal,
+		Diagonal,
+		Vertical,
+		AntiDiagonal
+	};
+
+	enum EdgeState : vl::byte
+	{
+		NoEdge = 0,
+		WeakEdge = 1,
+		StrongEdge = 2
+	};
+
+	class GradientScratch
+	{
+	public:
+		explicit GradientScratch(std::size_t width)
+			: m_width{width}
+			, m_rows(3 * (width + 2))
+			, m_smooth(width + 2)
+			, m_difference(width + 2)
+			, gx(width)
+			, gy(width)
+		{
+		}
+
+		void compute(const vl::Image &source, std::size_t y)
+		{
+			const std::size_t height{source.height()};
+			load_row(source, y > 0 ? y - 1 : 0, &m_rows[0]);
+			load_row(source, y, &m_rows[m_width + 2]);
+			load_row(source, std::min(y + 1, height - 1), &m_rows[2 * (m_width + 2)]);
+
+			const std::int16_t *__restrict above{&m_rows[0]};
+			const std::int16_t *__restrict center{&m_rows[m_width + 2]};
+			const std::int16_t *__restrict below{&m_rows[2 * (m_width + 2)]};
+			std::int16_t *__restrict smooth{m_smooth.data()};
+			std::int16_t *__restrict difference{m_difference.data()};
+			for (std::size_t x = 0; x < m_width + 2; ++x)
+			{
+				smooth[x] = above[x] + 2 * center[x] + below[x];
+				difference[x] = below[x] - above[x];
+			}
+
+			std::int16_t *__restrict xGradient{gx.data()};
+			std::int16_t *__restrict yGradient{gy.data()};
+			for (std::size_t x = 0; x < m_width; ++x)
+			{
+				xGradient[x] = smooth[x + 2] - smooth[x];
+				yGradient[x] = difference[x] + 2 * difference[x + 1] + difference[x + 2];
+			}
+		}
+
+	private:
+		void load_row(const vl::Image &source, std::size_t y, std::int16_t *__restrict row)
+		{
+			const vl::byte *__restrict sourceRow{source.row(y)};
+			row[0] = sourceRow[0];
+			for (std::size_t x = 0; x < m_width; ++x)
+				row[x + 1] = sourceRow[x];
+			row[m_width + 1] = sourceRow[m_width - 1];
+		}
+
+		std::size_t m_width;
+		std::vector<std::int16_t> m_rows;
+		std::vector<std::int16_t> m_smooth;
+		std::vector<std::int16_t> m_difference;
+
+	public:
+		std::vector<std::int16_t> gx;
+		std::vector<std::int16_t> gy;
+	};
+
+	bool check_edge_input(const vl::Image &image)
+	{
+		if (image.width() < 2 || image.height() < 2)
+		{
+			fmt::println("Invalid image size: {}x{} for edge detection", image.width(), image.height());
+			return false;
+		}
+		if (image.format() == vl::PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return false;
+		}
+		return true;
+	}
+
+	template<typename Combine>
+	void apply_gradient(vl::Image &image, Combine &&combine)
+	{
+		vl::impl::for_each_plane(image, [&](vl::Image &plane)
+		{
+			const vl::ScratchImage copyScratch{plane};
+			const vl::Image &copy{copyScratch.image()};
+			vl::parallel::for_range(0, plane.height(), [&](std::size_t firstRow, std::size_t lastRow)
+			{
+				GradientScratch scratch{plane.width()};
+				for (std::size_t y = firstRow; y < lastRow; ++y)
+				{
+					scratch.compute(copy, y);
+					const std::int16_t *__restrict gx{scratch.gx.data()};
+					const std::int16_t *__restrict gy{scratch.gy.data()};
+					vl::byte *__restrict row{plane.row(y)};
+					for (std::size_t x = 0; x < plane.width(); ++x)
+						row[x] = combine(gx[x], gy[x]);
+				}
+			}, RowsGrain);
+		});
+	}
+
+	inline vl::byte magnitude_to_byte(float xGradient, float yGradient)
+	{
+		return std::min(std::sqrt(xGradient * xGradient + yGradient * yGradient), 255.f);
+	}
+
+	void gradient_magnitude_row(GradientScratch &scratch, std::int16_t *__restrict magnitude,
+		Direction *__restrict direction, std::size_t width)
+	{
+		const std::int16_t *__restrict gx{scratch.gx.data()};
+		const std::int16_t *__restrict gy{scratch.gy.data()};
+		for (std::size_t x = 0; x < width; ++x)
+		{
+			const std::int32_t absX{std::abs(gx[x])};
+			const std::int32_t absY{std::abs(gy[x])};
+			magnitude[x + 1] = absX + absY;
+
+			if (absY * 128 <= absX * 53)
+				direction[x] = Direction::Horizontal;
+			else if (absX * 128 <= absY * 53)
+				direction[x] = Direction::Vertical;
+			else
+				direction[x] = (gx[x] > 0) == (gy[x] > 0) ? Direction::Diagonal : Direction::AntiDiagonal;
+		}
+	}
+}
+
+namespace vl::filters
+{
+	void horizontal_edges(Image &image)
+	{
+		VL_PROFILE_SCOPE("filters::horizontal_edges", image.width() * image.height());
+
+		if (!check_edge_input(image))
+			return;
+
+		apply_gradient(image, [](std::int16_t, std::int16_t gy) -> byte
+		{
+			return std::min<int>(std::abs(gy), 255);
+		});
+	}
+
+	void vertical_edges(Image &image)
+	{
+		VL_PROFILE_SCOPE("filters::vertical_edges", image.width() * image.height());
+
+		if (!check_edge_input(image))
+			return;
+
+		apply_gradient(image, [](std::int16_t gx, std::int16_t) -> byte
+		{
+			return std::min<int>(std::abs(gx), 255);
+		});
+	}
+
+	void sobel(Image &image)
+	{
+		VL_PROFILE_SCOPE("filters::sobel", image.width() * image.height());
+
+		if (!check_edge_input(image))
+			return;
+
+		apply_gradient(image, [](std::int16_t gx, std::int16_t gy)
+		{
+			return magnitude_to_byte(gx, gy);
+		});
+	}
+
+	void roberts_cross(Image &image)
+	{
+		VL_PROFILE_SCOPE("filters::roberts_cross", image.width() * image.height());
+
+		if (!check_edge_input(image))
+			return;
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			const ScratchImage copyScratch{plane};
+			const Image &copy{copyScratch.image()};
+			const std::size_t lastColumn{plane.width() - 1};
+			vl::parallel::for_range(0, plane.height(), [&](std::size_t firstRow, std::size_t lastRow)
+			{
+				for (std::size_t y = firstRow; y < lastRow; ++y)
+				{
+					const byte *__restrict current{copy.row(y)};
+					const byte *__restrict next{copy.row(std::min(y + 1, plane.height() - 1))};
+					byte *__restrict row{plane.row(y)};
+					for (std::size_t x = 0; x < lastColumn; ++x)
+					{
+						const std::int16_t diagonal = current[x] - next[x + 1];
+						const std::int16_t antiDiagonal = current[x + 1] - next[x];
+						row[x] = magnitude_to_byte(diagonal, antiDiagonal);
+					}
+					row[lastColumn] = magnitude_to_byte(current[lastColumn] - next[lastColumn], 0);
+				}
+			}, RowsGrain);
+		});
+	}
+
+	void canny(Image &image, std::size_t lowThreshold, std::size_t highThreshold)
+	{
+		VL_PROFILE_SCOPE("filters::canny", image.width() * image.height());
+
+		if (lowThreshold > highThreshold)
+		{
+			fmt::println("Invalid canny thresholds: low {} is bigger than high {}", lowThreshold, highThreshold);
+			return;
+		}
+		if (!check_edge_input(image))
+			return;
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			const std::size_t width{plane.width()};
+			const std::size_t height{plane.height()};
+
+			const ScratchImage copyScratch{plane};
+			const Image &copy{copyScratch.image()};
+			vl::parallel::for_range(0, height, [&](std::size_t firstRow, std::size_t lastRow)
+			{
+				GradientScratch scratch{width};
+				std::array<std::vector<std::int16_t>, 3> magnitudes;
+				std::array<std::vector<Direction>, 3> directions;
+				for (std::size_t i = 0; i < magnitudes.size(); ++i)
+				{
+					magnitudes[i].assign(width + 2, 0);
+					directions[i].resize(width);
+				}
+
+				const auto computeRow{[&](std::size_t y, std::size_t slot)
+				{
+					if (y >= height)
+					{
+						std::ranges::fill(magnitudes[slot], 0);
+						return;
+					}
+					scratch.compute(copy, y);
+					gradient_magnitude_row(scratch, magnitudes[slot].data(), directions[slot].data(), width);
+				}};
+
+				computeRow(firstRow - 1, 0);
+				computeRow(firstRow, 1);
+				for (std::size_t y = firstRow; y < lastRow; ++y)
+				{
+					const std::size_t aboveSlot{(y - firstRow) % 3};
+					const std::size_t centerSlot{(y - firstRow + 1) % 3};
+					const std::size_t belowSlot{(y - firstRow + 2) % 3};
+					computeRow(y + 1, belowSlot);
+
+					const std::int16_t *above{magnitudes[aboveSlot].data() + 1};
+					const std::int16_t *center{magnitudes[centerSlot].data() + 1};
+					const std::int16_t *below{magnitudes[belowSlot].data() + 1};
+					const Direction *direction{directions[centerSlot].data()};
+					byte *row{plane.row(y)};
+					for (std::size_t x = 0; x < width; ++x)
+					{
+						const std::int16_t magnitude{center[x]};
+						std::int16_t first;
+						std::int16_t second;
+						switch (direction[x])
+						{
+							case Direction::Horizontal:
+								first = center[(std::ptrdiff_t)x - 1];
+								second = center[x + 1];
+								break;
+							case Direction::Vertical:
+								first = above[x];
+								second = below[x];
+								break;
+							case Direction::Diagonal:
+								first = above[(std::ptrdiff_t)x - 1];
+								second = below[x + 1];
+								break;
+							default:
+								first = above[x + 1];
+								second = below[(std::ptrdiff_t)x - 1];
+								break;
+						}
+
+						if (magnitude <= first || magnitude < second || (std::size_t)magnitude < lowThreshold)
+							row[x] = NoEdge;
+						else
+							row[x] = (std::size_t)magnitude >= highThreshold ? StrongEdge : WeakEdge;
+					}
+				}
+			}, RowsGrain);
+
+			std::vector<std::size_t> queue;
+			for (std::size_t i = 0; i < plane.size(); ++i)
+				if (plane.begin()[i] == StrongEdge)
+					queue.push_back(i);
+
+			byte *states{plane.begin()};
+			while (!queue.empty())
+			{
+				const std::size_t index{queue.back()};
+				queue.pop_back();
+
+				const std::size_t x{index % width};
+				const std::size_t y{index / width};
+				for (std::size_t neighbourY = y > 0 ? y - 1 : 0; neighbourY <= std::min(y + 1, height - 1); ++neighbourY)
+					for (std::size_t neighbourX = x > 0 ? x - 1 : 0; neighbourX <= std::min(x + 1, width - 1); ++neighbourX)
+					{
+						const std::size_t neighbour{neighbourY * width + neighbourX};
+						if (states[neighbour] == WeakEdge)
+						{
+							states[neighbour] = StrongEdge;
+							queue.push_back(neighbour);
+						}
+					}
+			}
+
+			vl::parallel::for_range(0, plane.size(), [&](std::size_t first, std::size_t last)
+			{
+				for (std::size_t i = first; i < last; ++i)
+					states[i] = states[i] == StrongEdge ? 255 : 0;
+			}, RowsGrain * width);
+		});
+	}
+}
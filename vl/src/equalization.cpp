@@ -0,0 +1,206 @@
+#include "filters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <fmt/format.h>
+
+#include "lut.h"
+#include "math.h"
+#include "parallel.h"
+#include "planar.h"
+#include "profiling.h"
+
+namespace
+{
+	constexpr std::size_t RowsGrain{16};
+
+	struct TileNeighbours
+	{
+		std::size_t first;
+		std::size_t second;
+		float weight;
+	};
+
+	std::vector<TileNeighbours> tile_neighbours(std::size_t size, std::size_t tileSize, std::size_t tilesCount)
+	{
+		std::vector<TileNeighbours> neighbours(size);
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			const double position{((double)i + 0.5) / tileSize - 0.5};
+			const double clamped{std::clamp(position, 0., (double)(tilesCount - 1))};
+			const std::size_t first = clamped;
+			const std::size_t second{std::min(first + 1, tilesCount - 1)};
+			neighbours[i] = {first, second, (float)(clamped - first)};
+		}
+
+		return neighbours;
+	}
+}
+
+namespace vl::filters
+{
+	void histogram_equalization(Image &image)
+	{
+		VL_PROFILE_SCOPE("filters::histogram_equalization", image.width() * image.height());
+
+		if (image.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return;
+		}
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			Lut{math::Histogram{plane}.equalization_lut()}.apply(plane);
+		});
+	}
+
+	void transfer_function(Image &image, const std::array<byte, 256> &transfer)
+	{
+		VL_PROFILE_SCOPE("filters::transfer_function", image.width() * image.height());
+
+		if (image.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return;
+		}
+
+		Lut{transfer}.apply(image);
+	}
+
+	void local_histogram_equalization(Image &image, std::size_t tileSize, double clipLimit)
+	{
+		VL_PROFILE_SCOPE("filters::local_histogram_equalization", image.width() * image.height());
+
+		if (tileSize == 0)
+		{
+			fmt::println("Invalid tile size of local histogram equalization: {}", tileSize);
+			return;
+		}
+		if (image.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return;
+		}
+
+		if (image.width() == 0 || image.height() == 0)
+			return;
+
+		const std::size_t tilesX{(image.width() + tileSize - 1) / tileSize};
+		const std::size_t tilesY{(image.height() + tileSize - 1) / tileSize};
+		const auto columns{tile_neighbours(image.width(), tileSize, tilesX)};
+		const auto rows{tile_neighbours(image.height(), tileSize, tilesY)};
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			std::vector<std::array<byte, 256>> luts(tilesX * tilesY);
+			vl::parallel::for_each(0, luts.size(), [&](std::size_t tile)
+			{
+				const std::size_t left{(tile % tilesX) * tileSize};
+				const std::size_t top{(tile / tilesX) * tileSize};
+				const std::size_t width{std::min(tileSize, plane.width() - left)};
+				const std::size_t height{std::min(tileSize, plane.height() - top)};
+
+				const math::Histogram histogram{plane, left, top, width, height};
+				luts[tile] = impl::clipped_equalization_lut(histogram.bins(), histogram.count(), clipLimit);
+			});
+
+			vl::parallel::for_range(0, plane.height(), [&](std::size_t firstRow, std::size_t lastRow)
+			{
+				for (std::size_t y = firstRow; y < lastRow; ++y)
+				{
+					const auto &rowTiles{rows[y]};
+					const auto *upperLuts{&luts[rowTiles.first * tilesX]};
+					const auto *lowerLuts{&luts[rowTiles.second * tilesX]};
+					byte *row{plane.row(y)};
+					for (std::size_t x = 0; x < plane.width(); ++x)
+					{
+						const auto &columnTiles{columns[x]};
+						const byte value{row[x]};
+						const float upper{upperLuts[columnTiles.first][value]
+							+ (upperLuts[columnTiles.second][value] - upperLuts[columnTiles.first][value]) * columnTiles.weight};
+						const float lower{lowerLuts[columnTiles.first][value]
+							+ (lowerLuts[columnTiles.second][value] - lowerLuts[columnTiles.first][value]) * columnTiles.weight};
+						row[x] = upper + (lower - upper) * rowTiles.weight + 0.5f;
+					}
+				}
+			}, RowsGrain);
+		});
+	}
+
+	namespace impl
+	{
+		std::array<byte, 256> piecewise_linear_transfer(const std::vector<std::pair<byte, byte>> &points)
+		{
+			std::array<byte, 256> transfer{};
+			std::iota(transfer.begin(), transfer.end(), 0);
+			if (points.empty())
+				return transfer;
+
+			auto sortedPoints{points};
+			std::ranges::sort(sortedPoints);
+			for (std::size_t value = 0; value < transfer.size(); ++value)
+			{
+				const auto next{std::ranges::lower_bound(sortedPoints, value, {},
+					&std::pair<byte, byte>::first)};
+				if (next == sortedPoints.begin())
+					transfer[value] = next->second;
+				else if (next == sortedPoints.end())
+					transfer[value] = sortedPoints.back().second;
+				else
+				{
+					const auto previous{std::prev(next)};
+					const double position{(double)(value - previous->first) / (next->first - previous->first)};
+					transfer[value] = std::lround(previous->second + (next->second - previous->second) * position);
+				}
+			}
+
+			return transfer;
+		}
+
+		std::array<byte, 256> clipped_equalization_lut(std::array<std::size_t, 256> histogram,
+			std::size_t pixelsCount, double clipLimit)
+		{
+			std::array<byte, 256> lut{};
+			if (pixelsCount == 0)
+				return lut;
+
+			if (clipLimit > 0)
+			{
+				const std::size_t limit{std::max<std::size_t>(clipLimit * pixelsCount / histogram.size(), 1)};
+				std::size_t excess{0};
+				for (auto &frequency : histogram)
+				{
+					if (frequency > limit)
+					{
+						excess += frequency - limit;
+						frequency = limit;
+					}
+				}
+
+				const std::size_t increment{excess / histogram.size()};
+				const std::size_t remainder{excess % histogram.size()};
+				for (auto &frequency : histogram)
+					frequency += increment;
+				if (remainder > 0)
+				{
+					const std::size_t step{histogram.size() / remainder};
+					for (std::size_t i = 0; i < remainder; ++i)
+						++histogram[i * step];
+				}
+			}
+
+			const double scale{255. / pixelsCount};
+			std::size_t cumulative{0};
+			for (std::size_t bin = 0; bin < histogram.size(); ++bin)
+			{
+				cumulative += histogram[bin];
+				lut[bin] = std::min(std::lround(cumulative * scale), 255l);
+			}
+
+			return lut;
+		}
+	}
+}
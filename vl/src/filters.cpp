@@ -3,12 +3,65 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <limits>
 #include <span>
 #include <vector>
 
 #include <fmt/format.h>
 #include <fmt/ranges.h>
 
+#include "kernels.h"
+#include "math.h"
+#include "parallel.h"
+#include "planar.h"
+#include "profiling.h"
+#include "scratch.h"
+
+namespace
+{
+	constexpr std::size_t RowsGrain{16};
+	constexpr std::size_t MedianStripWidth{256};
+
+	using RowKernel = void (*)(vl::byte *, const vl::byte *, std::size_t);
+
+	std::vector<std::pair<std::size_t, std::size_t>> sorting_network(std::size_t count)
+	{
+		std::size_t padded{1};
+		while (padded < count)
+			padded *= 2;
+
+		std::vector<std::pair<std::size_t, std::size_t>> comparators;
+		for (std::size_t part = 1; part < padded; part *= 2)
+			for (std::size_t step = part; step > 0; step /= 2)
+				for (std::size_t offset = step % part; offset + step < padded; offset += step * 2)
+					for (std::size_t i = 0; i < std::min(step, padded - offset - step); ++i)
+						if ((i + offset) / (part * 2) == (i + offset + step) / (part * 2) && i + offset + step < count)
+							comparators.emplace_back(i + offset, i + offset + step);
+
+		return comparators;
+	}
+
+	void apply_morphology(vl::Image &image, const std::vector<bool> &mask, std::size_t size, RowKernel combine)
+	{
+		const std::size_t halfSize{size / 2};
+		const std::size_t count{image.width() - halfSize * 2};
+
+		const vl::ScratchImage copyScratch{image};
+		const vl::Image &copy{copyScratch.image()};
+		vl::parallel::for_range(halfSize, image.height() - halfSize, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				vl::byte *destination{image.row(y) + halfSize};
+				for (std::size_t i = 0; i < size; ++i)
+					for (std::size_t j = 0; j < size; ++j)
+						if (mask[i * size + j])
+							combine(destination, copy.row(y - halfSize + j) + i, count);
+			}
+		}, RowsGrain);
+	}
+}
+
 namespace vl::filters
 {
 	std::optional<Shape> to_shape(const std::string &shapeString)
@@ -29,6 +82,8 @@ namespace vl::filters
 
 	void gaussian(Image &image, double standardDeviation, std::size_t kernelSize)
 	{
+		VL_PROFILE_SCOPE("filters::gaussian", image.width() * image.height());
+
 		if (kernelSize % 2 == 0)
 		{
 			fmt::println("Invalid kernel size: {}, kernel size should be odd number",
@@ -41,7 +96,7 @@ namespace vl::filters
 				image.width(), image.height(), kernelSize, kernelSize);
 			return;
 		}
-		if (image.format() != PixelFormat::Grayscale8)
+		if (image.format() == PixelFormat::Grayscale16)
 		{
 			fmt::println("Unsupported image format");
 			return;
@@ -65,26 +120,35 @@ namespace vl::filters
 			}
 		}
 
-		const Image imageCopy{image};
-
-		const std::size_t effectiveWidth{image.width() - halfKernel};
-		const std::size_t effectiveHeight{image.height() - halfKernel};
-		for (std::size_t y = halfKernel; y < effectiveHeight; ++y)
+		vl::impl::for_each_plane(image, [&](Image &plane)
 		{
-			for (std::size_t x = halfKernel; x < effectiveWidth; ++x)
+			const ScratchImage imageCopyScratch{plane};
+			const Image &imageCopy{imageCopyScratch.image()};
+			const auto &kernels{vl::kernels::table()};
+
+			const std::size_t count{plane.width() - halfKernel * 2};
+			vl::parallel::for_range(halfKernel, plane.height() - halfKernel, [&](std::size_t firstRow, std::size_t lastRow)
 			{
-				double sum{0};
-				for (std::size_t kernelY = 0; kernelY < kernelSize; ++kernelY)
-					for (std::size_t kernelX = 0; kernelX < kernelSize; ++kernelX)
-						sum += kernel[kernelY * kernelSize + kernelX]
-							* (double)imageCopy[x - halfKernel + kernelX, y - halfKernel + kernelY];
-				image[x, y] = std::clamp(sum, 0., 256.);
-			}
-		}
+				std::vector<double> sums(count);
+				for (std::size_t y = firstRow; y < lastRow; ++y)
+				{
+					std::ranges::fill(sums, 0.);
+					for (std::size_t kernelY = 0; kernelY < kernelSize; ++kernelY)
+					{
+						const byte *source{imageCopy.row(y - halfKernel + kernelY)};
+						for (std::size_t kernelX = 0; kernelX < kernelSize; ++kernelX)
+							kernels.accumulate_row(sums.data(), source + kernelX, kernel[kernelY * kernelSize + kernelX], count);
+					}
+					kernels.store_clamped_row(sums.data(), plane.row(y) + halfKernel, count);
+				}
+			}, RowsGrain);
+		});
 	}
 
 	void median(Image &image, std::size_t size, Shape shapeToUse)
 	{
+		VL_PROFILE_SCOPE("filters::median", image.width() * image.height());
+
 		if (size % 2 == 0)
 		{
 			fmt::println("Invalid size of median filter: {}, filter should have odd size", size);
@@ -96,7 +160,7 @@ namespace vl::filters
 				image.width(), image.height(), size, size);
 			return;
 		}
-		if (image.format() != PixelFormat::Grayscale8)
+		if (image.format() == PixelFormat::Grayscale16)
 		{
 			fmt::println("Unsupported image format");
 			return;
@@ -104,32 +168,50 @@ namespace vl::filters
 
 		const std::vector<bool> mask{impl::create_mask(size, shapeToUse)};
 		const std::size_t valuesCount = impl::get_mask_pixels_count(mask);
+		const std::size_t medianIndex{std::min(valuesCount / 2 + 1, valuesCount - 1)};
 
-		const std::size_t halfSize{size / 2};
-		const std::size_t effectiveWidth{image.width() - halfSize};
-		const std::size_t effectiveHeight{image.height() - halfSize};
+		std::vector<std::pair<std::size_t, std::size_t>> offsets;
+		for (std::size_t kernelY = 0; kernelY < size; ++kernelY)
+			for (std::size_t kernelX = 0; kernelX < size; ++kernelX)
+				if (mask[kernelY * size + kernelX])
+					offsets.emplace_back(kernelX, kernelY);
+		const auto network{sorting_network(valuesCount)};
 
-		const vl::Image imageCopy{image};
-		std::vector<byte> values(valuesCount, 0);
-		for (std::size_t y = halfSize; y < effectiveHeight; ++y)
+		const std::size_t halfSize{size / 2};
+		vl::impl::for_each_plane(image, [&](Image &plane)
 		{
-			for (std::size_t x = halfSize; x < effectiveWidth; ++x)
+			const std::size_t count{plane.width() - halfSize * 2};
+			const auto &kernels{vl::kernels::table()};
+
+			const vl::ScratchImage imageCopyScratch{plane};
+			const vl::Image &imageCopy{imageCopyScratch.image()};
+			vl::parallel::for_range(halfSize, plane.height() - halfSize, [&](std::size_t firstRow, std::size_t lastRow)
 			{
-				std::size_t index{0};
-				for (std::size_t kernelY = 0; kernelY < size; ++kernelY)
-					for (std::size_t kernelX = 0; kernelX < size; ++kernelX)
-						if (mask[kernelY * size + kernelX])
-							values[index++] = imageCopy[x - halfSize + kernelX, y - halfSize + kernelY];
-				assert(index == values.size());
-
-				std::ranges::sort(values);
-				image[x, y] = values[values.size() / 2 + 1];
-			}
-		}
+				std::vector<byte> values(valuesCount * MedianStripWidth);
+				for (std::size_t y = firstRow; y < lastRow; ++y)
+				{
+					for (std::size_t strip = 0; strip < count; strip += MedianStripWidth)
+					{
+						const std::size_t stripWidth{std::min(MedianStripWidth, count - strip)};
+						for (std::size_t i = 0; i < valuesCount; ++i)
+							std::copy_n(imageCopy.row(y - halfSize + offsets[i].second) + strip + offsets[i].first,
+								stripWidth, &values[i * MedianStripWidth]);
+
+						for (const auto &[lower, upper] : network)
+							kernels.compare_exchange_rows(&values[lower * MedianStripWidth],
+								&values[upper * MedianStripWidth], stripWidth);
+
+						std::copy_n(&values[medianIndex * MedianStripWidth], stripWidth, plane.row(y) + halfSize + strip);
+					}
+				}
+			}, RowsGrain);
+		});
 	}
 
 	void truncated_median(Image &image, std::size_t size, std::size_t stdDevCount, Shape shapeToUse)
 	{
+		VL_PROFILE_SCOPE("filters::truncated_median", image.width() * image.height());
+
 		if (size % 2 == 0)
 		{
 			fmt::println("Invalid size of truncated median filter: {}, filter should have odd size", size);
@@ -141,7 +223,7 @@ namespace vl::filters
 				image.width(), image.height(), size, size);
 			return;
 		}
-		if (image.format() != PixelFormat::Grayscale8)
+		if (image.format() == PixelFormat::Grayscale16)
 		{
 			fmt::println("Unsupported image format");
 			return;
@@ -150,62 +232,68 @@ namespace vl::filters
 		std::vector<bool> mask {impl::create_mask(size, shapeToUse)};
 		const std::size_t valuesCount = std::count(begin(mask), end(mask), true);
 
-		const std::size_t halfSize{size / 2};
-		const std::size_t effectiveWidth{image.width() - halfSize};
-		const std::size_t effectiveHeight{image.height() - halfSize};
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			const std::size_t halfSize{size / 2};
+			const std::size_t effectiveWidth{plane.width() - halfSize};
+			const std::size_t effectiveHeight{plane.height() - halfSize};
 
-		const vl::Image imageCopy{image};
-		std::vector<byte> values(valuesCount, 0);
-		std::array<int, 256> frequencies{};
+			const vl::ScratchImage imageCopyScratch{plane};
+			const vl::Image &imageCopy{imageCopyScratch.image()};
+			std::vector<byte> values(valuesCount, 0);
+			std::array<int, 256> frequencies{};
 
-		std::size_t index{0};
-		std::size_t mean{0};
-		std::size_t powMean{0};
-		for (std::size_t y = halfSize; y < effectiveHeight; ++y)
-		{
-			for (std::size_t x = halfSize; x < effectiveWidth; ++x)
+			std::size_t index{0};
+			std::size_t mean{0};
+			std::size_t powMean{0};
+			for (std::size_t y = halfSize; y < effectiveHeight; ++y)
 			{
-				index = 0;
+				for (std::size_t x = halfSize; x < effectiveWidth; ++x)
+				{
+					index = 0;
 
-				for (std::size_t kernelY = 0; kernelY < size; ++kernelY)
-					for (std::size_t kernelX = 0; kernelX < size; ++kernelX)
-						if (mask[kernelY * size + kernelX])
-							values[index++] = imageCopy[x - halfSize + kernelX, y - halfSize + kernelY];
+					for (std::size_t kernelY = 0; kernelY < size; ++kernelY)
+						for (std::size_t kernelX = 0; kernelX < size; ++kernelX)
+							if (mask[kernelY * size + kernelX])
+								values[index++] = imageCopy[x - halfSize + kernelX, y - halfSize + kernelY];
 
-				assert(index == values.size());
+					assert(index == values.size());
 
-				for (std::size_t i = 0; i < values.size(); ++i)
-					++frequencies[values[i]];
+					for (std::size_t i = 0; i < values.size(); ++i)
+						++frequencies[values[i]];
 
-				for (std::size_t i = 0; i < values.size(); ++i)
-				{
-					mean += frequencies[values[i]] / (double)values.size() * values[i];
-					powMean += std::pow(frequencies[values[i]] / (double)values.size() * values[i], 2);
-				}
-				mean /= values.size();
-				powMean /= values.size();
-				const double threshold{std::sqrt(powMean - mean * mean) * stdDevCount};
+					for (std::size_t i = 0; i < values.size(); ++i)
+					{
+						mean += frequencies[values[i]] / (double)values.size() * values[i];
+						powMean += std::pow(frequencies[values[i]] / (double)values.size() * values[i], 2);
+					}
+					mean /= values.size();
+					powMean /= values.size();
+					const double threshold{std::sqrt(powMean - mean * mean) * stdDevCount};
 
-				std::ranges::sort(values);
+					std::ranges::sort(values);
 
-				auto acceptableStart{std::upper_bound(begin(values), end(values),
-					mean - threshold)
-				};
-				const auto acceptableEnd{std::lower_bound(begin(values), end(values),
-					mean + threshold)
-				};
+					auto acceptableStart{std::upper_bound(begin(values), end(values),
+						mean - threshold)
+					};
+					const auto acceptableEnd{std::lower_bound(begin(values), end(values),
+						mean + threshold)
+					};
 
-				if (acceptableStart == end(values))
-					acceptableStart = begin(values);
+					if (acceptableStart == end(values))
+						acceptableStart = begin(values);
 
-				image[x, y] = *(acceptableStart + std::distance(acceptableStart, acceptableEnd) / 2 + 1);
-				std::memset(frequencies.data(), 0, frequencies.size());
+					plane[x, y] = *(acceptableStart + std::distance(acceptableStart, acceptableEnd) / 2 + 1);
+					std::memset(frequencies.data(), 0, frequencies.size());
+				}
 			}
-		}
+		});
 	}
 
 	void hybrid_median(Image &image, std::size_t size)
 	{
+		VL_PROFILE_SCOPE("filters::hybrid_median", image.width() * image.height());
+
 		if (size % 2 == 0)
 		{
 			fmt::println("Invalid size of hybrid median filter: {}, filter should have odd size", size);
@@ -217,52 +305,58 @@ namespace vl::filters
 				image.width(), image.height(), size, size);
 			return;
 		}
-		if (image.format() != PixelFormat::Grayscale8)
+		if (image.format() == PixelFormat::Grayscale16)
 		{
 			fmt::println("Unsupported image format");
 			return;
 		}
 
-		const std::size_t halfSize{size / 2};
-		const std::size_t effectiveWidth{image.width() - halfSize};
-		const std::size_t effectiveHeight{image.height() - halfSize};
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			const std::size_t halfSize{size / 2};
+			const std::size_t effectiveWidth{plane.width() - halfSize};
+			const std::size_t effectiveHeight{plane.height() - halfSize};
 
 
-		const Image copy{image};
-		std::vector<byte> pixelsToCheck(size * 2 - 1);
-		std::array<byte, 3> medians;
-		for (std::size_t y = halfSize; y < effectiveHeight; ++y)
-		{
-			for (std::size_t x = halfSize; x < effectiveWidth; ++x)
+			const ScratchImage copyScratch{plane};
+			const Image &copy{copyScratch.image()};
+			std::vector<byte> pixelsToCheck(size * 2 - 1);
+			std::array<byte, 3> medians;
+			for (std::size_t y = halfSize; y < effectiveHeight; ++y)
 			{
-				for (std::size_t i = 0; i < size; ++i)
+				for (std::size_t x = halfSize; x < effectiveWidth; ++x)
 				{
-					pixelsToCheck[i] = copy[x - halfSize + i, y - halfSize + i];
-					if (i != halfSize + 1)
-						pixelsToCheck[size + i - (i > halfSize + 1)] = copy[x + halfSize - i, y + halfSize - i];
-				}
-				std::ranges::sort(pixelsToCheck);
+					for (std::size_t i = 0; i < size; ++i)
+					{
+						pixelsToCheck[i] = copy[x - halfSize + i, y - halfSize + i];
+						if (i != halfSize + 1)
+							pixelsToCheck[size + i - (i > halfSize + 1)] = copy[x + halfSize - i, y + halfSize - i];
+					}
+					std::ranges::sort(pixelsToCheck);
 
-				medians[0] = pixelsToCheck[pixelsToCheck.size() / 2 + 1];
-				medians[1] = copy[x, y];
+					medians[0] = pixelsToCheck[pixelsToCheck.size() / 2 + 1];
+					medians[1] = copy[x, y];
 
-				for (std::size_t i = 0; i < size; ++i)
-				{
-					pixelsToCheck[i] = copy[x, y - halfSize + i];
-					if (i != halfSize + 1)
-						pixelsToCheck[size + i - (i > halfSize + 1)] = copy[x + halfSize - i, y];
-				}
-				std::ranges::sort(pixelsToCheck);
-				medians[2] = pixelsToCheck[pixelsToCheck.size() / 2 + 1];
+					for (std::size_t i = 0; i < size; ++i)
+					{
+						pixelsToCheck[i] = copy[x, y - halfSize + i];
+						if (i != halfSize + 1)
+							pixelsToCheck[size + i - (i > halfSize + 1)] = copy[x + halfSize - i, y];
+					}
+					std::ranges::sort(pixelsToCheck);
+					medians[2] = pixelsToCheck[pixelsToCheck.size() / 2 + 1];
 
-				std::ranges::sort(medians);
-				image[x, y] = medians[1];
+					std::ranges::sort(medians);
+					plane[x, y] = medians[1];
+				}
 			}
-		}
+		});
 	}
 
 	void erosion(Image &image, Shape shape, std::size_t size)
 	{
+		VL_PROFILE_SCOPE("filters::erosion", image.width() * image.height());
+
 		if (size % 2 == 0)
 		{
 			fmt::println("Invalid size of erosion filter: {}, filter should have odd size", size);
@@ -274,35 +368,23 @@ namespace vl::filters
 				image.width(), image.height(), size, size);
 			return;
 		}
-		if (image.format() != PixelFormat::Grayscale8)
+		if (image.format() == PixelFormat::Grayscale16)
 		{
 			fmt::println("Unsupported image format");
 			return;
 		}
 
-		const std::size_t halfSize{size / 2};
-		const std::size_t effectiveWidth{image.width() - halfSize};
-		const std::size_t effectiveHeight{image.height() - halfSize};
-
 		const auto mask{impl::create_mask(size, shape)};
-		const Image copy{image};
-		for (std::size_t y = halfSize; y < effectiveHeight; ++y)
+		vl::impl::for_each_plane(image, [&](Image &plane)
 		{
-			for (std::size_t x = halfSize; x < effectiveWidth; ++x)
-			{
-				byte min = copy[x, y];
-				for (std::size_t i = 0; i < size; ++i)
-					for (std::size_t j = 0; j < size; ++j)
-						if (mask[i * size + j])
-							min = std::min(copy[x - halfSize + i, y - halfSize + j], min);
-
-				image[x, y] = min;
-			}
-		}
+			apply_morphology(plane, mask, size, vl::kernels::table().min_row);
+		});
 	}
 
 	void dilation(Image &image, Shape shape, std::size_t size)
 	{
+		VL_PROFILE_SCOPE("filters::dilation", image.width() * image.height());
+
 		if (size % 2 == 0)
 		{
 			fmt::println("Invalid size of dilation filter: {}, filter should have odd size", size);
@@ -314,35 +396,101 @@ namespace vl::filters
 				image.width(), image.height(), size, size);
 			return;
 		}
-		if (image.format() != PixelFormat::Grayscale8)
+		if (image.format() == PixelFormat::Grayscale16)
 		{
 			fmt::println("Unsupported image format");
 			return;
 		}
 
-		const std::size_t halfSize{size / 2};
-		const std::size_t effectiveWidth{image.width() - halfSize};
-		const std::size_t effectiveHeight{image.height() - halfSize};
-
 		const auto mask{impl::create_mask(size, shape)};
-		const Image copy{image};
-		for (std::size_t y = halfSize; y < effectiveHeight; ++y)
+		vl::impl::for_each_plane(image, [&](Image &plane)
 		{
-			for (std::size_t x = halfSize; x < effectiveWidth; ++x)
+			apply_morphology(plane, mask, size, vl::kernels::table().max_row);
+		});
+	}
+
+	void distance_transform(Image &image, byte threshold)
+	{
+		VL_PROFILE_SCOPE("filters::distance_transform", image.width() * image.height());
+
+		if (image.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return;
+		}
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			const auto distances{math::squared_distance_transform(plane, threshold)};
+			vl::parallel::for_range(0, plane.size(), [&](std::size_t first, std::size_t last)
 			{
-				byte max = copy[x, y];
-				for (std::size_t i = 0; i < size; ++i)
-					for (std::size_t j = 0; j < size; ++j)
-						if (mask[i * size + j])
-							max = std::max(copy[x - halfSize + i, y - halfSize + j], max);
+				byte *values{plane.begin()};
+				for (std::size_t i = first; i < last; ++i)
+					values[i] = std::min(std::lround(std::sqrt((double)distances[i])), 255l);
+			}, RowsGrain * plane.width());
+		});
+	}
 
-				image[x, y] = max;
-			}
+	void binary_erosion(Image &image, double radius, byte threshold)
+	{
+		VL_PROFILE_SCOPE("filters::binary_erosion", image.width() * image.height());
+
+		if (radius < 0)
+		{
+			fmt::println("Invalid radius of binary erosion: {}, radius should not be negative", radius);
+			return;
+		}
+		if (image.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return;
+		}
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			const auto distances{math::squared_distance_transform(plane, threshold, true)};
+			const double squaredRadius{radius * radius};
+			vl::parallel::for_range(0, plane.size(), [&](std::size_t first, std::size_t last)
+			{
+				byte *values{plane.begin()};
+				for (std::size_t i = first; i < last; ++i)
+					values[i] = distances[i] > squaredRadius ? 255 : 0;
+			}, RowsGrain * plane.width());
+		});
+	}
+
+	void binary_dilation(Image &image, double radius, byte threshold)
+	{
+		VL_PROFILE_SCOPE("filters::binary_dilation", image.width() * image.height());
+
+		if (radius < 0)
+		{
+			fmt::println("Invalid radius of binary dilation: {}, radius should not be negative", radius);
+			return;
 		}
+		if (image.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return;
+		}
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			const auto distances{math::squared_distance_transform(plane, threshold)};
+			const double squaredRadius{radius * radius};
+			vl::parallel::for_range(0, plane.size(), [&](std::size_t first, std::size_t last)
+			{
+				byte *values{plane.begin()};
+				for (std::size_t i = first; i < last; ++i)
+					values[i] = distances[i] <= squaredRadius ? 255 : 0;
+			}, RowsGrain * plane.width());
+		});
 	}
 
 	void top_hat(Image &image, int innerRadius, int outterRadius, std::size_t threshold, bool dark)
 	{
+		VL_PROFILE_SCOPE("filters::top_hat", image.width() * image.height());
+
 		if (innerRadius % 2 == 0)
 		{
 			fmt::println("Invalid inner radius of top-hat filter: {}, filter should have odd size", innerRadius);
@@ -360,7 +508,7 @@ namespace vl::filters
 				image.width(), image.height(), outterRadius);
 			return;
 		}
-		if (image.format() != PixelFormat::Grayscale8)
+		if (image.format() == PixelFormat::Grayscale16)
 		{
 			fmt::println("Unsupported image format");
 			return;
@@ -372,29 +520,35 @@ namespace vl::filters
 
 		const auto innerMask{impl::create_mask(outterRadius, innerRadius, Shape::Circle)};
 		
-		const Image original{image};
-
-		for (std::size_t y = halfSize; y < effectiveHeight; ++y)
-			for (std::size_t x = halfSize; x < effectiveWidth; ++x)
-			{
-				int maxOutter = -1;
-				int maxInner = -1;
-
-				for (std::size_t i = 0; i < outterRadius; ++i)
-					for (std::size_t j = 0; j < outterRadius; ++j)
-					{
-						if (innerMask[i * outterRadius + j])
-							maxInner = std::max((int)original[x - halfSize + i, y - halfSize + j], maxInner);
-						else
-							maxOutter = std::max((int)original[x - halfSize + i, y - halfSize + j], maxOutter);
-					}
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			const ScratchImage originalScratch{plane};
+			const Image &original{originalScratch.image()};
 
-				image[x, y] = std::abs(maxOutter - maxInner) >= threshold ? original[x, y] : !dark * 255;
-			}
+			for (std::size_t y = halfSize; y < effectiveHeight; ++y)
+				for (std::size_t x = halfSize; x < effectiveWidth; ++x)
+				{
+					int maxOutter = -1;
+					int maxInner = -1;
+
+					for (std::size_t i = 0; i < outterRadius; ++i)
+						for (std::size_t j = 0; j < outterRadius; ++j)
+						{
+							if (innerMask[i * outterRadius + j])
+								maxInner = std::max((int)original[x - halfSize + i, y - halfSize + j], maxInner);
+							else
+								maxOutter = std::max((int)original[x - halfSize + i, y - halfSize + j], maxOutter);
+						}
+
+					plane[x, y] = std::abs(maxOutter - maxInner) >= threshold ? original[x, y] : !dark * 255;
+				}
+		});
 	}
 
 	void rolling_ball(Image &image, int innerRadius, int outterRadius, std::size_t threshold, bool dark)
 	{
+		VL_PROFILE_SCOPE("filters::rolling_ball", image.width() * image.height());
+
 		if (innerRadius % 2 == 0)
 		{
 			fmt::println("Invalid inner radius of rolling ball filter: {}, filter should have odd size", innerRadius);
@@ -412,7 +566,7 @@ namespace vl::filters
 				image.width(), image.height(), outterRadius);
 			return;
 		}
-		if (image.format() != PixelFormat::Grayscale8)
+		if (image.format() == PixelFormat::Grayscale16)
 		{
 			fmt::println("Unsupported image format");
 			return;
@@ -425,28 +579,142 @@ namespace vl::filters
 		const std::size_t effectiveWidth{image.width() - halfSize};
 		const std::size_t effectiveHeight{image.height() - halfSize};
 
-		int innerMin;
-		int outterMin;
-		const Image copy{image};
-		for (std::size_t row = halfSize; row < effectiveHeight; ++row)
+		vl::impl::for_each_plane(image, [&](Image &plane)
 		{
-			for (std::size_t col = halfSize; col < effectiveWidth; ++col)
+			int innerMin;
+			int outterMin;
+			const ScratchImage copyScratch{plane};
+			const Image &copy{copyScratch.image()};
+			for (std::size_t row = halfSize; row < effectiveHeight; ++row)
 			{
-				innerMin = std::numeric_limits<byte>::max();
-				outterMin = std::numeric_limits<byte>::max();
+				for (std::size_t col = halfSize; col < effectiveWidth; ++col)
+				{
+					innerMin = std::numeric_limits<byte>::max();
+					outterMin = std::numeric_limits<byte>::max();
+
+					for (std::size_t regionRow = 0; regionRow < regionSize; ++regionRow)
+						for (std::size_t regionCol = 0; regionCol < regionSize; ++regionCol)
+						{
+							if (innerMask[regionRow * outterRadius + regionCol])
+								innerMin = std::min((int)copy[col - halfSize + regionCol, row - halfSize + regionRow], innerMin);
+							else
+								outterMin = std::min((int)copy[col - halfSize + regionCol, row - halfSize + regionRow], outterMin);
+						}
+
+					plane[col, row] = std::abs(innerMin - outterMin) > threshold ? plane[col, row] : !dark * 255;
+				}
+			}
+		});
+	}
+
+	void variance(Image &image, std::size_t size)
+	{
+		VL_PROFILE_SCOPE("filters::variance", image.width() * image.height());
 
-				for (std::size_t regionRow = 0; regionRow < regionSize; ++regionRow)
-					for (std::size_t regionCol = 0; regionCol < regionSize; ++regionCol)
+		if (size % 2 == 0)
+		{
+			fmt::println("Invalid size of variance filter: {}, filter should have odd size", size);
+			return;
+		}
+		if (image.width() <= size || image.height() <= size)
+		{
+			fmt::println("Invalid image size: {}x{} to kernel size: {}x{}",
+				image.width(), image.height(), size, size);
+			return;
+		}
+		if (image.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return;
+		}
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			const std::size_t halfSize{size / 2};
+			const math::IntegralImage integral{plane};
+			vl::parallel::for_range(0, plane.height(), [&](std::size_t firstRow, std::size_t lastRow)
+			{
+				for (std::size_t y = firstRow; y < lastRow; ++y)
+				{
+					const std::size_t top{y > halfSize ? y - halfSize : 0};
+					const std::size_t bottom{std::min(y + halfSize + 1, plane.height())};
+					for (std::size_t x = 0; x < plane.width(); ++x)
 					{
-						if (innerMask[regionRow * outterRadius + regionCol])
-							innerMin = std::min((int)copy[col - halfSize + regionCol, row - halfSize + regionRow], innerMin);
-						else
-							outterMin = std::min((int)copy[col - halfSize + regionCol, row - halfSize + regionRow], outterMin);
+						const std::size_t left{x > halfSize ? x - halfSize : 0};
+						const std::size_t right{std::min(x + halfSize + 1, plane.width())};
+						const double localVariance{integral.box_variance(left, top, right - left, bottom - top)};
+						plane[x, y] = std::min(std::lround(localVariance), 255l);
 					}
+				}
+			}, RowsGrain);
+		});
+	}
 
-				image[col, row] = std::abs(innerMin - outterMin) > threshold ? image[col, row] : !dark * 255;
-			}
+	void kuwahara(Image &image, std::size_t radius)
+	{
+		VL_PROFILE_SCOPE("filters::kuwahara", image.width() * image.height());
+
+		if (radius == 0)
+		{
+			fmt::println("Invalid radius of kuwahara filter: {}, radius should be positive", radius);
+			return;
+		}
+		if (image.width() <= radius || image.height() <= radius)
+		{
+			fmt::println("Invalid image size: {}x{} to radius: {}",
+				image.width(), image.height(), radius);
+			return;
 		}
+		if (image.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return;
+		}
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			const math::IntegralImage integral{plane};
+			vl::parallel::for_range(0, plane.height(), [&](std::size_t firstRow, std::size_t lastRow)
+			{
+				for (std::size_t y = firstRow; y < lastRow; ++y)
+				{
+					const std::size_t top{y > radius ? y - radius : 0};
+					const std::size_t bottom{std::min(y + radius + 1, plane.height())};
+					const std::array<std::pair<std::size_t, std::size_t>, 2> rows{{
+						{top, y + 1 - top},
+						{y, bottom - y}
+					}};
+					for (std::size_t x = 0; x < plane.width(); ++x)
+					{
+						const std::size_t left{x > radius ? x - radius : 0};
+						const std::size_t right{std::min(x + radius + 1, plane.width())};
+						const std::array<std::pair<std::size_t, std::size_t>, 2> columns{{
+							{left, x + 1 - left},
+							{x, right - x}
+						}};
+
+						double bestVariance{std::numeric_limits<double>::max()};
+						double bestMean{0};
+						for (const auto &[quadrantY, quadrantHeight] : rows)
+							for (const auto &[quadrantX, quadrantWidth] : columns)
+							{
+								const double count = quadrantWidth * quadrantHeight;
+								const double sum = integral.box_sum(quadrantX, quadrantY, quadrantWidth, quadrantHeight);
+								const double squaredSum = integral.box_squared_sum(quadrantX, quadrantY, quadrantWidth, quadrantHeight);
+								const double mean{sum / count};
+								const double quadrantVariance{squaredSum / count - mean * mean};
+								if (quadrantVariance < bestVariance)
+								{
+									bestVariance = quadrantVariance;
+									bestMean = mean;
+								}
+							}
+
+						plane[x, y] = std::lround(bestMean);
+					}
+				}
+			}, RowsGrain);
+		});
 	}
 
 	namespace impl
@@ -512,11 +780,12 @@ namespace vl::filters
 			std::vector<bool> mask(size * size);
 			const std::size_t displacement{(size - shapeSize) / 2};
 
-			const std::size_t halfSize = (shapeSize / 2) * (shapeSize / 2);
+			const long center = shapeSize / 2;
+			const long squaredRadius{center * center};
 			for (std::size_t i = 0; i < shapeSize; ++i)
 				for (std::size_t j = 0; j < shapeSize; ++j)
 					mask[(i + displacement) * size + j + displacement] =
-						halfSize >= std::pow((i - halfSize), 2) + std::pow((j - halfSize), 2);
+						squaredRadius >= ((long)i - center) * ((long)i - center) + ((long)j - center) * ((long)j - center);
 
 			return mask;
 		}
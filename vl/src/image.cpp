@@ -1,24 +1,22 @@
 #include "image.h"
 
+#include <algorithm>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "profiling.h"
+
 namespace vl
 {
-	std::size_t to_pixel_size(PixelFormat format)
-	{
-		switch (format)
-		{
-			case PixelFormat::Grayscale8:
-				return 1;
-			default:
-				return 0;
-		}
-	}
-
 	Image::Image(const std::span<byte> &bytes, std::size_t _width, std::size_t _height, PixelFormat _format)
 		: m_rawBytes{bytes.begin(), bytes.end()}
 		, m_width{_width}
 		, m_height{_height}
 		, m_format{_format}
+		, m_data{m_rawBytes.data()}
 	{
+		VL_PROFILE_ALLOCATION(m_rawBytes.size());
 	}
 
 	Image::Image(std::vector<byte> &&bytes, std::size_t _width, std::size_t _height, PixelFormat _format)
@@ -26,14 +24,101 @@ namespace vl
 		, m_width{_width}
 		, m_height{_height}
 		, m_format{_format}
+		, m_data{m_rawBytes.data()}
 	{
 	}
 
 	Image::Image(std::size_t _width, std::size_t _height, PixelFormat _format)
-		: m_rawBytes(_width * _height, 0)
+		: m_rawBytes(_width * _height * to_pixel_size(_format), 0)
 		, m_width{_width}
 		, m_height{_height}
 		, m_format{_format}
+		, m_data{m_rawBytes.data()}
+	{
+		VL_PROFILE_ALLOCATION(m_rawBytes.size());
+	}
+
+	Image::Image(const Image &other)
+		: m_format{other.m_format}
+		, m_width{other.m_width}
+		, m_height{other.m_height}
+		, m_rawBytes{other.begin(), other.end()}
+		, m_data{m_rawBytes.data()}
+	{
+		VL_PROFILE_ALLOCATION(m_rawBytes.size());
+	}
+
+	Image::Image(Image &&other) noexcept
+		: m_format{other.m_format}
+		, m_width{other.m_width}
+		, m_height{other.m_height}
+		, m_rawBytes{std::move(other.m_rawBytes)}
+		, m_data{other.m_data}
+		, m_view{other.m_view}
 	{
+		other.m_width = 0;
+		other.m_height = 0;
+		other.m_data = nullptr;
+		other.m_view = false;
+	}
+
+	Image Image::view(std::span<byte> bytes, std::size_t width, std::size_t height, PixelFormat format)
+	{
+		Image image{std::vector<byte>{}, width, height, format};
+		if (bytes.size() < image.size())
+			throw std::out_of_range{fmt::format("Viewed buffer of {} bytes is smaller than {}x{} image",
+				bytes.size(), width, height)};
+
+		image.m_data = bytes.data();
+		image.m_view = true;
+		return image;
+	}
+
+	Image &Image::operator=(const Image &other)
+	{
+		if (this == &other)
+			return *this;
+
+		if (m_view && other.m_width == m_width && other.m_height == m_height && other.m_format == m_format)
+		{
+			std::copy(other.begin(), other.end(), m_data);
+			return *this;
+		}
+
+		VL_PROFILE_ALLOCATION(other.size() > m_rawBytes.capacity() ? other.size() : 0);
+		m_format = other.m_format;
+		m_width = other.m_width;
+		m_height = other.m_height;
+		m_rawBytes.assign(other.begin(), other.end());
+		m_data = m_rawBytes.data();
+		m_view = false;
+
+		return *this;
+	}
+
+	Image &Image::operator=(Image &&other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		if (m_view && other.m_width == m_width && other.m_height == m_height && other.m_format == m_format)
+		{
+			std::copy(other.begin(), other.end(), m_data);
+			return *this;
+		}
+
+		m_format = other.m_format;
+		m_width = other.m_width;
+		m_height = other.m_height;
+		m_rawBytes = std::move(other.m_rawBytes);
+		m_data = other.m_data;
+		m_view = other.m_view;
+
+		other.m_width = 0;
+		other.m_height = 0;
+		other.m_data = nullptr;
+		other.m_view = false;
+
+		return *this;
 	}
 }
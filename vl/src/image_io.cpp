@@ -1,11 +1,18 @@
 #include "image_io.h"
 
+#include <bit>
+#include <csetjmp>
+#include <cstring>
 #include <memory>
+#include <optional>
 
 #include <fmt/format.h>
 
 #include <png.h>
 
+#include "color.h"
+#include "profiling.h"
+
 struct FCloseDeleter
 {
 	void operator()(FILE *file)
@@ -21,6 +28,7 @@ struct InfoReadStructPair
 	png_structp png_ptr{nullptr};
 	png_infop info_ptr{nullptr};
 	png_infop end_info{nullptr};
+	std::string error;
 
 	~InfoReadStructPair()
 	{
@@ -32,6 +40,7 @@ struct InfoWriteStructPair
 {
 	png_structp png_ptr{nullptr};
 	png_infop info_ptr{nullptr};
+	std::string error;
 
 	~InfoWriteStructPair()
 	{
@@ -41,17 +50,168 @@ struct InfoWriteStructPair
 
 void user_error_fn(png_structp png_ptr, png_const_charp error_msg)
 {
-	fmt::println("LibPNG error: {}", error_msg);
+	auto *error{static_cast<std::string *>(png_get_error_ptr(png_ptr))};
+	if (error != nullptr)
+		*error = error_msg;
+	png_longjmp(png_ptr, 1);
 }
 void user_warning_fn(png_structp png_ptr, png_const_charp warning_msg)
 {
 	fmt::println("LibPNG warning: {}", warning_msg);
 }
 
+struct MemoryReader
+{
+	std::span<const vl::byte> buffer;
+	std::size_t offset{0};
+};
+
+void memory_read_fn(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+	auto *reader{static_cast<MemoryReader *>(png_get_io_ptr(png_ptr))};
+	if (reader->buffer.size() - reader->offset < length)
+		png_error(png_ptr, "Read Error: unexpected end of buffer");
+
+	std::memcpy(data, reader->buffer.data() + reader->offset, length);
+	reader->offset += length;
+}
+
+void memory_write_fn(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+	auto *output{static_cast<std::vector<vl::byte> *>(png_get_io_ptr(png_ptr))};
+	output->insert(output->end(), data, data + length);
+}
+
+void memory_flush_fn(png_structp)
+{
+}
+
+vl::PixelFormat to_pixel_format(int colorType, int bitDepth)
+{
+	switch (colorType)
+	{
+		case PNG_COLOR_TYPE_RGB:
+			return vl::PixelFormat::RGB8;
+		case PNG_COLOR_TYPE_RGB_ALPHA:
+			return vl::PixelFormat::RGBA8;
+		default:
+			return bitDepth == 16 ? vl::PixelFormat::Grayscale16 : vl::PixelFormat::Grayscale8;
+	}
+}
+
+std::optional<vl::Image> read_png_image(InfoReadStructPair &infoStructPair, std::size_t signatureBytes,
+	vl::ImageIO::ColorMode mode)
+{
+	std::vector<vl::byte> bytes;
+	std::vector<vl::byte *> rows;
+	if (setjmp(png_jmpbuf(infoStructPair.png_ptr)))
+		return {};
+
+	png_set_sig_bytes(infoStructPair.png_ptr, signatureBytes);
+	png_read_info(infoStructPair.png_ptr, infoStructPair.info_ptr);
+
+	png_set_interlace_handling(infoStructPair.png_ptr);
+
+	png_uint_32 width{png_get_image_width(infoStructPair.png_ptr, infoStructPair.info_ptr)};
+	png_uint_32 height{png_get_image_height(infoStructPair.png_ptr, infoStructPair.info_ptr)};
+	int colorType{png_get_color_type(infoStructPair.png_ptr, infoStructPair.info_ptr)};
+	int bitDepth{png_get_bit_depth(infoStructPair.png_ptr, infoStructPair.info_ptr)};
+
+	if (colorType == PNG_COLOR_TYPE_PALETTE)
+	{
+		png_set_palette_to_rgb(infoStructPair.png_ptr);
+		if (png_get_valid(infoStructPair.png_ptr, infoStructPair.info_ptr, PNG_INFO_tRNS))
+			png_set_tRNS_to_alpha(infoStructPair.png_ptr);
+	}
+
+	if (colorType == PNG_COLOR_TYPE_GRAY_ALPHA)
+		png_set_strip_alpha(infoStructPair.png_ptr);
+
+	if ((colorType & PNG_COLOR_MASK_COLOR) == PNG_COLOR_MASK_COLOR && bitDepth == 16)
+		png_set_scale_16(infoStructPair.png_ptr);
+
+	if ((colorType & PNG_COLOR_MASK_COLOR) == 0 && bitDepth < 8)
+		png_set_expand_gray_1_2_4_to_8(infoStructPair.png_ptr);
+
+	if (bitDepth == 16 && std::endian::native == std::endian::little)
+		png_set_swap(infoStructPair.png_ptr);
+
+	png_read_update_info(infoStructPair.png_ptr, infoStructPair.info_ptr);
+
+	width = png_get_image_width(infoStructPair.png_ptr, infoStructPair.info_ptr);
+	height = png_get_image_height(infoStructPair.png_ptr, infoStructPair.info_ptr);
+	colorType = png_get_color_type(infoStructPair.png_ptr, infoStructPair.info_ptr);
+	bitDepth = png_get_bit_depth(infoStructPair.png_ptr, infoStructPair.info_ptr);
+
+	const std::size_t rowBytes{png_get_rowbytes(infoStructPair.png_ptr, infoStructPair.info_ptr)};
+	bytes.resize(rowBytes * height);
+	VL_PROFILE_ALLOCATION(bytes.size());
+
+	rows.resize(height);
+	rows[0] = &bytes[0];
+	for (std::size_t i = 1; i < height; ++i)
+		rows[i] = rows[i - 1] + rowBytes;
+
+	png_read_image(infoStructPair.png_ptr, rows.data());
+
+	vl::Image image{std::move(bytes), width, height, to_pixel_format(colorType, bitDepth)};
+	if (mode == vl::ImageIO::ColorMode::Grayscale && image.format() != vl::PixelFormat::Grayscale8)
+		return vl::color::to_grayscale(image);
+
+	return image;
+}
+
+bool write_png_image(InfoWriteStructPair &infoStructPair, const vl::Image &image)
+{
+	std::vector<const vl::byte *> rows(image.height());
+	for (std::size_t i = 0; i < image.height(); ++i)
+		rows[i] = image.row(i);
+	if (setjmp(png_jmpbuf(infoStructPair.png_ptr)))
+		return false;
+
+	int colorType{PNG_COLOR_TYPE_GRAY};
+	int bitDepth{8};
+	switch (image.format())
+	{
+		case vl::PixelFormat::Grayscale16:
+			bitDepth = 16;
+			break;
+		case vl::PixelFormat::RGB8:
+			colorType = PNG_COLOR_TYPE_RGB;
+			break;
+		case vl::PixelFormat::RGBA8:
+			colorType = PNG_COLOR_TYPE_RGB_ALPHA;
+			break;
+		default:
+			break;
+	}
+
+	png_set_IHDR(
+		infoStructPair.png_ptr,
+		infoStructPair.info_ptr,
+		image.width(), image.height(),
+		bitDepth,
+		colorType,
+		PNG_INTERLACE_NONE,
+		PNG_COMPRESSION_TYPE_DEFAULT,
+		PNG_FILTER_TYPE_DEFAULT
+	);
+	png_write_info(infoStructPair.png_ptr, infoStructPair.info_ptr);
+
+	if (bitDepth == 16 && std::endian::native == std::endian::little)
+		png_set_swap(infoStructPair.png_ptr);
+
+	png_write_image(infoStructPair.png_ptr, const_cast<vl::byte **>(rows.data()));
+	png_write_end(infoStructPair.png_ptr, nullptr);
+	return true;
+}
+
 namespace vl::ImageIO
 {
-	std::expected<vl::Image, ReadError> read_png(const std::string &path)
+	std::expected<vl::Image, ReadError> read_png(const std::string &path, ColorMode mode)
 	{
+		VL_PROFILE_SCOPE("ImageIO::read_png", 0);
+
 		PFILE readFile{fopen(path.c_str(), "rb")};
 		if (readFile == nullptr)
 		{
@@ -86,7 +246,7 @@ namespace vl::ImageIO
 
 		InfoReadStructPair infoStructPair{};
 		infoStructPair.png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
-			nullptr, user_error_fn, user_warning_fn);
+			&infoStructPair.error, user_error_fn, user_warning_fn);
 		if (infoStructPair.png_ptr == nullptr)
 		{
 			return std::unexpected<ReadError>({ErrorType::IOError,
@@ -104,50 +264,22 @@ namespace vl::ImageIO
 
 		png_init_io(infoStructPair.png_ptr, readFile.get());
 
-		png_set_sig_bytes(infoStructPair.png_ptr, header.size());
-		png_read_info(infoStructPair.png_ptr, infoStructPair.info_ptr);
-
-		png_set_interlace_handling(infoStructPair.png_ptr);
-
-		png_uint_32 width{png_get_image_width(infoStructPair.png_ptr, infoStructPair.info_ptr)};
-		png_uint_32 height{png_get_image_height(infoStructPair.png_ptr, infoStructPair.info_ptr)};
-		int colorType{png_get_color_type(infoStructPair.png_ptr, infoStructPair.info_ptr)};
-		int bitDepth{png_get_bit_depth(infoStructPair.png_ptr, infoStructPair.info_ptr)};
-
-		if ((colorType & PNG_COLOR_TYPE_PALETTE) == PNG_COLOR_TYPE_PALETTE)
-			png_set_palette_to_rgb(infoStructPair.png_ptr);
-
-		if ((colorType & PNG_COLOR_MASK_ALPHA) == PNG_COLOR_MASK_ALPHA)
-			png_set_strip_alpha(infoStructPair.png_ptr);
-
-		if ((colorType & PNG_COLOR_TYPE_RGB) == PNG_COLOR_TYPE_RGB)
-			png_set_rgb_to_gray(infoStructPair.png_ptr, 1, -1, -1);
-
-		if ((colorType & PNG_COLOR_TYPE_GRAY) == PNG_COLOR_TYPE_GRAY && bitDepth < 8)
-			png_set_expand_gray_1_2_4_to_8(infoStructPair.png_ptr);
-
-		png_read_update_info(infoStructPair.png_ptr, infoStructPair.info_ptr);
-
-		width = png_get_image_width(infoStructPair.png_ptr, infoStructPair.info_ptr);
-		height = png_get_image_height(infoStructPair.png_ptr, infoStructPair.info_ptr);
-		colorType = png_get_color_type(infoStructPair.png_ptr, infoStructPair.info_ptr);
-		bitDepth = png_get_bit_depth(infoStructPair.png_ptr, infoStructPair.info_ptr);
-
-		const std::size_t rowBytes{png_get_rowbytes(infoStructPair.png_ptr, infoStructPair.info_ptr)};
-		std::vector<byte> bytes(rowBytes * height);
-
-		std::vector<byte *> rows(height);
-		rows[0] = &bytes[0];
-		for (std::size_t i = 1; i < height; ++i)
-			rows[i] = rows[i - 1] + rowBytes;
-
-		png_read_image(infoStructPair.png_ptr, rows.data());
+		auto image{read_png_image(infoStructPair, header.size(), mode)};
+		if (!image)
+		{
+			return std::unexpected<ReadError>({ErrorType::FormatError,
+				fmt::format("Failed to read {}: {}", path, infoStructPair.error)
+			});
+		}
+		VL_PROFILE_PIXELS(image->width() * image->height());
 
-		return vl::Image{std::move(bytes), width, height, PixelFormat::Grayscale8};
+		return std::move(*image);
 	}
 
 	std::expected<void, WriteError> write_png(const Image &image, const std::string &path)
 	{
+		VL_PROFILE_SCOPE("ImageIO::write_png", image.width() * image.height());
+
 		PFILE readFile{fopen(path.c_str(), "wb")};
 		if (readFile == nullptr)
 		{
@@ -158,7 +290,7 @@ namespace vl::ImageIO
 
 		InfoWriteStructPair infoStructPair{};
 		infoStructPair.png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING,
-			nullptr, user_error_fn, user_warning_fn);
+			&infoStructPair.error, user_error_fn, user_warning_fn);
 		if (infoStructPair.png_ptr == nullptr)
 		{
 			return std::unexpected<WriteError>({ErrorType::IOError,
@@ -176,25 +308,95 @@ namespace vl::ImageIO
 
 		png_init_io(infoStructPair.png_ptr, readFile.get());
 
+		if (!write_png_image(infoStructPair, image))
+		{
+			return std::unexpected<WriteError>({ErrorType::IOError,
+				fmt::format("Failed writing to {}: {}", path, infoStructPair.error)
+			});
+		}
 
-		png_set_IHDR(
-			infoStructPair.png_ptr,
-			infoStructPair.info_ptr,
-			image.width(), image.height(),
-			8,
-			PNG_COLOR_TYPE_GRAY,
-			PNG_INTERLACE_NONE,
-			PNG_COMPRESSION_TYPE_DEFAULT,
-			PNG_FILTER_TYPE_DEFAULT
-		);
-		png_write_info(infoStructPair.png_ptr, infoStructPair.info_ptr);
+		return {};
+	}
 
-		std::vector<const byte *> rows(image.height());
-		for (std::size_t i = 0; i < image.height(); ++i)
-			rows[i] = &image[0, i];
+	std::expected<vl::Image, ReadError> decode_png(std::span<const byte> buffer, ColorMode mode)
+	{
+		VL_PROFILE_SCOPE("ImageIO::decode_png", 0);
 
-		png_write_image(infoStructPair.png_ptr, const_cast<byte **>(rows.data()));
+		constexpr std::size_t signatureSize{8};
+		if (buffer.size() < signatureSize || png_sig_cmp(buffer.data(), 0, signatureSize))
+		{
+			return std::unexpected<ReadError>({ErrorType::FormatError,
+				"Failed to decode buffer: This is not a PNG file(header check)"
+			});
+		}
 
-		return {};
+		InfoReadStructPair infoStructPair{};
+		infoStructPair.png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
+			&infoStructPair.error, user_error_fn, user_warning_fn);
+		if (infoStructPair.png_ptr == nullptr)
+		{
+			return std::unexpected<ReadError>({ErrorType::IOError,
+				"Failed to decode buffer: Failed to create png_struct for reading"
+			});
+		}
+
+		infoStructPair.info_ptr = png_create_info_struct(infoStructPair.png_ptr);
+		if (infoStructPair.info_ptr == nullptr)
+		{
+			return std::unexpected<ReadError>({ErrorType::IOError,
+				"Failed to decode buffer: Failed to create png_info for reading"
+			});
+		}
+
+		MemoryReader reader{buffer, signatureSize};
+		png_set_read_fn(infoStructPair.png_ptr, &reader, memory_read_fn);
+
+		auto image{read_png_image(infoStructPair, signatureSize, mode)};
+		if (!image)
+		{
+			return std::unexpected<ReadError>({ErrorType::FormatError,
+				fmt::format("Failed to decode buffer: {}", infoStructPair.error)
+			});
+		}
+		VL_PROFILE_PIXELS(image->width() * image->height());
+
+		return std::move(*image);
+	}
+
+	std::expected<std::vector<byte>, WriteError> encode_png(const Image &image)
+	{
+		VL_PROFILE_SCOPE("ImageIO::encode_png", image.width() * image.height());
+
+		InfoWriteStructPair infoStructPair{};
+		infoStructPair.png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING,
+			&infoStructPair.error, user_error_fn, user_warning_fn);
+		if (infoStructPair.png_ptr == nullptr)
+		{
+			return std::unexpected<WriteError>({ErrorType::IOError,
+				"Failed to encode image: Failed to create png_struct for writing"
+			});
+		}
+
+		infoStructPair.info_ptr = png_create_info_struct(infoStructPair.png_ptr);
+		if (infoStructPair.info_ptr == nullptr)
+		{
+			return std::unexpected<WriteError>({ErrorType::IOError,
+				"Failed to encode image: Failed to create png_info for writing"
+			});
+		}
+
+		std::vector<byte> output{};
+		output.reserve(image.size() / 2);
+		png_set_write_fn(infoStructPair.png_ptr, &output, memory_write_fn, memory_flush_fn);
+
+		if (!write_png_image(infoStructPair, image))
+		{
+			return std::unexpected<WriteError>({ErrorType::IOError,
+				fmt::format("Failed to encode image: {}", infoStructPair.error)
+			});
+		}
+		VL_PROFILE_ALLOCATION(output.capacity());
+
+		return output;
 	}
 }
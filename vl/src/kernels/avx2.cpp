@@ -0,0 +1,2 @@
+#define VL_KERNELS_NAMESPACE avx2
+#include "kernels.inl"
@@ -0,0 +1,2 @@
+#define VL_KERNELS_NAMESPACE avx512
+#include "kernels.inl"
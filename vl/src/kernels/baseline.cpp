@@ -0,0 +1,2 @@
+#define VL_KERNELS_NAMESPACE baseline
+#include "kernels.inl"
@@ -0,0 +1,658 @@
+#include "kernels.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	constexpr std::size_t LookupSliceSize{16};
+
+	void accumulate_row(double *__restrict sums, const vl::byte *__restrict source, double weight, std::size_t count)
+	{
+		for (std::size_t x = 0; x < count; ++x)
+			sums[x] += weight * source[x];
+	}
+
+	void store_clamped_row(const double *__restrict sums, vl::byte *__restrict destination, std::size_t count)
+	{
+		for (std::size_t x = 0; x < count; ++x)
+		{
+			const double clamped{sums[x] < 0. ? 0. : (sums[x] > 256. ? 256. : sums[x])};
+			destination[x] = static_cast<vl::byte>(static_cast<int>(clamped));
+		}
+	}
+
+	void min_row(vl::byte *__restrict destination, const vl::byte *__restrict source, std::size_t count)
+	{
+		for (std::size_t x = 0; x < count; ++x)
+			destination[x] = source[x] < destination[x] ? source[x] : destination[x];
+	}
+
+	void max_row(vl::byte *__restrict destination, const vl::byte *__restrict source, std::size_t count)
+	{
+		for (std::size_t x = 0; x < count; ++x)
+			destination[x] = source[x] > destination[x] ? source[x] : destination[x];
+	}
+
+	void compare_exchange_rows(vl::byte *__restrict lower, vl::byte *__restrict upper, std::size_t count)
+	{
+		for (std::size_t x = 0; x < count; ++x)
+		{
+			const vl::byte first{lower[x]};
+			const vl::byte second{upper[x]};
+			lower[x] = first < second ? first : second;
+			upper[x] = first < second ? second : first;
+		}
+	}
+
+	void add_row(vl::byte *destination, const vl::byte *source, std::size_t count)
+	{
+		for (std::size_t x = 0; x < count; ++x)
+			destination[x] += source[x];
+	}
+
+	void subtract_row(vl::byte *destination, const vl::byte *source, std::size_t count)
+	{
+		for (std::size_t x = 0; x < count; ++x)
+			destination[x] -= source[x];
+	}
+
+	void multiply_row(vl::byte *destination, const vl::byte *source, std::size_t count)
+	{
+		for (std::size_t x = 0; x < count; ++x)
+			destination[x] *= source[x];
+	}
+
+	void divide_row(vl::byte *destination, const vl::byte *source, std::size_t count)
+	{
+		for (std::size_t x = 0; x < count; ++x)
+			destination[x] /= source[x];
+	}
+
+#if defined(__AVX512BW__)
+	constexpr std::size_t LookupBlock{64};
+
+	std::size_t lookup_row(const vl::byte *table, const vl::byte *source, vl::byte *destination, std::size_t count)
+	{
+		__m512i slices[256 / LookupSliceSize];
+		for (std::size_t slice = 0; slice < 256 / LookupSliceSize; ++slice)
+			slices[slice] = _mm512_broadcast_i32x4(
+				_mm_load_si128(reinterpret_cast<const __m128i *>(table + slice * LookupSliceSize)));
+
+		const __m512i sliceStep{_mm512_set1_epi8(LookupSliceSize)};
+		const __m512i inRangeBias{_mm512_set1_epi8(0x70)};
+
+		std::size_t i{0};
+		for (; i + LookupBlock <= count; i += LookupBlock)
+		{
+			__m512i indices{_mm512_loadu_si512(source + i)};
+			__m512i result{_mm512_setzero_si512()};
+			for (const auto &slice : slices)
+			{
+				result = _mm512_or_si512(result, _mm512_shuffle_epi8(slice, _mm512_adds_epu8(indices, inRangeBias)));
+				indices = _mm512_sub_epi8(indices, sliceStep);
+			}
+			_mm512_storeu_si512(destination + i, result);
+		}
+
+		return i;
+	}
+
+	__attribute__((target("avx512vbmi")))
+	std::size_t lookup_row_vbmi(const vl::byte *table, const vl::byte *source, vl::byte *destination, std::size_t count)
+	{
+		const __m512i quarter0{_mm512_loadu_si512(table)};
+		const __m512i quarter1{_mm512_loadu_si512(table + 64)};
+		const __m512i quarter2{_mm512_loadu_si512(table + 128)};
+		const __m512i quarter3{_mm512_loadu_si512(table + 192)};
+
+		std::size_t i{0};
+		for (; i + LookupBlock <= count; i += LookupBlock)
+		{
+			const __m512i values{_mm512_loadu_si512(source + i)};
+			const __m512i lower{_mm512_permutex2var_epi8(quarter0, values, quarter1)};
+			const __m512i upper{_mm512_permutex2var_epi8(quarter2, values, quarter3)};
+			_mm512_storeu_si512(destination + i, _mm512_mask_blend_epi8(_mm512_movepi8_mask(values), lower, upper));
+		}
+
+		return i;
+	}
+
+	auto select_lookup_row()
+	{
+		return __builtin_cpu_supports("avx512vbmi") ? lookup_row_vbmi : lookup_row;
+	}
+#elif defined(__AVX2__)
+	constexpr std::size_t LookupBlock{32};
+
+	std::size_t lookup_row(const vl::byte *table, const vl::byte *source, vl::byte *destination, std::size_t count)
+	{
+		__m256i slices[256 / LookupSliceSize];
+		for (std::size_t slice = 0; slice < 256 / LookupSliceSize; ++slice)
+			slices[slice] = _mm256_broadcastsi128_si256(
+				_mm_load_si128(reinterpret_cast<const __m128i *>(table + slice * LookupSliceSize)));
+
+		const __m256i sliceStep{_mm256_set1_epi8(LookupSliceSize)};
+		const __m256i inRangeBias{_mm256_set1_epi8(0x70)};
+
+		std::size_t i{0};
+		for (; i + LookupBlock <= count; i += LookupBlock)
+		{
+			__m256i indices{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i))};
+			__m256i result{_mm256_setzero_si256()};
+			for (const auto &slice : slices)
+			{
+				result = _mm256_or_si256(result, _mm256_shuffle_epi8(slice, _mm256_adds_epu8(indices, inRangeBias)));
+				indices = _mm256_sub_epi8(indices, sliceStep);
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i), result);
+		}
+
+		return i;
+	}
+
+	auto select_lookup_row()
+	{
+		return lookup_row;
+	}
+#else
+	std::size_t lookup_row(const vl::byte *, const vl::byte *, vl::byte *, std::size_t)
+	{
+		return 0;
+	}
+
+	auto select_lookup_row()
+	{
+		return lookup_row;
+	}
+#endif
+}
+
+namespace
+{
+	template<std::size_t Channels>
+	void deinterleave_scalar(const vl::byte *__restrict source, vl::byte *const *planes, std::size_t first, std::size_t count)
+	{
+		for (std::size_t channel = 0; channel < Channels; ++channel)
+		{
+			vl::byte *__restrict plane{planes[channel]};
+			for (std::size_t x = first; x < count; ++x)
+				plane[x] = source[x * Channels + channel];
+		}
+	}
+
+	template<std::size_t Channels>
+	void interleave_scalar(const vl::byte *const *planes, vl::byte *__restrict destination, std::size_t first, std::size_t count)
+	{
+		for (std::size_t channel = 0; channel < Channels; ++channel)
+		{
+			const vl::byte *__restrict plane{planes[channel]};
+			for (std::size_t x = first; x < count; ++x)
+				destination[x * Channels + channel] = plane[x];
+		}
+	}
+
+#if defined(__AVX2__)
+	constexpr std::size_t RgbBlock{16};
+	constexpr std::size_t RgbaBlock{32};
+
+	using ShuffleMasks = std::array<std::array<std::array<char, 16>, 3>, 3>;
+
+	constexpr ShuffleMasks rgb_deinterleave_masks()
+	{
+		ShuffleMasks masks{};
+		for (int channel = 0; channel < 3; ++channel)
+			for (int part = 0; part < 3; ++part)
+				for (int pixel = 0; pixel < 16; ++pixel)
+				{
+					const int index{pixel * 3 + channel - part * 16};
+					masks[channel][part][pixel] = index >= 0 && index < 16 ? index : -128;
+				}
+
+		return masks;
+	}
+
+	constexpr ShuffleMasks rgb_interleave_masks()
+	{
+		ShuffleMasks masks{};
+		for (int part = 0; part < 3; ++part)
+			for (int channel = 0; channel < 3; ++channel)
+				for (int i = 0; i < 16; ++i)
+				{
+					const int index{part * 16 + i};
+					masks[part][channel][i] = index % 3 == channel ? index / 3 : -128;
+				}
+
+		return masks;
+	}
+
+	constexpr ShuffleMasks RgbDeinterleaveMasks{rgb_deinterleave_masks()};
+	constexpr ShuffleMasks RgbInterleaveMasks{rgb_interleave_masks()};
+
+	inline __m128i load_mask(const std::array<char, 16> &mask)
+	{
+		return _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask.data()));
+	}
+
+	inline void load_rgb_channels(const vl::byte *source, __m128i (&channels)[3])
+	{
+		const __m128i parts[3]{
+			_mm_loadu_si128(reinterpret_cast<const __m128i *>(source)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 16)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 32))
+		};
+		for (std::size_t channel = 0; channel < 3; ++channel)
+		{
+			const auto &masks{RgbDeinterleaveMasks[channel]};
+			channels[channel] = _mm_or_si128(_mm_or_si128(
+				_mm_shuffle_epi8(parts[0], load_mask(masks[0])),
+				_mm_shuffle_epi8(parts[1], load_mask(masks[1]))),
+				_mm_shuffle_epi8(parts[2], load_mask(masks[2])));
+		}
+	}
+
+	inline void load_rgba_channels(const vl::byte *source, __m256i (&channels)[4])
+	{
+		const __m256i transpose{_mm256_setr_epi8(
+			0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+			0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15)};
+		const __m256i gather{_mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)};
+
+		__m256i groups[4];
+		for (std::size_t i = 0; i < 4; ++i)
+		{
+			const __m256i pixels{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i * 32))};
+			groups[i] = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(pixels, transpose), gather);
+		}
+
+		const __m256i redBlue0{_mm256_unpacklo_epi64(groups[0], groups[1])};
+		const __m256i greenAlpha0{_mm256_unpackhi_epi64(groups[0], groups[1])};
+		const __m256i redBlue1{_mm256_unpacklo_epi64(groups[2], groups[3])};
+		const __m256i greenAlpha1{_mm256_unpackhi_epi64(groups[2], groups[3])};
+		channels[0] = _mm256_permute2x128_si256(redBlue0, redBlue1, 0x20);
+		channels[1] = _mm256_permute2x128_si256(greenAlpha0, greenAlpha1, 0x20);
+		channels[2] = _mm256_permute2x128_si256(redBlue0, redBlue1, 0x31);
+		channels[3] = _mm256_permute2x128_si256(greenAlpha0, greenAlpha1, 0x31);
+	}
+
+	std::size_t deinterleave_rgb(const vl::byte *source, vl::byte *const *planes, std::size_t count)
+	{
+		std::size_t x{0};
+		for (; x + RgbBlock <= count; x += RgbBlock)
+		{
+			__m128i channels[3];
+			load_rgb_channels(source + x * 3, channels);
+			for (std::size_t channel = 0; channel < 3; ++channel)
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(planes[channel] + x), channels[channel]);
+		}
+
+		return x;
+	}
+
+	std::size_t interleave_rgb(const vl::byte *const *planes, vl::byte *destination, std::size_t count)
+	{
+		std::size_t x{0};
+		for (; x + RgbBlock <= count; x += RgbBlock)
+		{
+			const __m128i channels[3]{
+				_mm_loadu_si128(reinterpret_cast<const __m128i *>(planes[0] + x)),
+				_mm_loadu_si128(reinterpret_cast<const __m128i *>(planes[1] + x)),
+				_mm_loadu_si128(reinterpret_cast<const __m128i *>(planes[2] + x))
+			};
+			for (std::size_t part = 0; part < 3; ++part)
+			{
+				const auto &masks{RgbInterleaveMasks[part]};
+				const __m128i values{_mm_or_si128(_mm_or_si128(
+					_mm_shuffle_epi8(channels[0], load_mask(masks[0])),
+					_mm_shuffle_epi8(channels[1], load_mask(masks[1]))),
+					_mm_shuffle_epi8(channels[2], load_mask(masks[2])))};
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(destination + x * 3 + part * 16), values);
+			}
+		}
+
+		return x;
+	}
+
+	std::size_t deinterleave_rgba(const vl::byte *source, vl::byte *const *planes, std::size_t count)
+	{
+		std::size_t x{0};
+		for (; x + RgbaBlock <= count; x += RgbaBlock)
+		{
+			__m256i channels[4];
+			load_rgba_channels(source + x * 4, channels);
+			for (std::size_t channel = 0; channel < 4; ++channel)
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(planes[channel] + x), channels[channel]);
+		}
+
+		return x;
+	}
+
+	std::size_t interleave_rgba(const vl::byte *const *planes, vl::byte *destination, std::size_t count)
+	{
+		const __m256i transpose{_mm256_setr_epi8(
+			0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+			0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15)};
+		const __m256i scatter{_mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7)};
+
+		std::size_t x{0};
+		for (; x + RgbaBlock <= count; x += RgbaBlock)
+		{
+			const __m256i red{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(planes[0] + x))};
+			const __m256i green{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(planes[1] + x))};
+			const __m256i blue{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(planes[2] + x))};
+			const __m256i alpha{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(planes[3] + x))};
+
+			const __m256i redBlue0{_mm256_permute2x128_si256(red, blue, 0x20)};
+			const __m256i redBlue1{_mm256_permute2x128_si256(red, blue, 0x31)};
+			const __m256i greenAlpha0{_mm256_permute2x128_si256(green, alpha, 0x20)};
+			const __m256i greenAlpha1{_mm256_permute2x128_si256(green, alpha, 0x31)};
+			const __m256i groups[4]{
+				_mm256_unpacklo_epi64(redBlue0, greenAlpha0),
+				_mm256_unpackhi_epi64(redBlue0, greenAlpha0),
+				_mm256_unpacklo_epi64(redBlue1, greenAlpha1),
+				_mm256_unpackhi_epi64(redBlue1, greenAlpha1)
+			};
+			for (std::size_t i = 0; i < 4; ++i)
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + x * 4 + i * 32),
+					_mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(groups[i], scatter), transpose));
+		}
+
+		return x;
+	}
+#else
+	std::size_t deinterleave_rgb(const vl::byte *, vl::byte *const *, std::size_t)
+	{
+		return 0;
+	}
+
+	std::size_t interleave_rgb(const vl::byte *const *, vl::byte *, std::size_t)
+	{
+		return 0;
+	}
+
+	std::size_t deinterleave_rgba(const vl::byte *, vl::byte *const *, std::size_t)
+	{
+		return 0;
+	}
+
+	std::size_t interleave_rgba(const vl::byte *const *, vl::byte *, std::size_t)
+	{
+		return 0;
+	}
+#endif
+
+	constexpr std::uint32_t RedCoefficient{6968};
+	constexpr std::uint32_t GreenCoefficient{23434};
+	constexpr std::uint32_t BlueCoefficient{2366};
+	constexpr std::uint32_t CoefficientsShift{15};
+
+	template<std::size_t Channels>
+	void to_gray_scalar(const vl::byte *__restrict source, vl::byte *__restrict destination, std::size_t first, std::size_t count)
+	{
+		for (std::size_t x = first; x < count; ++x)
+		{
+			const std::uint32_t red{source[x * Channels]};
+			const std::uint32_t green{source[x * Channels + 1]};
+			const std::uint32_t blue{source[x * Channels + 2]};
+			destination[x] = (RedCoefficient * red + GreenCoefficient * green + BlueCoefficient * blue
+				+ (1u << (CoefficientsShift - 1))) >> CoefficientsShift;
+		}
+	}
+
+	void gray16_to_gray8_scalar(const std::uint16_t *__restrict source, vl::byte *__restrict destination,
+		std::size_t first, std::size_t count)
+	{
+		for (std::size_t x = first; x < count; ++x)
+			destination[x] = (static_cast<std::uint32_t>(source[x]) * 255 + 32895) >> 16;
+	}
+
+#if defined(__AVX2__)
+	constexpr std::size_t Gray16Block{16};
+
+	inline __m128i weighted_gray(__m128i red, __m128i green, __m128i blue)
+	{
+		const __m256i redGreenCoefficients{_mm256_set1_epi32(RedCoefficient | GreenCoefficient << 16)};
+		const __m256i blueRoundCoefficients{_mm256_set1_epi32(BlueCoefficient | (1u << (CoefficientsShift - 1)) << 16)};
+		const __m256i ones{_mm256_set1_epi16(1)};
+
+		const __m256i red16{_mm256_cvtepu8_epi16(red)};
+		const __m256i green16{_mm256_cvtepu8_epi16(green)};
+		const __m256i blue16{_mm256_cvtepu8_epi16(blue)};
+		const __m256i lower{_mm256_srli_epi32(_mm256_add_epi32(
+			_mm256_madd_epi16(_mm256_unpacklo_epi16(red16, green16), redGreenCoefficients),
+			_mm256_madd_epi16(_mm256_unpacklo_epi16(blue16, ones), blueRoundCoefficients)), CoefficientsShift)};
+		const __m256i upper{_mm256_srli_epi32(_mm256_add_epi32(
+			_mm256_madd_epi16(_mm256_unpackhi_epi16(red16, green16), redGreenCoefficients),
+			_mm256_madd_epi16(_mm256_unpackhi_epi16(blue16, ones), blueRoundCoefficients)), CoefficientsShift)};
+
+		const __m256i words{_mm256_packus_epi32(lower, upper)};
+		const __m256i bytes{_mm256_packus_epi16(words, words)};
+		return _mm256_castsi256_si128(_mm256_permute4x64_epi64(bytes, 0x08));
+	}
+
+	std::size_t rgb_to_gray(const vl::byte *source, vl::byte *destination, std::size_t count)
+	{
+		std::size_t x{0};
+		for (; x + RgbBlock <= count; x += RgbBlock)
+		{
+			__m128i channels[3];
+			load_rgb_channels(source + x * 3, channels);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(destination + x), weighted_gray(channels[0], channels[1], channels[2]));
+		}
+
+		return x;
+	}
+
+	std::size_t rgba_to_gray(const vl::byte *source, vl::byte *destination, std::size_t count)
+	{
+		std::size_t x{0};
+		for (; x + RgbaBlock <= count; x += RgbaBlock)
+		{
+			__m256i channels[4];
+			load_rgba_channels(source + x * 4, channels);
+			for (int half = 0; half < 2; ++half)
+			{
+				const __m128i red{half ? _mm256_extracti128_si256(channels[0], 1) : _mm256_castsi256_si128(channels[0])};
+				const __m128i green{half ? _mm256_extracti128_si256(channels[1], 1) : _mm256_castsi256_si128(channels[1])};
+				const __m128i blue{half ? _mm256_extracti128_si256(channels[2], 1) : _mm256_castsi256_si128(channels[2])};
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(destination + x + half * 16), weighted_gray(red, green, blue));
+			}
+		}
+
+		return x;
+	}
+
+	std::size_t gray16_to_gray8(const std::uint16_t *source, vl::byte *destination, std::size_t count)
+	{
+		const __m256i scale{_mm256_set1_epi32(255)};
+		const __m256i round{_mm256_set1_epi32(32895)};
+
+		std::size_t x{0};
+		for (; x + Gray16Block <= count; x += Gray16Block)
+		{
+			const __m256i values{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + x))};
+			const __m256i lower{_mm256_srli_epi32(_mm256_add_epi32(
+				_mm256_mullo_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(values)), scale), round), 16)};
+			const __m256i upper{_mm256_srli_epi32(_mm256_add_epi32(
+				_mm256_mullo_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(values, 1)), scale), round), 16)};
+			const __m256i words{_mm256_permute4x64_epi64(_mm256_packus_epi32(lower, upper), 0xd8)};
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(destination + x),
+				_mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1)));
+		}
+
+		return x;
+	}
+#else
+	std::size_t rgb_to_gray(const vl::byte *, vl::byte *, std::size_t)
+	{
+		return 0;
+	}
+
+	std::size_t rgba_to_gray(const vl::byte *, vl::byte *, std::size_t)
+	{
+		return 0;
+	}
+
+	std::size_t gray16_to_gray8(const std::uint16_t *, vl::byte *, std::size_t)
+	{
+		return 0;
+	}
+#endif
+
+	void to_gray_row(const vl::byte *source, vl::byte *destination, std::size_t channels, std::size_t count)
+	{
+		switch (channels)
+		{
+			case 3:
+				to_gray_scalar<3>(source, destination, rgb_to_gray(source, destination, count), count);
+				break;
+			case 4:
+				to_gray_scalar<4>(source, destination, rgba_to_gray(source, destination, count), count);
+				break;
+			default:
+				std::copy_n(source, count, destination);
+				break;
+		}
+	}
+
+	void gray16_to_gray8_row(const std::uint16_t *source, vl::byte *destination, std::size_t count)
+	{
+		gray16_to_gray8_scalar(source, destination, gray16_to_gray8(source, destination, count), count);
+	}
+
+#if defined(__AVX2__)
+	constexpr std::size_t SampleBlock{8};
+
+	std::size_t sample_bilinear_row(const vl::byte *pixels, std::size_t width, std::size_t height,
+		const float *xs, const float *ys, vl::byte *destination, std::size_t count)
+	{
+		if (width < 2 || height < 2 || width * height > std::numeric_limits<std::int32_t>::max())
+			return 0;
+
+		const __m256 zero{_mm256_setzero_ps()};
+		const __m256 half{_mm256_set1_ps(0.5f)};
+		const __m256 maximum{_mm256_set1_ps(255.f)};
+		const __m256 lastX{_mm256_set1_ps(width - 1)};
+		const __m256 lastY{_mm256_set1_ps(height - 1)};
+		const __m256i stride{_mm256_set1_epi32(width)};
+		const __m256i lastGather{_mm256_set1_epi32(width * height - 4)};
+		const __m256i byteMask{_mm256_set1_epi32(0xff)};
+		const int *base{reinterpret_cast<const int *>(pixels)};
+
+		std::size_t i{0};
+		for (; i + SampleBlock <= count; i += SampleBlock)
+		{
+			const __m256 x{_mm256_loadu_ps(xs + i)};
+			const __m256 y{_mm256_loadu_ps(ys + i)};
+			const __m256 inside{_mm256_and_ps(
+				_mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_GE_OQ), _mm256_cmp_ps(x, lastX, _CMP_LT_OQ)),
+				_mm256_and_ps(_mm256_cmp_ps(y, zero, _CMP_GE_OQ), _mm256_cmp_ps(y, lastY, _CMP_LT_OQ)))};
+			if (_mm256_movemask_ps(inside) != 0xff)
+				break;
+
+			const __m256 left{_mm256_floor_ps(x)};
+			const __m256 top{_mm256_floor_ps(y)};
+			const __m256i upperIndex{_mm256_add_epi32(
+				_mm256_mullo_epi32(_mm256_cvttps_epi32(top), stride), _mm256_cvttps_epi32(left))};
+			const __m256i lowerIndex{_mm256_add_epi32(upperIndex, stride)};
+			if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(lowerIndex, lastGather)) != 0)
+				break;
+
+			const __m256i upperPairs{_mm256_i32gather_epi32(base, upperIndex, 1)};
+			const __m256i lowerPairs{_mm256_i32gather_epi32(base, lowerIndex, 1)};
+			const __m256i upperLeft{_mm256_and_si256(upperPairs, byteMask)};
+			const __m256i upperRight{_mm256_and_si256(_mm256_srli_epi32(upperPairs, 8), byteMask)};
+			const __m256i lowerLeft{_mm256_and_si256(lowerPairs, byteMask)};
+			const __m256i lowerRight{_mm256_and_si256(_mm256_srli_epi32(lowerPairs, 8), byteMask)};
+
+			const __m256 xFraction{_mm256_sub_ps(x, left)};
+			const __m256 yFraction{_mm256_sub_ps(y, top)};
+			const __m256 upper{_mm256_add_ps(_mm256_cvtepi32_ps(upperLeft),
+				_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(upperRight, upperLeft)), xFraction))};
+			const __m256 lower{_mm256_add_ps(_mm256_cvtepi32_ps(lowerLeft),
+				_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(lowerRight, lowerLeft)), xFraction))};
+			const __m256 value{_mm256_add_ps(upper, _mm256_mul_ps(_mm256_sub_ps(lower, upper), yFraction))};
+			const __m256i result{_mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_add_ps(value, half), zero), maximum))};
+
+			const __m128i words{_mm_packus_epi32(_mm256_castsi256_si128(result), _mm256_extracti128_si256(result, 1))};
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(destination + i), _mm_packus_epi16(words, words));
+		}
+
+		return i;
+	}
+#else
+	std::size_t sample_bilinear_row(const vl::byte *, std::size_t, std::size_t,
+		const float *, const float *, vl::byte *, std::size_t)
+	{
+		return 0;
+	}
+#endif
+
+	void deinterleave_row(const vl::byte *source, vl::byte *const *planes, std::size_t channels, std::size_t count)
+	{
+		switch (channels)
+		{
+			case 3:
+				deinterleave_scalar<3>(source, planes, deinterleave_rgb(source, planes, count), count);
+				break;
+			case 4:
+				deinterleave_scalar<4>(source, planes, deinterleave_rgba(source, planes, count), count);
+				break;
+			default:
+				for (std::size_t channel = 0; channel < channels; ++channel)
+					for (std::size_t x = 0; x < count; ++x)
+						planes[channel][x] = source[x * channels + channel];
+				break;
+		}
+	}
+
+	void interleave_row(const vl::byte *const *planes, vl::byte *destination, std::size_t channels, std::size_t count)
+	{
+		switch (channels)
+		{
+			case 3:
+				interleave_scalar<3>(planes, destination, interleave_rgb(planes, destination, count), count);
+				break;
+			case 4:
+				interleave_scalar<4>(planes, destination, interleave_rgba(planes, destination, count), count);
+				break;
+			default:
+				for (std::size_t channel = 0; channel < channels; ++channel)
+					for (std::size_t x = 0; x < count; ++x)
+						destination[x * channels + channel] = planes[channel][x];
+				break;
+		}
+	}
+}
+
+namespace vl::kernels::VL_KERNELS_NAMESPACE
+{
+	const Table &table()
+	{
+		static const Table kernels{
+			accumulate_row,
+			store_clamped_row,
+			min_row,
+			max_row,
+			compare_exchange_rows,
+			add_row,
+			subtract_row,
+			multiply_row,
+			divide_row,
+			select_lookup_row(),
+			deinterleave_row,
+			interleave_row,
+			to_gray_row,
+			gray16_to_gray8_row,
+			sample_bilinear_row
+		};
+
+		return kernels;
+	}
+}
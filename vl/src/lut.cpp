@@ -0,0 +1,133 @@
+#include "lut.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <fmt/format.h>
+
+#include "kernels.h"
+#include "parallel.h"
+#include "profiling.h"
+
+namespace
+{
+	constexpr std::size_t RowsGrain{16};
+	constexpr std::size_t ScalarBlock{32};
+
+	void lookup_scalar(const vl::byte *__restrict table, const vl::byte *source,
+		vl::byte *destination, std::size_t count)
+	{
+		std::size_t i{0};
+		for (; i + ScalarBlock <= count; i += ScalarBlock)
+			for (std::size_t j = 0; j < ScalarBlock; ++j)
+				destination[i + j] = table[source[i + j]];
+		for (; i < count; ++i)
+			destination[i] = table[source[i]];
+	}
+}
+
+namespace vl
+{
+	Lut::Lut()
+	{
+		std::iota(m_table.begin(), m_table.end(), 0);
+	}
+
+	Lut::Lut(const std::array<byte, Size> &table)
+		: m_table{table}
+	{
+	}
+
+	Lut Lut::threshold(byte level)
+	{
+		Lut lut;
+		for (std::size_t value = 0; value < Size; ++value)
+			lut.m_table[value] = value >= level ? 255 : 0;
+
+		return lut;
+	}
+
+	Lut Lut::gamma(double gamma)
+	{
+		Lut lut;
+		if (gamma <= 0)
+		{
+			fmt::println("Invalid gamma: {}", gamma);
+			return lut;
+		}
+
+		for (std::size_t value = 0; value < Size; ++value)
+			lut.m_table[value] = std::lround(std::pow(value / 255., gamma) * 255.);
+
+		return lut;
+	}
+
+	Lut Lut::invert()
+	{
+		Lut lut;
+		for (std::size_t value = 0; value < Size; ++value)
+			lut.m_table[value] = 255 - value;
+
+		return lut;
+	}
+
+	Lut Lut::then(const Lut &next) const
+	{
+		Lut composed;
+		for (std::size_t value = 0; value < Size; ++value)
+			composed.m_table[value] = next.m_table[m_table[value]];
+
+		return composed;
+	}
+
+	void Lut::apply_row(const byte *source, byte *destination, std::size_t count) const
+	{
+		const std::size_t processed{kernels::table().lookup_row(m_table.data(), source, destination, count)};
+		lookup_scalar(m_table.data(), source + processed, destination + processed, count - processed);
+	}
+
+	void Lut::apply(Image &image) const
+	{
+		VL_PROFILE_SCOPE("Lut::apply", image.width() * image.height());
+
+		if (image.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return;
+		}
+
+		const std::size_t width{image.width()};
+		const std::size_t channels{image.channels()};
+		const bool keepAlpha{image.color_channels() != channels};
+		vl::parallel::for_range(0, image.height(), [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			std::vector<byte> alpha(keepAlpha ? width : 0);
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				byte *row{image.row(y)};
+				for (std::size_t x = 0; x < alpha.size(); ++x)
+					alpha[x] = row[x * channels + channels - 1];
+				apply_row(row, row, width * channels);
+				for (std::size_t x = 0; x < alpha.size(); ++x)
+					row[x * channels + channels - 1] = alpha[x];
+			}
+		}, RowsGrain);
+	}
+
+	LutPipeline &LutPipeline::add(const Lut &lut)
+	{
+		m_composed = m_composed.then(lut);
+		++m_stagesCount;
+
+		return *this;
+	}
+
+	void LutPipeline::apply(Image &image) const
+	{
+		if (m_stagesCount == 0)
+			return;
+
+		m_composed.apply(image);
+	}
+}
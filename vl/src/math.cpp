@@ -1,62 +1,484 @@
 #include "math.h"
 
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
 #include <fmt/format.h>
 
+#include "parallel.h"
+
+namespace
+{
+	constexpr std::size_t HistogramBanks{4};
+	constexpr std::size_t HistogramRowsGrain{16};
+	constexpr std::size_t IntegralRowsGrain{32};
+	constexpr std::size_t IntegralColumnsBlock{1024};
+	constexpr std::size_t StatisticsRowsGrain{16};
+	constexpr std::size_t DistanceRowsGrain{16};
+	constexpr std::size_t DistanceColumnsGrain{64};
+	constexpr double DistanceInfinity{1e20};
+
+	using Bank = std::array<std::size_t, vl::math::Histogram::Bins>;
+
+	void count_row(const vl::byte *row, std::size_t width, std::array<Bank, HistogramBanks> &banks)
+	{
+		std::size_t x{0};
+		for (; x + HistogramBanks <= width; x += HistogramBanks)
+		{
+			++banks[0][row[x]];
+			++banks[1][row[x + 1]];
+			++banks[2][row[x + 2]];
+			++banks[3][row[x + 3]];
+		}
+		for (; x < width; ++x)
+			++banks[0][row[x]];
+	}
+
+	template<typename T>
+	vl::math::Statistics row_statistics(const T *__restrict row, std::size_t width)
+	{
+		T min{row[0]};
+		T max{row[0]};
+		std::uint64_t sum{0};
+		std::uint64_t sumOfSquares{0};
+		for (std::size_t x = 0; x < width; ++x)
+		{
+			const std::uint64_t value{row[x]};
+			min = std::min(min, row[x]);
+			max = std::max(max, row[x]);
+			sum += value;
+			sumOfSquares += value * value;
+		}
+
+		const double mean{(double)sum / width};
+		const double squaredDeviations{std::max((double)sumOfSquares - (double)sum * mean, 0.)};
+		return {width, (double)min, (double)max, (double)sum, (double)sumOfSquares,
+			mean, std::sqrt(squaredDeviations / width)};
+	}
+
+	class LowerEnvelope
+	{
+	public:
+		explicit LowerEnvelope(std::size_t size)
+			: m_parabolas(size)
+			, m_boundaries(size + 1)
+			, values(size)
+			, distances(size)
+		{
+		}
+
+		void compute(std::size_t size)
+		{
+			if (size == 0)
+				return;
+
+			std::size_t k{0};
+			m_parabolas[0] = 0;
+			m_boundaries[0] = -DistanceInfinity;
+			m_boundaries[1] = DistanceInfinity;
+			for (std::size_t q = 1; q < size; ++q)
+			{
+				double intersection{parabolas_intersection(q, m_parabolas[k])};
+				while (intersection <= m_boundaries[k])
+					intersection = parabolas_intersection(q, m_parabolas[--k]);
+
+				++k;
+				m_parabolas[k] = q;
+				m_boundaries[k] = intersection;
+				m_boundaries[k + 1] = DistanceInfinity;
+			}
+
+			k = 0;
+			for (std::size_t q = 0; q < size; ++q)
+			{
+				while (m_boundaries[k + 1] < q)
+					++k;
+				const double offset = (double)q - m_parabolas[k];
+				distances[q] = offset * offset + values[m_parabolas[k]];
+			}
+		}
+
+	private:
+		inline double parabolas_intersection(std::size_t first, std::size_t second) const
+		{
+			const double firstPosition = first;
+			const double secondPosition = second;
+			return ((values[first] + firstPosition * firstPosition) - (values[second] + secondPosition * secondPosition))
+				/ (2 * (firstPosition - secondPosition));
+		}
+
+		std::vector<std::size_t> m_parabolas;
+		std::vector<double> m_boundaries;
+
+	public:
+		std::vector<double> values;
+		std::vector<double> distances;
+	};
+}
+
 namespace vl::math
 {
-	double entropy(const Image &image)
+	std::optional<Matrix<double>> solve(Matrix<double> coefficients, Matrix<double> constants)
+	{
+		const std::size_t rank{coefficients.rows()};
+		if (coefficients.cols() != rank || constants.rows() != rank)
+			return {};
+
+		for (std::size_t pivot = 0; pivot < rank; ++pivot)
+		{
+			std::size_t pivotRow{pivot};
+			for (std::size_t row = pivot + 1; row < rank; ++row)
+				if (std::abs(coefficients[row, pivot]) > std::abs(coefficients[pivotRow, pivot]))
+					pivotRow = row;
+
+			if (std::abs(coefficients[pivotRow, pivot]) < 1e-12)
+				return {};
+
+			if (pivotRow != pivot)
+			{
+				for (std::size_t col = 0; col < rank; ++col)
+					std::swap(coefficients[pivot, col], coefficients[pivotRow, col]);
+				for (std::size_t col = 0; col < constants.cols(); ++col)
+					std::swap(constants[pivot, col], constants[pivotRow, col]);
+			}
+
+			for (std::size_t row = pivot + 1; row < rank; ++row)
+			{
+				const double factor{coefficients[row, pivot] / coefficients[pivot, pivot]};
+				for (std::size_t col = pivot; col < rank; ++col)
+					coefficients[row, col] -= factor * coefficients[pivot, col];
+				for (std::size_t col = 0; col < constants.cols(); ++col)
+					constants[row, col] -= factor * constants[pivot, col];
+			}
+		}
+
+		Matrix<double> solution(rank, constants.cols());
+		for (std::size_t row = rank; row-- > 0;)
+		{
+			for (std::size_t col = 0; col < constants.cols(); ++col)
+			{
+				double value{constants[row, col]};
+				for (std::size_t known = row + 1; known < rank; ++known)
+					value -= coefficients[row, known] * solution[known, col];
+				solution[row, col] = value / coefficients[row, row];
+			}
+		}
+
+		return solution;
+	}
+
+	Histogram::Histogram(const Image &image)
+		: Histogram(image, 0, 0, image.width(), image.height())
+	{
+	}
+
+	Histogram::Histogram(const Image &image, std::size_t x, std::size_t y, std::size_t width, std::size_t height)
 	{
 		if (image.format() != PixelFormat::Grayscale8)
 		{
 			fmt::println("Non grayscale formats are not supported");
+			return;
+		}
+		if (x > image.width() || width > image.width() - x || y > image.height() || height > image.height() - y)
+		{
+			fmt::println("Invalid histogram region: {}x{}+{}+{} for image {}x{}",
+				width, height, x, y, image.width(), image.height());
+			return;
+		}
+
+		std::mutex mergeMutex;
+		vl::parallel::for_range(y, y + height, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			std::array<Bank, HistogramBanks> banks{};
+			for (std::size_t row = firstRow; row < lastRow; ++row)
+				count_row(image.row(row) + x, width, banks);
+
+			std::lock_guard lock{mergeMutex};
+			for (const auto &bank : banks)
+				for (std::size_t bin = 0; bin < Bins; ++bin)
+					m_bins[bin] += bank[bin];
+		}, HistogramRowsGrain);
+
+		m_count = width * height;
+	}
+
+	Histogram &Histogram::operator+=(const Histogram &other)
+	{
+		for (std::size_t bin = 0; bin < Bins; ++bin)
+			m_bins[bin] += other.m_bins[bin];
+		m_count += other.m_count;
+
+		return *this;
+	}
+
+	double Histogram::mean() const
+	{
+		if (m_count == 0)
 			return 0;
+
+		double sum{0};
+		for (std::size_t bin = 0; bin < Bins; ++bin)
+			sum += (double)m_bins[bin] * bin;
+
+		return sum / m_count;
+	}
+
+	double Histogram::std_dev() const
+	{
+		if (m_count == 0)
+			return 0;
+
+		const double histogramMean{mean()};
+		double variance{0};
+		for (std::size_t bin = 0; bin < Bins; ++bin)
+		{
+			const double deviation{bin - histogramMean};
+			variance += m_bins[bin] * deviation * deviation;
 		}
-		std::array<std::size_t, 256> frequencies{};
-		for (const auto val : image)
-			++frequencies[val];
 
+		return std::sqrt(variance / m_count);
+	}
+
+	double Histogram::entropy() const
+	{
 		double entropy{0};
-		const double size = image.width() * image.height(); 
-		for (std::size_t i = 0; i < frequencies.size(); ++i)
+		const double size = m_count;
+		for (std::size_t bin = 0; bin < Bins; ++bin)
 		{
-			if (frequencies[i] == 0) continue;
+			if (m_bins[bin] == 0) continue;
 
-			const double possibility{frequencies[i] / size};
+			const double possibility{m_bins[bin] / size};
 			entropy += possibility * std::log2(possibility);
 		}
 
 		return -entropy;
 	}
 
-	double signal_to_noise_ratio(const Image &image)
+	double Histogram::signal_to_noise_ratio() const
+	{
+		return mean() / std_dev();
+	}
+
+	byte Histogram::percentile(double percent) const
+	{
+		const double target{std::clamp(percent, 0., 100.) / 100. * m_count};
+		std::size_t cumulative{0};
+		for (std::size_t bin = 0; bin < Bins; ++bin)
+		{
+			cumulative += m_bins[bin];
+			if (cumulative > 0 && cumulative >= target)
+				return bin;
+		}
+
+		return Bins - 1;
+	}
+
+	std::array<byte, Histogram::Bins> Histogram::equalization_lut() const
+	{
+		std::array<byte, Bins> lut{};
+		const auto firstUsed{std::ranges::find_if(m_bins, [](std::size_t frequency){ return frequency != 0; })};
+		if (firstUsed == m_bins.end())
+		{
+			std::iota(lut.begin(), lut.end(), 0);
+			return lut;
+		}
+
+		const std::size_t minimalCumulative{*firstUsed};
+		const double scale{m_count == minimalCumulative ? 0. : 255. / (m_count - minimalCumulative)};
+		std::size_t cumulative{0};
+		for (std::size_t bin = 0; bin < Bins; ++bin)
+		{
+			cumulative += m_bins[bin];
+			lut[bin] = cumulative <= minimalCumulative
+				? 0
+				: std::lround((cumulative - minimalCumulative) * scale);
+		}
+
+		return lut;
+	}
+
+	IntegralImage::IntegralImage(const Image &image)
+		: m_width{image.width()}
+		, m_height{image.height()}
+	{
+		if (image.format() != PixelFormat::Grayscale8)
+		{
+			fmt::println("Non grayscale formats are not supported");
+			m_width = m_height = 0;
+		}
+
+		const std::size_t stride{m_width + 1};
+		m_sums.resize(stride * (m_height + 1));
+		m_squaredSums.resize(stride * (m_height + 1));
+
+		vl::parallel::for_range(0, m_height, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				const byte *row{image.row(y)};
+				std::uint64_t *sums{&m_sums[(y + 1) * stride + 1]};
+				std::uint64_t *squaredSums{&m_squaredSums[(y + 1) * stride + 1]};
+				std::uint64_t sum{0};
+				std::uint64_t squaredSum{0};
+				for (std::size_t x = 0; x < m_width; ++x)
+				{
+					const std::uint64_t value{row[x]};
+					sum += value;
+					squaredSum += value * value;
+					sums[x] = sum;
+					squaredSums[x] = squaredSum;
+				}
+			}
+		}, IntegralRowsGrain);
+
+		vl::parallel::for_range(1, stride, [&](std::size_t firstColumn, std::size_t lastColumn)
+		{
+			for (std::size_t y = 1; y < m_height; ++y)
+			{
+				const std::uint64_t *__restrict previousSums{&m_sums[y * stride]};
+				const std::uint64_t *__restrict previousSquaredSums{&m_squaredSums[y * stride]};
+				std::uint64_t *__restrict sums{&m_sums[(y + 1) * stride]};
+				std::uint64_t *__restrict squaredSums{&m_squaredSums[(y + 1) * stride]};
+				for (std::size_t x = firstColumn; x < lastColumn; ++x)
+				{
+					sums[x] += previousSums[x];
+					squaredSums[x] += previousSquaredSums[x];
+				}
+			}
+		}, IntegralColumnsBlock);
+	}
+
+	Statistics &Statistics::operator+=(const Statistics &other)
+	{
+		if (other.count == 0)
+			return *this;
+		if (count == 0)
+			return *this = other;
+
+		const double totalCount = count + other.count;
+		const double delta{other.mean - mean};
+		const double squaredDeviations{stdDev * stdDev * count + other.stdDev * other.stdDev * other.count
+			+ delta * delta * count * other.count / totalCount};
+
+		mean += delta * other.count / totalCount;
+		count += other.count;
+		stdDev = std::sqrt(squaredDeviations / totalCount);
+		min = std::min(min, other.min);
+		max = std::max(max, other.max);
+		sum += other.sum;
+		sumOfSquares += other.sumOfSquares;
+
+		return *this;
+	}
+
+	Statistics statistics(const Image &image)
+	{
+		return statistics(image, 0, 0, image.width(), image.height());
+	}
+
+	Statistics statistics(const Image &image, std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+	{
+		if (image.format() != PixelFormat::Grayscale8 && image.format() != PixelFormat::Grayscale16)
+		{
+			fmt::println("Non grayscale formats are not supported");
+			return {};
+		}
+		if (x > image.width() || width > image.width() - x || y > image.height() || height > image.height() - y)
+		{
+			fmt::println("Invalid statistics region: {}x{}+{}+{} for image {}x{}",
+				width, height, x, y, image.width(), image.height());
+			return {};
+		}
+		if (width == 0 || height == 0)
+			return {};
+
+		std::vector<std::pair<std::size_t, Statistics>> bands;
+		std::mutex mergeMutex;
+		vl::parallel::for_range(y, y + height, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			Statistics band{};
+			for (std::size_t row = firstRow; row < lastRow; ++row)
+			{
+				if (image.format() == PixelFormat::Grayscale8)
+					band += row_statistics(image.row(row) + x, width);
+				else
+					band += row_statistics(reinterpret_cast<const std::uint16_t *>(image.row(row)) + x, width);
+			}
+
+			std::lock_guard lock{mergeMutex};
+			bands.emplace_back(firstRow, band);
+		}, StatisticsRowsGrain);
+
+		std::ranges::sort(bands, {}, &std::pair<std::size_t, Statistics>::first);
+		Statistics result{};
+		for (const auto &[firstRow, band] : bands)
+			result += band;
+
+		return result;
+	}
+
+	double entropy(const Image &image)
 	{
 		if (image.format() != PixelFormat::Grayscale8)
 		{
 			fmt::println("Non grayscale formats are not supported");
 			return 0;
 		}
-		std::array<std::size_t, 256> frequencies{};
-		for (const auto val : image)
-			++frequencies[val];
 
-		std::array<double, 256> possibilities{};
-		const double pixelsCount = image.width() * image.height(); 
-		for (std::size_t i = 0; i < possibilities.size(); ++i)
+		return Histogram{image}.entropy();
+	}
+
+	double signal_to_noise_ratio(const Image &image)
+	{
+		if (image.format() != PixelFormat::Grayscale8)
 		{
-			if (frequencies[i] == 0) continue;
+			fmt::println("Non grayscale formats are not supported");
+			return 0;
+		}
+
+		return Histogram{image}.signal_to_noise_ratio();
+	}
 
-			possibilities[i] = frequencies[i] / pixelsCount;
+	std::vector<std::uint32_t> squared_distance_transform(const Image &image, byte threshold, bool toBackground)
+	{
+		if (image.format() != PixelFormat::Grayscale8)
+		{
+			fmt::println("Non grayscale formats are not supported");
+			return {};
 		}
 
-		double mean{};
-		for (std::size_t i = 0; i < possibilities.size(); ++i)
-			mean += possibilities[i] * i;
+		const std::size_t width{image.width()};
+		const std::size_t height{image.height()};
+		std::vector<double> rowDistances(width * height);
+		vl::parallel::for_range(0, height, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			LowerEnvelope envelope{width};
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				const byte *row{image.row(y)};
+				for (std::size_t x = 0; x < width; ++x)
+					envelope.values[x] = (row[x] >= threshold) != toBackground ? 0 : DistanceInfinity;
+				envelope.compute(width);
+				std::ranges::copy(envelope.distances, &rowDistances[y * width]);
+			}
+		}, DistanceRowsGrain);
 
-		double stdDev{};
-		for (std::size_t i = 0; i < possibilities.size(); ++i)
-			stdDev += possibilities[i] * std::pow(i - mean, 2);
-		stdDev = std::sqrt(stdDev);
+		std::vector<std::uint32_t> distances(width * height);
+		vl::parallel::for_range(0, width, [&](std::size_t firstColumn, std::size_t lastColumn)
+		{
+			LowerEnvelope envelope{height};
+			for (std::size_t x = firstColumn; x < lastColumn; ++x)
+			{
+				for (std::size_t y = 0; y < height; ++y)
+					envelope.values[y] = rowDistances[y * width + x];
+				envelope.compute(height);
+				for (std::size_t y = 0; y < height; ++y)
+					distances[y * width + x] = std::min<double>(envelope.distances[y],
+						std::numeric_limits<std::uint32_t>::max());
+			}
+		}, DistanceColumnsGrain);
 
-		return mean / stdDev;
+		return distances;
 	}
 }
@@ -1,5 +1,21 @@
 #include "operations.h"
 
+#include "kernels.h"
+#include "parallel.h"
+
+namespace
+{
+	constexpr std::size_t BytesGrain{1 << 16};
+
+	void apply_row_kernel(vl::Image &image, const vl::Image &appliedImage,
+		void (*kernel)(vl::byte *, const vl::byte *, std::size_t))
+	{
+		vl::parallel::for_range(0, image.size(), [&](std::size_t first, std::size_t last)
+		{
+			kernel(image.begin() + first, appliedImage.begin() + first, last - first);
+		}, BytesGrain);
+	}
+}
 
 namespace vl
 {
@@ -8,9 +24,7 @@ namespace vl
 		impl::check_for_operation(lImage, rImage);
 
 		auto copy{lImage};
-		for (size_t row = 0; row < copy.height(); ++row)
-			for (size_t col = 0; col < copy.width(); ++col)
-				copy[col, row] += rImage[col, row];
+		apply_row_kernel(copy, rImage, kernels::table().add_row);
 
 		return copy;
 	}
@@ -20,9 +34,7 @@ namespace vl
 		impl::check_for_operation(lImage, rImage);
 
 		auto copy{lImage};
-		for (size_t row = 0; row < copy.height(); ++row)
-			for (size_t col = 0; col < copy.width(); ++col)
-				copy[col, row] -= rImage[col, row];
+		apply_row_kernel(copy, rImage, kernels::table().subtract_row);
 
 		return copy;
 	}
@@ -32,9 +44,7 @@ namespace vl
 		impl::check_for_operation(lImage, rImage);
 
 		auto copy{lImage};
-		for (size_t row = 0; row < copy.height(); ++row)
-			for (size_t col = 0; col < copy.width(); ++col)
-				copy[col, row] /= rImage[col, row];
+		apply_row_kernel(copy, rImage, kernels::table().divide_row);
 
 		return copy;
 	}
@@ -44,9 +54,7 @@ namespace vl
 		impl::check_for_operation(lImage, rImage);
 
 		auto copy{lImage};
-		for (size_t row = 0; row < copy.height(); ++row)
-			for (size_t col = 0; col < copy.width(); ++col)
-				copy[col, row] *= rImage[col, row];
+		apply_row_kernel(copy, rImage, kernels::table().multiply_row);
 
 		return copy;
 	}
@@ -56,9 +64,7 @@ namespace vl
 	{
 		impl::check_for_operation(image, appliedImage);
 
-		for (size_t row = 0; row < image.height(); ++row)
-			for (size_t col = 0; col < image.width(); ++col)
-				image[col, row] += appliedImage[col, row];
+		apply_row_kernel(image, appliedImage, kernels::table().add_row);
 
 		return image;
 	}
@@ -67,9 +73,7 @@ namespace vl
 	{
 		impl::check_for_operation(image, appliedImage);
 
-		for (size_t row = 0; row < image.height(); ++row)
-			for (size_t col = 0; col < image.width(); ++col)
-				image[col, row] -= appliedImage[col, row];
+		apply_row_kernel(image, appliedImage, kernels::table().subtract_row);
 
 		return image;
 	}
@@ -78,9 +82,7 @@ namespace vl
 	{
 		impl::check_for_operation(image, appliedImage);
 
-		for (size_t row = 0; row < image.height(); ++row)
-			for (size_t col = 0; col < image.width(); ++col)
-				image[col, row] /= appliedImage[col, row];
+		apply_row_kernel(image, appliedImage, kernels::table().divide_row);
 
 		return image;
 	}
@@ -89,9 +91,7 @@ namespace vl
 	{
 		impl::check_for_operation(image, appliedImage);
 
-		for (size_t row = 0; row < image.height(); ++row)
-			for (size_t col = 0; col < image.width(); ++col)
-				image[col, row] *= appliedImage[col, row];
+		apply_row_kernel(image, appliedImage, kernels::table().multiply_row);
 
 		return image;
 	}
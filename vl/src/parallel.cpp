@@ -0,0 +1,194 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	thread_local bool t_insideParallel{false};
+
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(std::size_t threads)
+		{
+			for (std::size_t i = 0; i < threads; ++i)
+				m_workers.emplace_back([this]{ work(); });
+		}
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard lock{m_mutex};
+				m_stop = true;
+			}
+			m_taskAvailable.notify_all();
+		}
+
+		void run(std::function<void()> &&task)
+		{
+			{
+				std::lock_guard lock{m_mutex};
+				m_tasks.push_back(std::move(task));
+			}
+			m_taskAvailable.notify_one();
+		}
+
+		std::size_t size() const
+		{
+			return m_workers.size();
+		}
+
+		std::size_t idle() const
+		{
+			return m_idle;
+		}
+
+	private:
+		void work()
+		{
+			t_insideParallel = true;
+			while (true)
+			{
+				std::unique_lock lock{m_mutex};
+				++m_idle;
+				m_taskAvailable.wait(lock, [&]{ return m_stop || !m_tasks.empty(); });
+				--m_idle;
+				if (m_tasks.empty())
+					return;
+
+				auto task{std::move(m_tasks.front())};
+				m_tasks.pop_front();
+				lock.unlock();
+
+				task();
+			}
+		}
+
+		std::mutex m_mutex;
+		std::condition_variable m_taskAvailable;
+		std::deque<std::function<void()>> m_tasks;
+		bool m_stop{false};
+		std::atomic<std::size_t> m_idle{0};
+
+		std::vector<std::jthread> m_workers;
+	};
+
+	struct PoolState
+	{
+		std::mutex mutex;
+		std::size_t threads{std::max(std::thread::hardware_concurrency(), 1u)};
+		std::shared_ptr<ThreadPool> pool;
+	};
+
+	PoolState &pool_state()
+	{
+		static PoolState state{};
+		return state;
+	}
+
+	std::shared_ptr<ThreadPool> get_pool()
+	{
+		auto &state{pool_state()};
+		std::lock_guard lock{state.mutex};
+		if (state.pool == nullptr)
+			state.pool = std::make_shared<ThreadPool>(state.threads - 1);
+
+		return state.pool;
+	}
+
+	struct RangeState
+	{
+		std::atomic<std::size_t> next{0};
+		std::size_t done{0};
+		std::exception_ptr error;
+
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+}
+
+namespace vl::parallel
+{
+	std::size_t thread_count()
+	{
+		auto &state{pool_state()};
+		std::lock_guard lock{state.mutex};
+		return state.threads;
+	}
+
+	void set_thread_count(std::size_t count)
+	{
+		auto &state{pool_state()};
+		std::lock_guard lock{state.mutex};
+		state.threads = std::max<std::size_t>(count, 1);
+		state.pool.reset();
+	}
+
+	void for_range(std::size_t begin, std::size_t end,
+		const std::function<void(std::size_t, std::size_t)> &body, std::size_t grain)
+	{
+		if (begin >= end)
+			return;
+
+		const std::size_t count{end - begin};
+		grain = std::max<std::size_t>(grain, 1);
+
+		const std::size_t threads{t_insideParallel ? 1 + get_pool()->idle() : thread_count()};
+		const std::size_t chunks{std::min((count + grain - 1) / grain, threads * 4)};
+		if (threads == 1 || chunks <= 1)
+		{
+			body(begin, end);
+			return;
+		}
+
+		const std::size_t chunkSize{(count + chunks - 1) / chunks};
+		auto state{std::make_shared<RangeState>()};
+		auto runChunks{[state, &body, begin, end, chunks, chunkSize]
+		{
+			const bool wasInside{std::exchange(t_insideParallel, true)};
+			for (std::size_t chunk = state->next++; chunk < chunks; chunk = state->next++)
+			{
+				const std::size_t chunkBegin{begin + chunk * chunkSize};
+				const std::size_t chunkEnd{std::min(chunkBegin + chunkSize, end)};
+				std::exception_ptr error;
+				try
+				{
+					if (chunkBegin < chunkEnd)
+						body(chunkBegin, chunkEnd);
+				}
+				catch (...)
+				{
+					error = std::current_exception();
+				}
+
+				std::lock_guard lock{state->mutex};
+				if (error && !state->error)
+					state->error = error;
+				if (++state->done == chunks)
+					state->finished.notify_all();
+			}
+			t_insideParallel = wasInside;
+		}};
+
+		const auto pool{get_pool()};
+		const std::size_t helpers{std::min(pool->size(), chunks - 1)};
+		for (std::size_t i = 0; i < helpers; ++i)
+			pool->run(runChunks);
+
+		runChunks();
+
+		std::unique_lock lock{state->mutex};
+		state->finished.wait(lock, [&]{ return state->done == chunks; });
+		if (state->error)
+			std::rethrow_exception(state->error);
+	}
+}
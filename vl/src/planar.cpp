@@ -0,0 +1,163 @@
+#include "planar.h"
+
+#include <memory>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "kernels.h"
+#include "parallel.h"
+#include "profiling.h"
+
+namespace
+{
+	constexpr std::size_t RowsGrain{16};
+
+	thread_local std::vector<std::unique_ptr<vl::PlanarImage>> pool;
+
+	class ScratchPlanes
+	{
+	public:
+		explicit ScratchPlanes(const vl::Image &image)
+		{
+			if (pool.empty())
+			{
+				m_planes = std::make_unique<vl::PlanarImage>(image);
+				return;
+			}
+
+			m_planes = std::move(pool.back());
+			pool.pop_back();
+			m_planes->load(image);
+		}
+
+		~ScratchPlanes()
+		{
+			pool.push_back(std::move(m_planes));
+		}
+
+		ScratchPlanes(const ScratchPlanes &) = delete;
+		ScratchPlanes &operator=(const ScratchPlanes &) = delete;
+
+		inline vl::PlanarImage &planes()
+		{
+			return *m_planes;
+		}
+
+	private:
+		std::unique_ptr<vl::PlanarImage> m_planes;
+	};
+}
+
+namespace vl
+{
+	PlanarImage::PlanarImage(std::size_t width, std::size_t height, PixelFormat format)
+		: m_format{format}
+		, m_width{width}
+		, m_height{height}
+	{
+		for (std::size_t channel = 0; channel < to_channels_count(format); ++channel)
+			m_planes.emplace_back(width, height, PixelFormat::Grayscale8);
+	}
+
+	PlanarImage::PlanarImage(const Image &image)
+	{
+		load(image);
+	}
+
+	PlanarImage PlanarImage::view(std::span<byte> bytes, std::size_t width, std::size_t height, PixelFormat format)
+	{
+		const std::size_t planeSize{width * height};
+		const std::size_t channels{to_channels_count(format)};
+		if (bytes.size() < planeSize * channels)
+			throw std::out_of_range{fmt::format("Viewed buffer of {} bytes is smaller than {} planes of {}x{}",
+				bytes.size(), channels, width, height)};
+
+		PlanarImage planar;
+		planar.m_format = format;
+		planar.m_width = width;
+		planar.m_height = height;
+		for (std::size_t channel = 0; channel < channels; ++channel)
+			planar.m_planes.push_back(Image::view(bytes.subspan(channel * planeSize, planeSize),
+				width, height, PixelFormat::Grayscale8));
+
+		return planar;
+	}
+
+	void PlanarImage::load(const Image &image)
+	{
+		VL_PROFILE_SCOPE("PlanarImage::load", image.width() * image.height());
+
+		if (image.format() == PixelFormat::Grayscale16)
+			throw std::logic_error{"Planar images support only 8 bit channels"};
+
+		const std::size_t channels{image.channels()};
+		m_format = image.format();
+		m_width = image.width();
+		m_height = image.height();
+		m_planes.resize(channels, Image{0, 0, PixelFormat::Grayscale8});
+		for (auto &plane : m_planes)
+			if (plane.width() != m_width || plane.height() != m_height)
+				plane = Image{m_width, m_height, PixelFormat::Grayscale8};
+
+		const auto &kernels{vl::kernels::table()};
+		vl::parallel::for_range(0, m_height, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			std::vector<byte *> rows(channels);
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				for (std::size_t channel = 0; channel < channels; ++channel)
+					rows[channel] = m_planes[channel].row(y);
+				kernels.deinterleave_row(image.row(y), rows.data(), channels, m_width);
+			}
+		}, RowsGrain);
+	}
+
+	void PlanarImage::store(Image &image) const
+	{
+		VL_PROFILE_SCOPE("PlanarImage::store", m_width * m_height);
+
+		if (image.width() != m_width || image.height() != m_height || image.format() != m_format)
+			image = Image{m_width, m_height, m_format};
+
+		const std::size_t channels{m_planes.size()};
+		const auto &kernels{vl::kernels::table()};
+		vl::parallel::for_range(0, m_height, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			std::vector<const byte *> rows(channels);
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				for (std::size_t channel = 0; channel < channels; ++channel)
+					rows[channel] = m_planes[channel].row(y);
+				kernels.interleave_row(rows.data(), image.row(y), channels, m_width);
+			}
+		}, RowsGrain);
+	}
+
+	Image PlanarImage::interleaved() const
+	{
+		Image image{m_width, m_height, m_format};
+		store(image);
+		return image;
+	}
+
+	namespace impl
+	{
+		void for_each_plane(Image &image, const std::function<void(Image &)> &body)
+		{
+			if (image.channels() == 1)
+			{
+				body(image);
+				return;
+			}
+
+			ScratchPlanes scratch{image};
+			auto &planes{scratch.planes()};
+			vl::parallel::for_each(0, image.color_channels(), [&](std::size_t channel)
+			{
+				body(planes.plane(channel));
+			});
+			planes.store(image);
+		}
+	}
+}
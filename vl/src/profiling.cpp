@@ -0,0 +1,101 @@
+#include "profiling.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+
+#include <fmt/format.h>
+
+namespace
+{
+	const auto Epoch{std::chrono::steady_clock::now()};
+
+	std::mutex eventsMutex;
+	std::vector<vl::profiling::Event> recordedEvents;
+
+	std::atomic<std::size_t> nextThreadId{1};
+
+	std::size_t current_thread_id()
+	{
+		thread_local const std::size_t id{nextThreadId.fetch_add(1, std::memory_order_relaxed)};
+		return id;
+	}
+}
+
+namespace vl::profiling
+{
+	void set_enabled(bool enable)
+	{
+		impl::enabled.store(enable, std::memory_order_relaxed);
+	}
+
+	std::vector<Event> events()
+	{
+		const std::lock_guard lock{eventsMutex};
+		return recordedEvents;
+	}
+
+	std::vector<StageSummary> summary()
+	{
+		std::map<std::string, StageSummary> stages;
+		for (const auto &event : events())
+		{
+			auto &stage{stages[event.name]};
+			stage.name = event.name;
+			++stage.calls;
+			stage.duration += event.duration;
+			stage.pixels += event.pixels;
+			stage.bytesAllocated += event.bytesAllocated;
+		}
+
+		std::vector<StageSummary> result;
+		result.reserve(stages.size());
+		for (auto &[name, stage] : stages)
+			result.push_back(std::move(stage));
+		std::ranges::sort(result, std::ranges::greater{}, &StageSummary::duration);
+
+		return result;
+	}
+
+	std::string chrome_trace()
+	{
+		std::string trace{"{\"displayTimeUnit\": \"ms\", \"traceEvents\": ["};
+		bool first{true};
+		for (const auto &event : events())
+		{
+			trace += fmt::format("{}\n\t{{\"name\": \"{}\", \"cat\": \"vl\", \"ph\": \"X\", \"pid\": 1, \"tid\": {}, "
+				"\"ts\": {:.3f}, \"dur\": {:.3f}, \"args\": {{\"pixels\": {}, \"bytes_allocated\": {}}}}}",
+				first ? "" : ",", event.name, event.thread, event.start / 1000., event.duration / 1000.,
+				event.pixels, event.bytesAllocated);
+			first = false;
+		}
+		trace += "\n]}\n";
+
+		return trace;
+	}
+
+	void clear()
+	{
+		const std::lock_guard lock{eventsMutex};
+		recordedEvents.clear();
+	}
+
+	void Scope::finish()
+	{
+		const std::uint64_t end{impl::now()};
+		const Event event{m_name, m_start, end - m_start, m_pixels,
+			impl::allocatedBytes - m_allocatedBytes, current_thread_id()};
+
+		const std::lock_guard lock{eventsMutex};
+		recordedEvents.push_back(event);
+	}
+
+	namespace impl
+	{
+		std::uint64_t now()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Epoch).count();
+		}
+	}
+}
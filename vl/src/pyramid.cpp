@@ -0,0 +1,210 @@
+#include "pyramid.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "parallel.h"
+
+namespace
+{
+	constexpr std::size_t RowsGrain{16};
+	constexpr std::size_t BinomialRadius{2};
+
+	inline std::size_t reduced_size(std::size_t size)
+	{
+		return std::max<std::size_t>((size + 1) / 2, 1);
+	}
+
+	void box_reduce_row(const vl::byte *__restrict upper, const vl::byte *__restrict lower,
+		vl::byte *__restrict output, std::size_t sourceWidth, std::size_t width, std::size_t channels)
+	{
+		const std::size_t pairs{sourceWidth / 2};
+		for (std::size_t x = 0; x < pairs; ++x)
+			for (std::size_t channel = 0; channel < channels; ++channel)
+			{
+				const std::size_t left{2 * x * channels + channel};
+				const std::size_t right{left + channels};
+				output[x * channels + channel] = (upper[left] + upper[right] + lower[left] + lower[right] + 2) >> 2;
+			}
+
+		for (std::size_t x = pairs; x < width; ++x)
+			for (std::size_t channel = 0; channel < channels; ++channel)
+			{
+				const std::size_t last{(sourceWidth - 1) * channels + channel};
+				output[x * channels + channel] = (upper[last] + lower[last] + 1) >> 1;
+			}
+	}
+
+	vl::Image box_reduce(const vl::Image &image)
+	{
+		const std::size_t width{reduced_size(image.width())};
+		const std::size_t height{reduced_size(image.height())};
+		const std::size_t channels{image.pixel_size()};
+
+		vl::Image reduced{width, height, image.format()};
+		vl::parallel::for_range(0, height, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+				box_reduce_row(image.row(2 * y), image.row(std::min(2 * y + 1, image.height() - 1)),
+					reduced.row(y), image.width(), width, channels);
+		}, RowsGrain);
+
+		return reduced;
+	}
+
+	vl::Image binomial_reduce(const vl::Image &image)
+	{
+		const std::size_t width{reduced_size(image.width())};
+		const std::size_t height{reduced_size(image.height())};
+		const std::size_t channels{image.pixel_size()};
+		const std::size_t sourceStride{image.width() * channels};
+		const std::size_t padding{BinomialRadius * channels};
+
+		vl::Image reduced{width, height, image.format()};
+		vl::parallel::for_range(0, height, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			std::vector<std::uint16_t> vertical(sourceStride + 2 * (padding + channels));
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				std::array<const vl::byte *, 5> rows;
+				for (std::size_t k = 0; k < rows.size(); ++k)
+					rows[k] = image.row(std::clamp<std::ptrdiff_t>((std::ptrdiff_t)(2 * y + k) - BinomialRadius,
+						0, image.height() - 1));
+
+				const vl::byte *__restrict row0{rows[0]};
+				const vl::byte *__restrict row1{rows[1]};
+				const vl::byte *__restrict row2{rows[2]};
+				const vl::byte *__restrict row3{rows[3]};
+				const vl::byte *__restrict row4{rows[4]};
+				std::uint16_t *__restrict sums{vertical.data() + padding};
+				for (std::size_t i = 0; i < sourceStride; ++i)
+					sums[i] = row0[i] + 4 * row1[i] + 6 * row2[i] + 4 * row3[i] + row4[i];
+
+				for (std::size_t i = 0; i < padding; ++i)
+					vertical[i] = sums[i % channels];
+				for (std::size_t i = 0; i < padding + channels; ++i)
+					sums[sourceStride + i] = sums[sourceStride - channels + i % channels];
+
+				const std::uint16_t *__restrict padded{vertical.data()};
+				vl::byte *__restrict output{reduced.row(y)};
+				for (std::size_t x = 0; x < width; ++x)
+					for (std::size_t channel = 0; channel < channels; ++channel)
+					{
+						const std::size_t center{2 * x * channels + channel + padding};
+						output[x * channels + channel] = (padded[center - 2 * channels] + 4 * padded[center - channels]
+							+ 6 * padded[center] + 4 * padded[center + channels] + padded[center + 2 * channels] + 128) >> 8;
+					}
+			}
+		}, RowsGrain);
+
+		return reduced;
+	}
+}
+
+namespace vl
+{
+	ImagePyramid::ImagePyramid(Image base, ReduceMethod method, std::size_t memoryLimit)
+		: m_method{method}
+		, m_memoryLimit{memoryLimit}
+	{
+		if (base.format() == PixelFormat::Grayscale16)
+			throw std::logic_error{"Image pyramids support only 8 bit channels"};
+
+		std::size_t width{base.width()};
+		std::size_t height{base.height()};
+		std::size_t count{1};
+		while (width > 1 || height > 1)
+		{
+			width = reduced_size(width);
+			height = reduced_size(height);
+			++count;
+		}
+
+		m_levels.resize(count);
+		m_lastUse.resize(count);
+		m_memoryUsage = base.size();
+		m_levels[0].emplace(std::move(base));
+	}
+
+	const Image &ImagePyramid::level(std::size_t index)
+	{
+		index = std::min(index, m_levels.size() - 1);
+		m_lastUse[index] = ++m_clock;
+		if (m_levels[index])
+			return *m_levels[index];
+
+		Image reduced{impl::reduce(level(index - 1), m_method)};
+		m_memoryUsage += reduced.size();
+		m_lastUse[index] = ++m_clock;
+		m_levels[index].emplace(std::move(reduced));
+		evict(index);
+
+		return *m_levels[index];
+	}
+
+	vl::Image ImagePyramid::apply(std::size_t index, const std::function<void(Image &)> &filter,
+		transform::Interpolation interpolation)
+	{
+		Image filtered{level(index)};
+		filter(filtered);
+
+		const Image &base{*m_levels[0]};
+		if (filtered.width() == base.width() && filtered.height() == base.height())
+			return filtered;
+
+		return transform::resize(filtered, base.width(), base.height(), interpolation);
+	}
+
+	void ImagePyramid::release(std::size_t index)
+	{
+		if (index == 0 || index >= m_levels.size() || !m_levels[index])
+			return;
+
+		m_memoryUsage -= m_levels[index]->size();
+		m_levels[index].reset();
+	}
+
+	void ImagePyramid::set_memory_limit(std::size_t limit)
+	{
+		m_memoryLimit = limit;
+		evict(0);
+	}
+
+	void ImagePyramid::evict(std::size_t keep)
+	{
+		if (m_memoryLimit == 0)
+			return;
+
+		while (m_memoryUsage > m_memoryLimit)
+		{
+			std::optional<std::size_t> oldest;
+			for (std::size_t i = 1; i < m_levels.size(); ++i)
+				if (m_levels[i] && i != keep && (!oldest || m_lastUse[i] < m_lastUse[*oldest]))
+					oldest = i;
+
+			if (!oldest)
+				return;
+			release(*oldest);
+		}
+	}
+
+	namespace impl
+	{
+		vl::Image reduce(const Image &image, ReduceMethod method)
+		{
+			if (image.format() == PixelFormat::Grayscale16)
+			{
+				fmt::println("Unsupported image format");
+				return vl::Image{reduced_size(image.width()), reduced_size(image.height()), image.format()};
+			}
+			if (image.width() == 0 || image.height() == 0)
+				return image;
+
+			return method == ReduceMethod::Box ? box_reduce(image) : binomial_reduce(image);
+		}
+	}
+}
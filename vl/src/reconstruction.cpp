@@ -0,0 +1,357 @@
+#include "filters.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <queue>
+
+#include <fmt/format.h>
+
+#include "planar.h"
+#include "profiling.h"
+
+namespace
+{
+	using vl::filters::Connectivity;
+
+	struct ByDilation
+	{
+		static vl::byte extend(vl::byte first, vl::byte second)
+		{
+			return std::max(first, second);
+		}
+
+		static vl::byte limit(vl::byte value, vl::byte mask)
+		{
+			return std::min(value, mask);
+		}
+
+		static bool below(vl::byte first, vl::byte second)
+		{
+			return first < second;
+		}
+	};
+
+	struct ByErosion
+	{
+		static vl::byte extend(vl::byte first, vl::byte second)
+		{
+			return std::min(first, second);
+		}
+
+		static vl::byte limit(vl::byte value, vl::byte mask)
+		{
+			return std::max(value, mask);
+		}
+
+		static bool below(vl::byte first, vl::byte second)
+		{
+			return first > second;
+		}
+	};
+
+	template<typename Visit>
+	inline void for_each_neighbour(std::size_t index, std::size_t width, std::size_t height,
+		Connectivity connectivity, Visit &&visit)
+	{
+		const std::size_t x{index % width};
+		const std::size_t y{index / width};
+		const bool left{x > 0};
+		const bool right{x + 1 < width};
+		const bool up{y > 0};
+		const bool down{y + 1 < height};
+
+		if (left)
+			visit(index - 1);
+		if (right)
+			visit(index + 1);
+		if (up)
+			visit(index - width);
+		if (down)
+			visit(index + width);
+		if (connectivity == Connectivity::Four)
+			return;
+
+		if (up && left)
+			visit(index - width - 1);
+		if (up && right)
+			visit(index - width + 1);
+		if (down && left)
+			visit(index + width - 1);
+		if (down && right)
+			visit(index + width + 1);
+	}
+
+	template<typename Order>
+	void reconstruct(vl::byte *marker, const vl::byte *mask, std::size_t width, std::size_t height,
+		Connectivity connectivity)
+	{
+		const bool eight{connectivity == Connectivity::Eight};
+		const std::size_t size{width * height};
+		for (std::size_t i = 0; i < size; ++i)
+			marker[i] = Order::limit(marker[i], mask[i]);
+
+		for (std::size_t y = 0; y < height; ++y)
+		{
+			const std::size_t row{y * width};
+			for (std::size_t x = 0; x < width; ++x)
+			{
+				const std::size_t index{row + x};
+				vl::byte value{marker[index]};
+				if (x > 0)
+					value = Order::extend(value, marker[index - 1]);
+				if (y > 0)
+				{
+					value = Order::extend(value, marker[index - width]);
+					if (eight && x > 0)
+						value = Order::extend(value, marker[index - width - 1]);
+					if (eight && x + 1 < width)
+						value = Order::extend(value, marker[index - width + 1]);
+				}
+				marker[index] = Order::limit(value, mask[index]);
+			}
+		}
+
+		std::queue<std::uint32_t, std::deque<std::uint32_t>> fifo;
+		for (std::size_t y = height; y-- > 0;)
+		{
+			const std::size_t row{y * width};
+			for (std::size_t x = width; x-- > 0;)
+			{
+				const std::size_t index{row + x};
+				vl::byte value{marker[index]};
+				if (x + 1 < width)
+					value = Order::extend(value, marker[index + 1]);
+				if (y + 1 < height)
+				{
+					value = Order::extend(value, marker[index + width]);
+					if (eight && x + 1 < width)
+						value = Order::extend(value, marker[index + width + 1]);
+					if (eight && x > 0)
+						value = Order::extend(value, marker[index + width - 1]);
+				}
+				value = Order::limit(value, mask[index]);
+				marker[index] = value;
+
+				const auto propagates{[&](std::size_t neighbour)
+				{
+					return Order::below(marker[neighbour], value) && Order::below(marker[neighbour], mask[neighbour]);
+				}};
+				if ((x + 1 < width && propagates(index + 1))
+					|| (y + 1 < height && (propagates(index + width)
+						|| (eight && x + 1 < width && propagates(index + width + 1))
+						|| (eight && x > 0 && propagates(index + width - 1)))))
+					fifo.push(index);
+			}
+		}
+
+		while (!fifo.empty())
+		{
+			const std::size_t index{fifo.front()};
+			fifo.pop();
+			const vl::byte value{marker[index]};
+			for_each_neighbour(index, width, height, connectivity, [&](std::size_t neighbour)
+			{
+				if (Order::below(marker[neighbour], value) && marker[neighbour] != mask[neighbour])
+				{
+					marker[neighbour] = Order::limit(value, mask[neighbour]);
+					fifo.push(neighbour);
+				}
+			});
+		}
+	}
+
+	bool check_reconstruction_input(const vl::Image &marker, const vl::Image &mask)
+	{
+		if (marker.width() != mask.width() || marker.height() != mask.height())
+		{
+			fmt::println("Invalid reconstruction images: marker {}x{} and mask {}x{} differ in size",
+				marker.width(), marker.height(), mask.width(), mask.height());
+			return false;
+		}
+		if (marker.format() != vl::PixelFormat::Grayscale8 || mask.format() != vl::PixelFormat::Grayscale8)
+		{
+			fmt::println("Unsupported image format");
+			return false;
+		}
+		if (marker.size() > std::numeric_limits<std::uint32_t>::max())
+		{
+			fmt::println("Invalid image size: {}x{} for reconstruction", marker.width(), marker.height());
+			return false;
+		}
+		return true;
+	}
+
+	bool check_element_input(const vl::Image &image, std::size_t size, const char *name)
+	{
+		if (size % 2 == 0)
+		{
+			fmt::println("Invalid size of {}: {}, filter should have odd size", name, size);
+			return false;
+		}
+		if (image.width() <= size || image.height() <= size)
+		{
+			fmt::println("Invalid image size: {}x{} to kernel size: {}x{}",
+				image.width(), image.height(), size, size);
+			return false;
+		}
+		if (image.format() == vl::PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return false;
+		}
+		return true;
+	}
+
+	bool check_single_input(const vl::Image &image)
+	{
+		if (image.format() == vl::PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return false;
+		}
+		if (image.size() > std::numeric_limits<std::uint32_t>::max())
+		{
+			fmt::println("Invalid image size: {}x{} for reconstruction", image.width(), image.height());
+			return false;
+		}
+		return true;
+	}
+}
+
+namespace vl::filters
+{
+	std::optional<Connectivity> to_connectivity(const std::string &connectivityString)
+	{
+		if (connectivityString == "4")
+			return Connectivity::Four;
+		else if (connectivityString == "8")
+			return Connectivity::Eight;
+
+		return {};
+	}
+
+	void reconstruction_by_dilation(Image &marker, const Image &mask, Connectivity connectivity)
+	{
+		VL_PROFILE_SCOPE("filters::reconstruction_by_dilation", marker.width() * marker.height());
+
+		if (!check_reconstruction_input(marker, mask))
+			return;
+
+		reconstruct<ByDilation>(marker.begin(), mask.begin(), marker.width(), marker.height(), connectivity);
+	}
+
+	void reconstruction_by_erosion(Image &marker, const Image &mask, Connectivity connectivity)
+	{
+		VL_PROFILE_SCOPE("filters::reconstruction_by_erosion", marker.width() * marker.height());
+
+		if (!check_reconstruction_input(marker, mask))
+			return;
+
+		reconstruct<ByErosion>(marker.begin(), mask.begin(), marker.width(), marker.height(), connectivity);
+	}
+
+	void opening_by_reconstruction(Image &image, Shape shape, std::size_t size, Connectivity connectivity)
+	{
+		VL_PROFILE_SCOPE("filters::opening_by_reconstruction", image.width() * image.height());
+
+		if (!check_element_input(image, size, "opening by reconstruction") || !check_single_input(image))
+			return;
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			Image marker{plane};
+			erosion(marker, shape, size);
+			reconstruct<ByDilation>(marker.begin(), plane.begin(), plane.width(), plane.height(), connectivity);
+			plane = std::move(marker);
+		});
+	}
+
+	void closing_by_reconstruction(Image &image, Shape shape, std::size_t size, Connectivity connectivity)
+	{
+		VL_PROFILE_SCOPE("filters::closing_by_reconstruction", image.width() * image.height());
+
+		if (!check_element_input(image, size, "closing by reconstruction") || !check_single_input(image))
+			return;
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			Image marker{plane};
+			dilation(marker, shape, size);
+			reconstruct<ByErosion>(marker.begin(), plane.begin(), plane.width(), plane.height(), connectivity);
+			plane = std::move(marker);
+		});
+	}
+
+	void fill_holes(Image &image, Connectivity connectivity)
+	{
+		VL_PROFILE_SCOPE("filters::fill_holes", image.width() * image.height());
+
+		if (!check_single_input(image) || image.width() == 0 || image.height() == 0)
+			return;
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			const std::size_t width{plane.width()};
+			const std::size_t height{plane.height()};
+			Image marker{width, height, PixelFormat::Grayscale8};
+			std::ranges::fill(marker, 255);
+			for (std::size_t x = 0; x < width; ++x)
+			{
+				marker[x, 0] = plane[x, 0];
+				marker[x, height - 1] = plane[x, height - 1];
+			}
+			for (std::size_t y = 0; y < height; ++y)
+			{
+				marker[0, y] = plane[0, y];
+				marker[width - 1, y] = plane[width - 1, y];
+			}
+
+			reconstruct<ByErosion>(marker.begin(), plane.begin(), width, height, connectivity);
+			plane = std::move(marker);
+		});
+	}
+
+	void regional_maxima(Image &image, Connectivity connectivity)
+	{
+		VL_PROFILE_SCOPE("filters::regional_maxima", image.width() * image.height());
+
+		if (!check_single_input(image))
+			return;
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			Image marker{plane};
+			for (auto &value : marker)
+				value = value > 0 ? value - 1 : 0;
+
+			reconstruct<ByDilation>(marker.begin(), plane.begin(), plane.width(), plane.height(), connectivity);
+			std::ranges::transform(plane, marker, plane.begin(), [](byte value, byte reconstructed) -> byte
+			{
+				return value > reconstructed ? 255 : 0;
+			});
+		});
+	}
+
+	void regional_minima(Image &image, Connectivity connectivity)
+	{
+		VL_PROFILE_SCOPE("filters::regional_minima", image.width() * image.height());
+
+		if (!check_single_input(image))
+			return;
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			Image marker{plane};
+			for (auto &value : marker)
+				value = value < 255 ? value + 1 : 255;
+
+			reconstruct<ByErosion>(marker.begin(), plane.begin(), plane.width(), plane.height(), connectivity);
+			std::ranges::transform(plane, marker, plane.begin(), [](byte value, byte reconstructed) -> byte
+			{
+				return value < reconstructed ? 255 : 0;
+			});
+		});
+	}
+}
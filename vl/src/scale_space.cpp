@@ -0,0 +1,275 @@
+#include "scale_space.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "filters.h"
+#include "parallel.h"
+#include "planar.h"
+#include "profiling.h"
+
+namespace
+{
+	constexpr std::size_t RowsGrain{16};
+	constexpr double KernelRadiusInSigmas{3};
+	constexpr double LaplacianSigmaRatio{1.6};
+	constexpr double MinIncrementalSigma{1};
+
+	std::vector<float> gaussian_kernel(double sigma)
+	{
+		const std::size_t radius = std::max(std::ceil(sigma * KernelRadiusInSigmas), 1.);
+		std::vector<float> kernel(radius * 2 + 1);
+
+		const double inverseDoublePow{1 / (2 * sigma * sigma)};
+		double kernelSum{0};
+		for (std::size_t i = 0; i < kernel.size(); ++i)
+		{
+			const double displacement = (double)i - radius;
+			kernel[i] = std::exp(-displacement * displacement * inverseDoublePow);
+			kernelSum += kernel[i];
+		}
+		for (auto &weight : kernel)
+			weight /= kernelSum;
+
+		return kernel;
+	}
+
+	std::vector<float> blur_values(const std::vector<float> &values, std::size_t width, std::size_t height, double sigma)
+	{
+		if (sigma <= 0)
+			return values;
+
+		const auto kernel{gaussian_kernel(sigma)};
+		const std::size_t radius{kernel.size() / 2};
+
+		std::vector<float> blurred(width * height);
+		vl::parallel::for_range(0, height, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			std::vector<float> vertical(width + radius * 2);
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				float *__restrict sums{vertical.data() + radius};
+				std::fill_n(sums, width, 0.f);
+				for (std::size_t k = 0; k < kernel.size(); ++k)
+				{
+					const std::size_t sourceY = std::clamp<std::ptrdiff_t>((std::ptrdiff_t)(y + k) - radius,
+						0, height - 1);
+					const float *__restrict source{&values[sourceY * width]};
+					const float weight{kernel[k]};
+					for (std::size_t x = 0; x < width; ++x)
+						sums[x] += weight * source[x];
+				}
+				std::fill_n(vertical.data(), radius, sums[0]);
+				std::fill_n(sums + width, radius, sums[width - 1]);
+
+				const float *__restrict padded{vertical.data()};
+				float *__restrict output{&blurred[y * width]};
+				for (std::size_t x = 0; x < width; ++x)
+				{
+					float sum{0};
+					for (std::size_t k = 0; k < kernel.size(); ++k)
+						sum += kernel[k] * padded[x + k];
+					output[x] = sum;
+				}
+			}
+		}, RowsGrain);
+
+		return blurred;
+	}
+
+	vl::Image quantize(const std::vector<float> &values, std::size_t width, std::size_t height)
+	{
+		vl::Image image{width, height, vl::PixelFormat::Grayscale8};
+		vl::parallel::for_range(0, height, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				const float *__restrict source{&values[y * width]};
+				vl::byte *__restrict output{image.row(y)};
+				for (std::size_t x = 0; x < width; ++x)
+					output[x] = std::min(source[x] + 0.5f, 255.f);
+			}
+		}, RowsGrain);
+
+		return image;
+	}
+
+	template<typename Combine>
+	vl::Image combine_levels(const std::vector<float> &first, const std::vector<float> &second,
+		std::size_t width, std::size_t height, Combine &&combine)
+	{
+		vl::Image result{width, height, vl::PixelFormat::Grayscale8};
+		vl::parallel::for_range(0, height, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				const float *__restrict firstValues{&first[y * width]};
+				const float *__restrict secondValues{&second[y * width]};
+				vl::byte *__restrict output{result.row(y)};
+				for (std::size_t x = 0; x < width; ++x)
+					output[x] = std::clamp(combine(firstValues[x], secondValues[x]) + 0.5f, 0.f, 255.f);
+			}
+		}, RowsGrain);
+
+		return result;
+	}
+}
+
+namespace vl
+{
+	ScaleSpace::ScaleSpace(const Image &image, double baseSigma)
+		: m_width{image.width()}
+		, m_height{image.height()}
+	{
+		Level base{{}, image};
+		if (image.format() != PixelFormat::Grayscale8)
+			fmt::println("Unsupported image format");
+		else
+			base.values.assign(image.begin(), image.end());
+
+		m_levels.emplace(std::max(baseSigma, 0.), std::move(base));
+	}
+
+	const Image &ScaleSpace::level(double sigma)
+	{
+		Level &found{blurred_level(sigma)};
+		if (!found.image)
+			found.image.emplace(quantize(found.values, m_width, m_height));
+
+		return *found.image;
+	}
+
+	ScaleSpace::Level &ScaleSpace::blurred_level(double sigma)
+	{
+		auto closest{m_levels.upper_bound(sigma)};
+		if (closest != m_levels.begin())
+			--closest;
+
+		if (closest->first >= sigma || std::abs(closest->first - sigma) < 1e-9)
+			return closest->second;
+		if (closest->second.values.size() != m_width * m_height || m_width * m_height == 0)
+			return closest->second;
+
+		const auto insertPosition{std::next(closest)};
+		while (closest != m_levels.begin() && sigma * sigma - closest->first * closest->first
+			< MinIncrementalSigma * MinIncrementalSigma)
+			--closest;
+
+		const double incrementalSigma{std::sqrt(sigma * sigma - closest->first * closest->first)};
+		return m_levels.emplace_hint(insertPosition, sigma,
+			Level{blur_values(closest->second.values, m_width, m_height, incrementalSigma), {}})->second;
+	}
+
+	vl::Image ScaleSpace::difference_of_gaussians(double smallSigma, double largeSigma)
+	{
+		const Level &small{blurred_level(smallSigma)};
+		const Level &large{blurred_level(largeSigma)};
+		if (small.image && small.values.empty())
+			return *small.image;
+
+		return combine_levels(small.values, large.values, m_width, m_height, [](float smallValue, float largeValue)
+		{
+			return smallValue - largeValue + 128.f;
+		});
+	}
+
+	vl::Image ScaleSpace::unsharp_mask(double sigma, double amount)
+	{
+		const Level &original{blurred_level(0)};
+		const Level &blurred{blurred_level(sigma)};
+		if (original.image && original.values.empty())
+			return *original.image;
+
+		const float gain = amount;
+		return combine_levels(original.values, blurred.values, m_width, m_height, [gain](float originalValue, float blurredValue)
+		{
+			return originalValue + (originalValue - blurredValue) * gain;
+		});
+	}
+
+	vl::Image ScaleSpace::laplacian(double sigma)
+	{
+		const Level &small{blurred_level(sigma)};
+		const Level &large{blurred_level(sigma * LaplacianSigmaRatio)};
+		if (small.image && small.values.empty())
+			return *small.image;
+
+		constexpr float normalization{1 / (LaplacianSigmaRatio - 1)};
+		return combine_levels(small.values, large.values, m_width, m_height, [](float smallValue, float largeValue)
+		{
+			return (largeValue - smallValue) * normalization + 128.f;
+		});
+	}
+
+	namespace impl
+	{
+		vl::Image gaussian_blur(const Image &image, double sigma)
+		{
+			if (sigma <= 0 || image.format() != PixelFormat::Grayscale8)
+				return image;
+
+			const std::vector<float> values(image.begin(), image.end());
+			return quantize(blur_values(values, image.width(), image.height(), sigma), image.width(), image.height());
+		}
+	}
+}
+
+namespace vl::filters
+{
+	void unsharp_mask(Image &image, double standardDeviation, double amount)
+	{
+		VL_PROFILE_SCOPE("filters::unsharp_mask", image.width() * image.height());
+
+		if (image.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return;
+		}
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			plane = ScaleSpace{plane}.unsharp_mask(standardDeviation, amount);
+		});
+	}
+
+	void difference_of_gaussians(Image &image, double smallStandardDeviation, double largeStandardDeviation)
+	{
+		VL_PROFILE_SCOPE("filters::difference_of_gaussians", image.width() * image.height());
+
+		if (smallStandardDeviation >= largeStandardDeviation)
+		{
+			fmt::println("Invalid standard deviations: small {} is not less than large {}",
+				smallStandardDeviation, largeStandardDeviation);
+			return;
+		}
+		if (image.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return;
+		}
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			plane = ScaleSpace{plane}.difference_of_gaussians(smallStandardDeviation, largeStandardDeviation);
+		});
+	}
+
+	void laplacian(Image &image, double standardDeviation)
+	{
+		VL_PROFILE_SCOPE("filters::laplacian", image.width() * image.height());
+
+		if (image.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return;
+		}
+
+		vl::impl::for_each_plane(image, [&](Image &plane)
+		{
+			plane = ScaleSpace{plane}.laplacian(standardDeviation);
+		});
+	}
+}
@@ -0,0 +1,43 @@
+#include "scratch.h"
+
+#include <vector>
+
+namespace
+{
+	thread_local std::vector<std::unique_ptr<vl::Image>> pool;
+}
+
+namespace vl
+{
+	ScratchImage::ScratchImage(const Image &source)
+	{
+		if (pool.empty())
+		{
+			m_image = std::make_unique<Image>(source);
+			return;
+		}
+
+		m_image = std::move(pool.back());
+		pool.pop_back();
+		*m_image = source;
+	}
+
+	ScratchImage::~ScratchImage()
+	{
+		pool.push_back(std::move(m_image));
+	}
+
+	std::size_t ScratchImage::pooled_bytes()
+	{
+		std::size_t bytes{0};
+		for (const auto &image : pool)
+			bytes += image->size();
+
+		return bytes;
+	}
+
+	void ScratchImage::release_pool()
+	{
+		pool.clear();
+	}
+}
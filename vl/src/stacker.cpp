@@ -0,0 +1,287 @@
+#include "stacker.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include <fmt/format.h>
+
+#include "parallel.h"
+#include "profiling.h"
+
+namespace
+{
+	constexpr std::size_t RowsGrain{8};
+	constexpr std::size_t MedianTileRows{8};
+	constexpr std::size_t MedianTileValues{64};
+}
+
+namespace vl
+{
+	std::optional<StackMode> to_stack_mode(const std::string &modeString)
+	{
+		std::string modeLowCase{modeString};
+		std::transform(begin(modeLowCase), end(modeLowCase), begin(modeLowCase), tolower);
+
+		if (modeLowCase == "mean")
+			return StackMode::Mean;
+		else if (modeLowCase == "median")
+			return StackMode::Median;
+		else if (modeLowCase == "min")
+			return StackMode::Min;
+		else if (modeLowCase == "max")
+			return StackMode::Max;
+
+		return {};
+	}
+
+	Stacker::Stacker(StackMode mode, std::size_t medianBins)
+		: m_mode{mode}
+		, m_medianBins{std::clamp<std::size_t>(std::bit_floor(std::max<std::size_t>(medianBins, 1)), 2, 256)}
+	{
+		if (m_medianBins != medianBins)
+			fmt::println("Median bins count {} rounded to {}", medianBins, m_medianBins);
+		m_binShift = 8 - std::countr_zero(m_medianBins);
+	}
+
+	void Stacker::add(const Image &frame)
+	{
+		VL_PROFILE_SCOPE("Stacker::add", frame.width() * frame.height());
+
+		if (frame.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return;
+		}
+		if (m_framesCount == 0)
+		{
+			m_width = frame.width();
+			m_height = frame.height();
+			m_format = frame.format();
+
+			const std::size_t values{frame.size()};
+			switch (m_mode)
+			{
+				case StackMode::Mean:
+					m_sums.assign(values, 0);
+					break;
+				case StackMode::Median:
+				{
+					const std::size_t stride{m_width * frame.pixel_size()};
+					m_tiles.clear();
+					m_medianHistograms = false;
+					for (std::size_t y = 0; y < m_height; y += MedianTileRows)
+						for (std::size_t x = 0; x < stride; x += MedianTileValues)
+							m_tiles.push_back({x, y, std::min(MedianTileValues, stride - x), std::min(MedianTileRows, m_height - y), {}, {}});
+					break;
+				}
+				case StackMode::Min:
+				case StackMode::Max:
+					m_extremes.assign(frame.begin(), frame.end());
+					break;
+			}
+		}
+		else if (frame.width() != m_width || frame.height() != m_height || frame.format() != m_format)
+		{
+			fmt::println("Frame {}x{} doesn't match stack {}x{}", frame.width(), frame.height(), m_width, m_height);
+			return;
+		}
+		else if (m_mode == StackMode::Median && m_framesCount == MaxMedianFrames)
+		{
+			fmt::println("Median stack is limited to {} frames", MaxMedianFrames);
+			return;
+		}
+
+		if (m_mode == StackMode::Median)
+		{
+			add_median(frame);
+			++m_framesCount;
+			return;
+		}
+
+		const std::size_t stride{m_width * frame.pixel_size()};
+		const bool firstFrame{m_framesCount == 0};
+		vl::parallel::for_range(0, m_height, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				const byte *__restrict values{frame.row(y)};
+				switch (m_mode)
+				{
+					case StackMode::Mean:
+					{
+						std::uint32_t *__restrict sums{&m_sums[y * stride]};
+						for (std::size_t x = 0; x < stride; ++x)
+							sums[x] += values[x];
+						break;
+					}
+					case StackMode::Median:
+						break;
+					case StackMode::Min:
+					{
+						if (firstFrame)
+							break;
+						byte *__restrict extremes{&m_extremes[y * stride]};
+						for (std::size_t x = 0; x < stride; ++x)
+							extremes[x] = std::min(extremes[x], values[x]);
+						break;
+					}
+					case StackMode::Max:
+					{
+						if (firstFrame)
+							break;
+						byte *__restrict extremes{&m_extremes[y * stride]};
+						for (std::size_t x = 0; x < stride; ++x)
+							extremes[x] = std::max(extremes[x], values[x]);
+						break;
+					}
+				}
+			}
+		}, RowsGrain);
+
+		++m_framesCount;
+	}
+
+	vl::Image Stacker::result() const
+	{
+		VL_PROFILE_SCOPE("Stacker::result", m_width * m_height);
+
+		vl::Image combined{m_width, m_height, m_format};
+		if (m_framesCount == 0)
+			return combined;
+
+		if (m_mode == StackMode::Median)
+		{
+			median_result(combined);
+			return combined;
+		}
+
+		const std::size_t stride{m_width * combined.pixel_size()};
+		const std::uint32_t framesCount = m_framesCount;
+		vl::parallel::for_range(0, m_height, [&](std::size_t firstRow, std::size_t lastRow)
+		{
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				byte *__restrict output{combined.row(y)};
+				switch (m_mode)
+				{
+					case StackMode::Mean:
+					{
+						const std::uint32_t *__restrict sums{&m_sums[y * stride]};
+						for (std::size_t x = 0; x < stride; ++x)
+							output[x] = (sums[x] + framesCount / 2) / framesCount;
+						break;
+					}
+					case StackMode::Median:
+						break;
+					case StackMode::Min:
+					case StackMode::Max:
+						std::copy_n(&m_extremes[y * stride], stride, output);
+						break;
+				}
+			}
+		}, RowsGrain);
+
+		return combined;
+	}
+
+	void Stacker::add_median(const Image &frame)
+	{
+		const std::size_t framesLimit{2 * m_medianBins};
+		const bool toHistograms{!m_medianHistograms && m_framesCount + 1 == framesLimit};
+		vl::parallel::for_each(0, m_tiles.size(), [&](std::size_t index)
+		{
+			MedianTile &tile{m_tiles[index]};
+			const std::size_t tileSize{tile.width * tile.height};
+			if (m_medianHistograms)
+			{
+				std::uint16_t *histograms{tile.histograms.data()};
+				for (std::size_t y = 0; y < tile.height; ++y)
+				{
+					const byte *values{frame.row(tile.y + y) + tile.x};
+					for (std::size_t x = 0; x < tile.width; ++x, histograms += m_medianBins)
+						++histograms[values[x] >> m_binShift];
+				}
+				return;
+			}
+
+			const std::size_t offset{tile.values.size()};
+			if (tile.values.capacity() < offset + tileSize)
+				tile.values.reserve(std::min(std::max(offset + tileSize, offset + offset / 4), framesLimit * tileSize));
+			tile.values.resize(offset + tileSize);
+			for (std::size_t y = 0; y < tile.height; ++y)
+				std::copy_n(frame.row(tile.y + y) + tile.x, tile.width, &tile.values[offset + y * tile.width]);
+
+			if (!toHistograms)
+				return;
+
+			tile.histograms.assign(tileSize * m_medianBins, 0);
+			for (std::size_t frameOffset = 0; frameOffset < tile.values.size(); frameOffset += tileSize)
+			{
+				const byte *__restrict values{&tile.values[frameOffset]};
+				for (std::size_t i = 0; i < tileSize; ++i)
+					++tile.histograms[i * m_medianBins + (values[i] >> m_binShift)];
+			}
+			std::vector<byte>{}.swap(tile.values);
+		});
+
+		if (toHistograms)
+			m_medianHistograms = true;
+	}
+
+	void Stacker::median_result(Image &combined) const
+	{
+		const std::size_t binWidth{m_medianHistograms ? (std::size_t)1 << m_binShift : 1};
+		const std::size_t bins{m_medianHistograms ? m_medianBins : 256};
+		const double medianRank = (m_framesCount + 1) / 2;
+		vl::parallel::for_range(0, m_tiles.size(), [&](std::size_t firstTile, std::size_t lastTile)
+		{
+			std::vector<std::uint16_t> counts;
+			for (std::size_t index = firstTile; index < lastTile; ++index)
+			{
+				const MedianTile &tile{m_tiles[index]};
+				const std::size_t tileSize{tile.width * tile.height};
+				const std::uint16_t *histograms{tile.histograms.data()};
+				if (!m_medianHistograms)
+				{
+					counts.assign(tileSize * bins, 0);
+					for (std::size_t frameOffset = 0; frameOffset < tile.values.size(); frameOffset += tileSize)
+					{
+						const byte *__restrict values{&tile.values[frameOffset]};
+						for (std::size_t i = 0; i < tileSize; ++i)
+							++counts[i * bins + values[i]];
+					}
+					histograms = counts.data();
+				}
+
+				for (std::size_t y = 0; y < tile.height; ++y)
+				{
+					byte *output{combined.row(tile.y + y) + tile.x};
+					for (std::size_t x = 0; x < tile.width; ++x, histograms += bins)
+					{
+						std::size_t cumulative{0};
+						std::size_t bin{0};
+						while (cumulative + histograms[bin] < medianRank)
+							cumulative += histograms[bin++];
+
+						if (binWidth == 1)
+							output[x] = bin;
+						else
+						{
+							const double position{(medianRank - cumulative - 0.5) / histograms[bin]};
+							output[x] = std::min<double>(std::lround(bin * binWidth + position * binWidth - 0.5), 255);
+						}
+					}
+				}
+			}
+		});
+	}
+
+	std::size_t Stacker::memory_usage() const
+	{
+		std::size_t usage{m_sums.size() * sizeof(std::uint32_t) + m_extremes.size()};
+		for (const MedianTile &tile : m_tiles)
+			usage += tile.values.capacity() + tile.histograms.capacity() * sizeof(std::uint16_t);
+		return usage;
+	}
+}
@@ -0,0 +1,475 @@
+#include "image_io.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include <zlib.h>
+
+#include "parallel.h"
+#include "profiling.h"
+
+namespace
+{
+	constexpr std::array<vl::byte, 4> TiledMagic{'V', 'L', 'T', 'I'};
+	constexpr std::uint16_t TiledVersion{1};
+	constexpr std::size_t HeaderSize{24};
+	constexpr std::size_t LevelEntrySize{24};
+	constexpr std::size_t TileEntrySize{16};
+	constexpr std::size_t MaxDimension{1 << 24};
+	constexpr std::size_t MaxDeflateRatio{1032};
+
+	enum class Codec : std::uint32_t
+	{
+		Stored = 0,
+		Deflate = 1
+	};
+
+	struct TileEntry
+	{
+		std::uint64_t offset;
+		std::uint32_t size;
+		Codec codec;
+	};
+
+	struct Level
+	{
+		std::size_t width;
+		std::size_t height;
+		std::vector<TileEntry> tiles;
+	};
+
+	void put_u16(std::vector<vl::byte> &bytes, std::uint16_t value)
+	{
+		for (std::size_t i = 0; i < sizeof(value); ++i)
+			bytes.push_back(value >> (i * 8));
+	}
+
+	void put_u32(std::vector<vl::byte> &bytes, std::uint32_t value)
+	{
+		for (std::size_t i = 0; i < sizeof(value); ++i)
+			bytes.push_back(value >> (i * 8));
+	}
+
+	void put_u64(std::vector<vl::byte> &bytes, std::uint64_t value)
+	{
+		for (std::size_t i = 0; i < sizeof(value); ++i)
+			bytes.push_back(value >> (i * 8));
+	}
+
+	template<typename T>
+	T get_le(const vl::byte *bytes)
+	{
+		T value{0};
+		for (std::size_t i = 0; i < sizeof(T); ++i)
+			value |= static_cast<T>(bytes[i]) << (i * 8);
+		return value;
+	}
+
+	struct FileDescriptor
+	{
+		int fd{-1};
+
+		FileDescriptor(int _fd=-1)
+			: fd{_fd}
+		{
+		}
+
+		FileDescriptor(FileDescriptor &&other)
+			: fd{std::exchange(other.fd, -1)}
+		{
+		}
+
+		~FileDescriptor()
+		{
+			if (fd >= 0)
+				close(fd);
+		}
+	};
+
+	bool read_exact(int fd, vl::byte *data, std::size_t size, std::size_t offset)
+	{
+		while (size > 0)
+		{
+			const ssize_t readBytes{pread(fd, data, size, offset)};
+			if (readBytes < 0 && errno == EINTR)
+				continue;
+			if (readBytes <= 0)
+				return false;
+
+			data += readBytes;
+			size -= readBytes;
+			offset += readBytes;
+		}
+		return true;
+	}
+
+	class TiledFile
+	{
+	public:
+		static std::expected<TiledFile, vl::ImageIO::ReadError> open(const std::string &path)
+		{
+			TiledFile file{path};
+			file.m_file.fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (file.m_file.fd < 0)
+				return file.io_error();
+
+			struct stat info{};
+			if (fstat(file.m_file.fd, &info) != 0)
+				return file.io_error();
+			const std::size_t fileSize = info.st_size;
+
+			std::array<vl::byte, HeaderSize> header{};
+			if (!read_exact(file.m_file.fd, header.data(), header.size(), 0))
+				return file.format_error("This is not a tiled file(end of file reached unexpectedly)");
+			if (!std::equal(TiledMagic.begin(), TiledMagic.end(), header.begin()))
+				return file.format_error("This is not a tiled file(header check)");
+			if (get_le<std::uint16_t>(&header[4]) != TiledVersion)
+				return file.format_error(fmt::format("Unsupported tiled file version {}", get_le<std::uint16_t>(&header[4])));
+
+			file.m_format = static_cast<vl::PixelFormat>(get_le<std::uint16_t>(&header[6]));
+			file.m_tileWidth = get_le<std::uint32_t>(&header[8]);
+			file.m_tileHeight = get_le<std::uint32_t>(&header[12]);
+			const std::size_t levelCount{get_le<std::uint32_t>(&header[16])};
+			const std::size_t pixelSize{vl::to_pixel_size(file.m_format)};
+			if (pixelSize == 0 || file.m_tileWidth == 0 || file.m_tileHeight == 0
+				|| file.m_tileWidth > MaxDimension || file.m_tileHeight > MaxDimension || levelCount == 0)
+				return file.format_error("Corrupted tiled file header");
+			if (levelCount > (fileSize - HeaderSize) / LevelEntrySize)
+				return file.format_error("Corrupted level table");
+
+			std::vector<vl::byte> levelTable(levelCount * LevelEntrySize);
+			if (!read_exact(file.m_file.fd, levelTable.data(), levelTable.size(), HeaderSize))
+				return file.format_error("Corrupted level table");
+
+			for (std::size_t level = 0; level < levelCount; ++level)
+			{
+				const vl::byte *entry{&levelTable[level * LevelEntrySize]};
+				Level &readLevel{file.m_levels.emplace_back()};
+				readLevel.width = get_le<std::uint64_t>(entry);
+				readLevel.height = get_le<std::uint64_t>(entry + 8);
+				if (readLevel.width > MaxDimension || readLevel.height > MaxDimension)
+				{
+					return file.format_error(fmt::format("Corrupted level {} size {}x{}",
+						level, readLevel.width, readLevel.height));
+				}
+
+				const std::size_t tilesX{file.tiles_x(readLevel)};
+				const std::size_t tilesCount{tilesX * file.tiles_y(readLevel)};
+				const std::size_t indexOffset{get_le<std::uint64_t>(entry + 16)};
+				if (indexOffset > fileSize || tilesCount > (fileSize - indexOffset) / TileEntrySize)
+					return file.format_error("Corrupted tile index");
+
+				std::vector<vl::byte> index(tilesCount * TileEntrySize);
+				if (!read_exact(file.m_file.fd, index.data(), index.size(), indexOffset))
+					return file.format_error("Corrupted tile index");
+
+				readLevel.tiles.resize(tilesCount);
+				for (std::size_t tile = 0; tile < tilesCount; ++tile)
+				{
+					const vl::byte *tileEntry{&index[tile * TileEntrySize]};
+					readLevel.tiles[tile] = {get_le<std::uint64_t>(tileEntry),
+						get_le<std::uint32_t>(tileEntry + 8),
+						static_cast<Codec>(get_le<std::uint32_t>(tileEntry + 12))
+					};
+
+					const TileEntry &readTile{readLevel.tiles[tile]};
+					const std::size_t tileLeft{(tile % tilesX) * file.m_tileWidth};
+					const std::size_t tileTop{(tile / tilesX) * file.m_tileHeight};
+					const std::size_t rawSize{std::min(file.m_tileWidth, readLevel.width - tileLeft)
+						* std::min(file.m_tileHeight, readLevel.height - tileTop) * pixelSize};
+					if (readTile.offset > fileSize || readTile.size > fileSize - readTile.offset
+						|| (readTile.codec == Codec::Stored && readTile.size != rawSize)
+						|| (readTile.codec == Codec::Deflate && rawSize > readTile.size * MaxDeflateRatio))
+					{
+						return file.format_error(fmt::format("Corrupted tile {} entry in level {}", tile, level));
+					}
+				}
+			}
+
+			return file;
+		}
+
+		const Level &level(std::size_t index=0) const
+		{
+			return m_levels[index];
+		}
+
+		std::expected<vl::Image, vl::ImageIO::ReadError> read_region(std::size_t x, std::size_t y,
+			std::size_t width, std::size_t height, std::size_t levelIndex=0) const
+		{
+			const Level &level{m_levels[levelIndex]};
+			if (width == 0 || height == 0 || x > level.width || width > level.width - x
+				|| y > level.height || height > level.height - y)
+			{
+				return format_error(fmt::format("Region {}x{}+{}+{} is out of image bounds {}x{}",
+					width, height, x, y, level.width, level.height));
+			}
+
+			const std::size_t pixelSize{vl::to_pixel_size(m_format)};
+			std::vector<vl::byte> bytes(width * height * pixelSize);
+			VL_PROFILE_ALLOCATION(bytes.size());
+
+			const std::size_t firstTileX{x / m_tileWidth};
+			const std::size_t firstTileY{y / m_tileHeight};
+			const std::size_t lastTileX{(x + width - 1) / m_tileWidth};
+			const std::size_t lastTileY{(y + height - 1) / m_tileHeight};
+			const std::size_t regionTilesX{lastTileX - firstTileX + 1};
+			const std::size_t regionTilesCount{regionTilesX * (lastTileY - firstTileY + 1)};
+
+			std::vector<std::optional<vl::ImageIO::ReadError>> errors(regionTilesCount);
+			vl::parallel::for_each(0, regionTilesCount, [&](std::size_t regionTile)
+			{
+				const std::size_t tileX{firstTileX + regionTile % regionTilesX};
+				const std::size_t tileY{firstTileY + regionTile / regionTilesX};
+				const std::size_t tileLeft{tileX * m_tileWidth};
+				const std::size_t tileTop{tileY * m_tileHeight};
+				const std::size_t tileWidth{std::min(m_tileWidth, level.width - tileLeft)};
+				const std::size_t tileHeight{std::min(m_tileHeight, level.height - tileTop)};
+
+				std::vector<vl::byte> tile;
+				if (auto error{read_tile(level.tiles[tileY * tiles_x(level) + tileX],
+					tileWidth * tileHeight * pixelSize, tile)})
+				{
+					errors[regionTile] = std::move(error);
+					return;
+				}
+
+				const std::size_t left{std::max(x, tileLeft)};
+				const std::size_t right{std::min(x + width, tileLeft + tileWidth)};
+				const std::size_t top{std::max(y, tileTop)};
+				const std::size_t bottom{std::min(y + height, tileTop + tileHeight)};
+				for (std::size_t row = top; row < bottom; ++row)
+				{
+					std::memcpy(&bytes[((row - y) * width + left - x) * pixelSize],
+						&tile[((row - tileTop) * tileWidth + left - tileLeft) * pixelSize],
+						(right - left) * pixelSize);
+				}
+			});
+
+			for (auto &error : errors)
+				if (error)
+					return std::unexpected{std::move(*error)};
+
+			return vl::Image{std::move(bytes), width, height, m_format};
+		}
+
+	private:
+		explicit TiledFile(const std::string &path)
+			: m_path{path}
+		{
+		}
+
+		std::size_t tiles_x(const Level &level) const
+		{
+			return (level.width + m_tileWidth - 1) / m_tileWidth;
+		}
+
+		std::size_t tiles_y(const Level &level) const
+		{
+			return (level.height + m_tileHeight - 1) / m_tileHeight;
+		}
+
+		std::unexpected<vl::ImageIO::ReadError> io_error() const
+		{
+			return std::unexpected<vl::ImageIO::ReadError>({vl::ImageIO::ErrorType::IOError,
+				fmt::format("Failed to read {}: {}", m_path, std::strerror(errno))
+			});
+		}
+
+		std::unexpected<vl::ImageIO::ReadError> format_error(const std::string &description) const
+		{
+			return std::unexpected<vl::ImageIO::ReadError>({vl::ImageIO::ErrorType::FormatError,
+				fmt::format("Failed to read {}: {}", m_path, description)
+			});
+		}
+
+		std::optional<vl::ImageIO::ReadError> read_tile(const TileEntry &entry, std::size_t rawSize,
+			std::vector<vl::byte> &tile) const
+		{
+			std::vector<vl::byte> stored(entry.size);
+			if (!read_exact(m_file.fd, stored.data(), stored.size(), entry.offset))
+				return format_error("Tile data is truncated").error();
+
+			if (entry.codec == Codec::Stored)
+			{
+				if (stored.size() != rawSize)
+					return format_error("Stored tile has wrong size").error();
+				tile = std::move(stored);
+				return {};
+			}
+			if (entry.codec != Codec::Deflate)
+				return format_error(fmt::format("Unknown tile codec {}", static_cast<std::uint32_t>(entry.codec))).error();
+
+			tile.resize(rawSize);
+			uLongf decompressedSize{rawSize};
+			if (uncompress(tile.data(), &decompressedSize, stored.data(), stored.size()) != Z_OK
+				|| decompressedSize != rawSize)
+				return format_error("Failed to decompress tile").error();
+
+			return {};
+		}
+
+		std::string m_path;
+		FileDescriptor m_file;
+		vl::PixelFormat m_format{vl::PixelFormat::Grayscale8};
+		std::size_t m_tileWidth{0};
+		std::size_t m_tileHeight{0};
+		std::vector<Level> m_levels;
+	};
+}
+
+namespace vl::ImageIO
+{
+	std::expected<vl::Image, ReadError> read_tiled(const std::string &path)
+	{
+		VL_PROFILE_SCOPE("ImageIO::read_tiled", 0);
+
+		const auto file{TiledFile::open(path)};
+		if (!file)
+			return std::unexpected{file.error()};
+
+		VL_PROFILE_PIXELS(file->level().width * file->level().height);
+		return file->read_region(0, 0, file->level().width, file->level().height);
+	}
+
+	std::expected<vl::Image, ReadError> read_region(const std::string &path,
+		std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+	{
+		VL_PROFILE_SCOPE("ImageIO::read_region", width * height);
+
+		const auto file{TiledFile::open(path)};
+		if (!file)
+			return std::unexpected{file.error()};
+
+		return file->read_region(x, y, width, height);
+	}
+
+	std::expected<void, WriteError> write_tiled(const vl::Image &image, const std::string &path,
+		const TiledOptions &options)
+	{
+		VL_PROFILE_SCOPE("ImageIO::write_tiled", image.width() * image.height());
+
+		if (options.tileWidth == 0 || options.tileHeight == 0
+			|| options.tileWidth > MaxDimension || options.tileHeight > MaxDimension)
+		{
+			return std::unexpected<WriteError>({ErrorType::FormatError,
+				fmt::format("Failed writing to {}: Invalid tile size {}x{}", path, options.tileWidth, options.tileHeight)
+			});
+		}
+
+		if (image.width() > MaxDimension || image.height() > MaxDimension)
+		{
+			return std::unexpected<WriteError>({ErrorType::FormatError,
+				fmt::format("Failed writing to {}: Unsupported image size {}x{}", path, image.width(), image.height())
+			});
+		}
+
+		const std::size_t pixelSize{to_pixel_size(image.format())};
+		const std::size_t tileBytes{std::min(options.tileWidth, image.width())
+			* std::min(options.tileHeight, image.height()) * pixelSize};
+		if (tileBytes > std::numeric_limits<std::uint32_t>::max())
+		{
+			return std::unexpected<WriteError>({ErrorType::FormatError,
+				fmt::format("Failed writing to {}: Tile of {}x{} pixels exceeds 4 GiB", path, options.tileWidth, options.tileHeight)
+			});
+		}
+
+		const std::size_t tilesX{(image.width() + options.tileWidth - 1) / options.tileWidth};
+		const std::size_t tilesY{(image.height() + options.tileHeight - 1) / options.tileHeight};
+
+		std::vector<std::vector<byte>> tiles(tilesX * tilesY);
+		std::vector<Codec> codecs(tiles.size(), Codec::Deflate);
+		vl::parallel::for_each(0, tiles.size(), [&](std::size_t tile)
+		{
+			const std::size_t tileLeft{(tile % tilesX) * options.tileWidth};
+			const std::size_t tileTop{(tile / tilesX) * options.tileHeight};
+			const std::size_t tileWidth{std::min(options.tileWidth, image.width() - tileLeft)};
+			const std::size_t tileHeight{std::min(options.tileHeight, image.height() - tileTop)};
+			const std::size_t rowSize{tileWidth * pixelSize};
+
+			std::vector<byte> raw(rowSize * tileHeight);
+			for (std::size_t row = 0; row < tileHeight; ++row)
+				std::memcpy(&raw[row * rowSize],
+					image.begin() + ((tileTop + row) * image.width() + tileLeft) * pixelSize, rowSize);
+
+			std::vector<byte> compressed(compressBound(raw.size()));
+			uLongf compressedSize{compressed.size()};
+			if (compress2(compressed.data(), &compressedSize, raw.data(), raw.size(), options.compressionLevel) == Z_OK
+				&& compressedSize < raw.size())
+			{
+				compressed.resize(compressedSize);
+				tiles[tile] = std::move(compressed);
+			}
+			else
+			{
+				tiles[tile] = std::move(raw);
+				codecs[tile] = Codec::Stored;
+			}
+		});
+
+		std::vector<byte> header;
+		header.insert(header.end(), TiledMagic.begin(), TiledMagic.end());
+		put_u16(header, TiledVersion);
+		put_u16(header, static_cast<std::uint16_t>(image.format()));
+		put_u32(header, options.tileWidth);
+		put_u32(header, options.tileHeight);
+		put_u32(header, 1);
+		put_u32(header, 0);
+
+		const std::size_t indexOffset{HeaderSize + LevelEntrySize};
+		put_u64(header, image.width());
+		put_u64(header, image.height());
+		put_u64(header, indexOffset);
+
+		std::uint64_t offset{indexOffset + tiles.size() * TileEntrySize};
+		for (std::size_t tile = 0; tile < tiles.size(); ++tile)
+		{
+			put_u64(header, offset);
+			put_u32(header, tiles[tile].size());
+			put_u32(header, static_cast<std::uint32_t>(codecs[tile]));
+			offset += tiles[tile].size();
+		}
+
+		FileDescriptor file{::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)};
+		if (file.fd < 0)
+		{
+			return std::unexpected<WriteError>({ErrorType::IOError,
+				fmt::format("Failed writing to {}: {}", path, std::strerror(errno))
+			});
+		}
+
+		const auto writeAll{[&](const std::vector<byte> &bytes)
+		{
+			std::size_t written{0};
+			while (written < bytes.size())
+			{
+				const ssize_t writtenBytes{::write(file.fd, bytes.data() + written, bytes.size() - written)};
+				if (writtenBytes < 0 && errno == EINTR)
+					continue;
+				if (writtenBytes < 0)
+					return false;
+				written += writtenBytes;
+			}
+			return true;
+		}};
+
+		if (!writeAll(header) || !std::ranges::all_of(tiles, writeAll) || close(std::exchange(file.fd, -1)) != 0)
+		{
+			return std::unexpected<WriteError>({ErrorType::IOError,
+				fmt::format("Failed writing to {}: {}", path, std::strerror(errno))
+			});
+		}
+
+		return {};
+	}
+}
@@ -0,0 +1,281 @@
+#include "transform.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <fmt/format.h>
+
+#include "kernels.h"
+#include "parallel.h"
+#include "profiling.h"
+
+namespace
+{
+	using vl::transform::Interpolation;
+
+	constexpr std::size_t TileRows{32};
+	constexpr std::size_t TileColumns{256};
+
+	inline float cubic_weight(float distance)
+	{
+		constexpr float a{-0.5f};
+		distance = std::abs(distance);
+		if (distance <= 1.f)
+			return ((a + 2.f) * distance - (a + 3.f)) * distance * distance + 1.f;
+		if (distance < 2.f)
+			return ((a * distance - 5.f * a) * distance + 8.f * a) * distance - 4.f * a;
+		return 0.f;
+	}
+
+	inline vl::byte to_byte(float value)
+	{
+		return std::clamp(value + 0.5f, 0.f, 255.f);
+	}
+
+	template<Interpolation Method>
+	void sample_pixel(const vl::Image &source, float x, float y, vl::byte *output, std::size_t channels)
+	{
+		const long width = source.width();
+		const long height = source.height();
+		const std::size_t stride{source.width() * channels};
+		const vl::byte *pixels{source.begin()};
+
+		if (!(x >= -0.5f && x <= width - 0.5f && y >= -0.5f && y <= height - 0.5f))
+		{
+			std::fill_n(output, channels, 0);
+			return;
+		}
+
+		if constexpr (Method == Interpolation::Nearest)
+		{
+			const long column{std::clamp<long>(std::lround(x), 0, width - 1)};
+			const long row{std::clamp<long>(std::lround(y), 0, height - 1)};
+			std::copy_n(pixels + row * stride + column * channels, channels, output);
+		}
+		else if constexpr (Method == Interpolation::Bilinear)
+		{
+			const float left{std::floor(x)};
+			const float top{std::floor(y)};
+			const float xFraction{x - left};
+			const float yFraction{y - top};
+			const long x0{std::clamp<long>(left, 0, width - 1)};
+			const long x1{std::clamp<long>(left + 1, 0, width - 1)};
+			const vl::byte *row0{pixels + std::clamp<long>(top, 0, height - 1) * stride};
+			const vl::byte *row1{pixels + std::clamp<long>(top + 1, 0, height - 1) * stride};
+			for (std::size_t channel = 0; channel < channels; ++channel)
+			{
+				const float upper{row0[x0 * channels + channel]
+					+ (row0[x1 * channels + channel] - row0[x0 * channels + channel]) * xFraction};
+				const float lower{row1[x0 * channels + channel]
+					+ (row1[x1 * channels + channel] - row1[x0 * channels + channel]) * xFraction};
+				output[channel] = to_byte(upper + (lower - upper) * yFraction);
+			}
+		}
+		else
+		{
+			const float left{std::floor(x)};
+			const float top{std::floor(y)};
+			std::array<float, 4> xWeights;
+			std::array<float, 4> yWeights;
+			std::array<long, 4> columns;
+			std::array<const vl::byte *, 4> rows;
+			for (int k = 0; k < 4; ++k)
+			{
+				xWeights[k] = cubic_weight(x - (left + k - 1));
+				yWeights[k] = cubic_weight(y - (top + k - 1));
+				columns[k] = std::clamp<long>(left + k - 1, 0, width - 1) * channels;
+				rows[k] = pixels + std::clamp<long>(top + k - 1, 0, height - 1) * stride;
+			}
+
+			for (std::size_t channel = 0; channel < channels; ++channel)
+			{
+				float value{0};
+				for (int row = 0; row < 4; ++row)
+				{
+					float rowValue{0};
+					for (int column = 0; column < 4; ++column)
+						rowValue += xWeights[column] * rows[row][columns[column] + channel];
+					value += yWeights[row] * rowValue;
+				}
+				output[channel] = to_byte(value);
+			}
+		}
+	}
+
+	template<Interpolation Method>
+	void sample_row(const vl::Image &source, const float *xs, const float *ys,
+		vl::byte *destination, std::size_t count, std::size_t channels)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if constexpr (Method == Interpolation::Bilinear)
+			{
+				if (channels == 1)
+				{
+					i += vl::kernels::table().sample_bilinear_row(source.begin(), source.width(), source.height(),
+						xs + i, ys + i, destination + i, count - i);
+					if (i == count)
+						break;
+				}
+			}
+			sample_pixel<Method>(source, xs[i], ys[i], destination + i * channels, channels);
+		}
+	}
+}
+
+namespace vl::transform
+{
+	std::optional<Interpolation> to_interpolation(const std::string &interpolationString)
+	{
+		std::string interpolationLowCase{interpolationString};
+		std::transform(begin(interpolationLowCase), end(interpolationLowCase),
+			begin(interpolationLowCase), tolower);
+
+		if (interpolationLowCase == "nearest")
+			return Interpolation::Nearest;
+		else if (interpolationLowCase == "bilinear")
+			return Interpolation::Bilinear;
+		else if (interpolationLowCase == "bicubic")
+			return Interpolation::Bicubic;
+
+		return {};
+	}
+
+	AffineTransform::AffineTransform()
+		: m_matrix(2, 3)
+	{
+		m_matrix[0, 0] = 1;
+		m_matrix[1, 1] = 1;
+	}
+
+	AffineTransform::AffineTransform(const math::Matrix<double> &matrix)
+		: m_matrix{matrix}
+	{
+	}
+
+	std::optional<AffineTransform> AffineTransform::from_points(const std::array<Point, 3> &source,
+		const std::array<Point, 3> &destination)
+	{
+		math::Matrix<double> coefficients(3);
+		math::Matrix<double> constants(3, 2);
+		for (std::size_t i = 0; i < source.size(); ++i)
+		{
+			coefficients[i, 0] = source[i].x;
+			coefficients[i, 1] = source[i].y;
+			coefficients[i, 2] = 1;
+			constants[i, 0] = destination[i].x;
+			constants[i, 1] = destination[i].y;
+		}
+
+		const auto solution{math::solve(coefficients, constants)};
+		if (!solution)
+			return {};
+
+		math::Matrix<double> matrix(2, 3);
+		for (std::size_t row = 0; row < 2; ++row)
+			for (std::size_t col = 0; col < 3; ++col)
+				matrix[row, col] = (*solution)[col, row];
+
+		return AffineTransform{matrix};
+	}
+
+	AffineTransform AffineTransform::scale(double xScale, double yScale)
+	{
+		math::Matrix<double> matrix(2, 3);
+		matrix[0, 0] = xScale;
+		matrix[0, 2] = (xScale - 1) / 2;
+		matrix[1, 1] = yScale;
+		matrix[1, 2] = (yScale - 1) / 2;
+
+		return AffineTransform{matrix};
+	}
+
+	std::optional<AffineTransform> AffineTransform::inverse() const
+	{
+		const double determinant{m_matrix[0, 0] * m_matrix[1, 1] - m_matrix[0, 1] * m_matrix[1, 0]};
+		if (std::abs(determinant) < 1e-12)
+			return {};
+
+		math::Matrix<double> matrix(2, 3);
+		matrix[0, 0] = m_matrix[1, 1] / determinant;
+		matrix[0, 1] = -m_matrix[0, 1] / determinant;
+		matrix[1, 0] = -m_matrix[1, 0] / determinant;
+		matrix[1, 1] = m_matrix[0, 0] / determinant;
+		matrix[0, 2] = -(matrix[0, 0] * m_matrix[0, 2] + matrix[0, 1] * m_matrix[1, 2]);
+		matrix[1, 2] = -(matrix[1, 0] * m_matrix[0, 2] + matrix[1, 1] * m_matrix[1, 2]);
+
+		return AffineTransform{matrix};
+	}
+
+	vl::Image warp_affine(const Image &image, const AffineTransform &transform,
+		std::size_t width, std::size_t height, Interpolation interpolation)
+	{
+		VL_PROFILE_SCOPE("transform::warp_affine", width * height);
+
+		vl::Image warped{width, height, image.format()};
+		if (image.format() == PixelFormat::Grayscale16)
+		{
+			fmt::println("Unsupported image format");
+			return warped;
+		}
+
+		const auto inverse{transform.inverse()};
+		if (!inverse)
+		{
+			fmt::println("Affine transform is not invertible");
+			return warped;
+		}
+
+		const auto &matrix{inverse->matrix()};
+		const std::size_t channels{image.pixel_size()};
+		const std::size_t tilesX{(width + TileColumns - 1) / TileColumns};
+		const std::size_t tilesY{(height + TileRows - 1) / TileRows};
+		vl::parallel::for_each(0, tilesX * tilesY, [&](std::size_t tile)
+		{
+			const std::size_t firstColumn{(tile % tilesX) * TileColumns};
+			const std::size_t columns{std::min(TileColumns, width - firstColumn)};
+			const std::size_t firstRow{(tile / tilesX) * TileRows};
+			const std::size_t lastRow{std::min(firstRow + TileRows, height)};
+
+			std::array<float, TileColumns> xs;
+			std::array<float, TileColumns> ys;
+			for (std::size_t y = firstRow; y < lastRow; ++y)
+			{
+				const double rowX{matrix[0, 1] * y + matrix[0, 2] + matrix[0, 0] * firstColumn};
+				const double rowY{matrix[1, 1] * y + matrix[1, 2] + matrix[1, 0] * firstColumn};
+				const float xStep = matrix[0, 0];
+				const float yStep = matrix[1, 0];
+				for (std::size_t i = 0; i < columns; ++i)
+				{
+					xs[i] = rowX + xStep * i;
+					ys[i] = rowY + yStep * i;
+				}
+
+				vl::byte *destination{warped.row(y) + firstColumn * channels};
+				switch (interpolation)
+				{
+					case Interpolation::Nearest:
+						sample_row<Interpolation::Nearest>(image, xs.data(), ys.data(), destination, columns, channels);
+						break;
+					case Interpolation::Bilinear:
+						sample_row<Interpolation::Bilinear>(image, xs.data(), ys.data(), destination, columns, channels);
+						break;
+					case Interpolation::Bicubic:
+						sample_row<Interpolation::Bicubic>(image, xs.data(), ys.data(), destination, columns, channels);
+						break;
+				}
+			}
+		});
+
+		return warped;
+	}
+
+	vl::Image resize(const Image &image, std::size_t width, std::size_t height, Interpolation interpolation)
+	{
+		if (image.width() == 0 || image.height() == 0)
+			return vl::Image{width, height, image.format()};
+
+		const auto scale{AffineTransform::scale((double)width / image.width(), (double)height / image.height())};
+		return warp_affine(image, scale, width, height, interpolation);
+	}
+}